@@ -0,0 +1,14 @@
+TARGET = glyphcompiler
+
+CONFIG += qt console release
+CONFIG -= app_bundle
+QT += core widgets gui svg
+
+INCLUDEPATH += ../src/
+
+HEADERS += ../src/debug.h
+HEADERS += ../src/stitchglyph.h
+
+SOURCES += ../src/debug.cpp
+SOURCES += ../src/glyphcompiler/main.cpp
+SOURCES += ../src/stitchglyph.cpp
@@ -27,15 +27,24 @@ UI_DIR = $$DESTDIR/
 INCLUDEPATH += ../src/
 
 RESOURCES += ../crochet.qrc
+RESOURCES += ../stitches/stitches.qrc
 
 HEADERS += ../src/aligndock.h
 HEADERS += ../src/appinfo.h
 HEADERS += ../src/application.h
+HEADERS += ../src/builtinglyphs.h
 HEADERS += ../src/cell.h
+HEADERS += ../src/cellindex.h
+HEADERS += ../src/ChartImage.h
+HEADERS += ../src/ChartItemTools.h
 HEADERS += ../src/chartLayer.h
+HEADERS += ../src/chartlayout.h
+HEADERS += ../src/chartpreview.h
 HEADERS += ../src/chartview.h
+HEADERS += ../src/clipboarddata.h
 HEADERS += ../src/colorlabel.h
 HEADERS += ../src/colorlistwidget.h
+HEADERS += ../src/colorpalette.h
 HEADERS += ../src/colorreplacer.h
 HEADERS += ../src/crochetchartcommands.h
 HEADERS += ../src/crochettab.h
@@ -46,12 +55,12 @@ HEADERS += ../src/file.h
 HEADERS += ../src/file_v1.h
 HEADERS += ../src/file_v2.h
 HEADERS += ../src/filefactory.h
-HEADERS += ../src/guideline.h
 HEADERS += ../src/indicator.h
 HEADERS += ../src/indicatorundo.h
 HEADERS += ../src/itemgroup.h
 HEADERS += ../src/legends.h
 HEADERS += ../src/mainwindow.h
+HEADERS += ../src/minimapdock.h
 HEADERS += ../src/mirrordock.h
 HEADERS += ../src/propertiesdata.h
 HEADERS += ../src/propertiesdock.h
@@ -59,10 +68,14 @@ HEADERS += ../src/resizeui.h
 HEADERS += ../src/roweditdialog.h
 HEADERS += ../src/rowsdock.h
 HEADERS += ../src/scene.h
+HEADERS += ../src/selectionband.h
 HEADERS += ../src/settings.h
 HEADERS += ../src/settingsui.h
+HEADERS += ../src/snapengine.h
+HEADERS += ../src/spatialindex.h
 HEADERS += ../src/splashscreen.h
 HEADERS += ../src/stitch.h
+HEADERS += ../src/stitchglyph.h
 HEADERS += ../src/stitchiconui.h
 HEADERS += ../src/stitchlibrary.h
 HEADERS += ../src/stitchlibrarydelegate.h
@@ -73,6 +86,7 @@ HEADERS += ../src/stitchset.h
 HEADERS += ../src/tabinterface.h
 HEADERS += ../src/textview.h
 HEADERS += ../src/undogroup.h
+HEADERS += ../src/undomemory.h
 HEADERS += ../src/updatefunctions.h
 HEADERS += ../src/updater.h
 HEADERS += ../src/version.h
@@ -80,11 +94,19 @@ HEADERS += ../src/version.h
 SOURCES += ../src/aligndock.cpp
 SOURCES += ../src/appinfo.cpp
 SOURCES += ../src/application.cpp
+SOURCES += ../src/builtinglyphs.cpp
 SOURCES += ../src/cell.cpp
+SOURCES += ../src/cellindex.cpp
+SOURCES += ../src/ChartImage.cpp
+SOURCES += ../src/ChartItemTools.cpp
 SOURCES += ../src/chartLayer.cpp
+SOURCES += ../src/chartlayout.cpp
+SOURCES += ../src/chartpreview.cpp
 SOURCES += ../src/chartview.cpp
+SOURCES += ../src/clipboarddata.cpp
 SOURCES += ../src/colorlabel.cpp
 SOURCES += ../src/colorlistwidget.cpp
+SOURCES += ../src/colorpalette.cpp
 SOURCES += ../src/colorreplacer.cpp
 SOURCES += ../src/crochetchartcommands.cpp
 SOURCES += ../src/crochettab.cpp
@@ -94,13 +116,13 @@ SOURCES += ../src/file.cpp
 SOURCES += ../src/file_v1.cpp
 SOURCES += ../src/file_v2.cpp
 SOURCES += ../src/filefactory.cpp
-SOURCES += ../src/guideline.cpp
 SOURCES += ../src/indicator.cpp
 SOURCES += ../src/indicatorundo.cpp
 SOURCES += ../src/itemgroup.cpp
 SOURCES += ../src/legends.cpp
 SOURCES += ../src/main.cpp
 SOURCES += ../src/mainwindow.cpp
+SOURCES += ../src/minimapdock.cpp
 SOURCES += ../src/mirrordock.cpp
 SOURCES += ../src/propertiesdata.cpp
 SOURCES += ../src/propertiesdock.cpp
@@ -108,10 +130,14 @@ SOURCES += ../src/resizeui.cpp
 SOURCES += ../src/roweditdialog.cpp
 SOURCES += ../src/rowsdock.cpp
 SOURCES += ../src/scene.cpp
+SOURCES += ../src/selectionband.cpp
 SOURCES += ../src/settings.cpp
 SOURCES += ../src/settingsui.cpp
+SOURCES += ../src/snapengine.cpp
+SOURCES += ../src/spatialindex.cpp
 SOURCES += ../src/splashscreen.cpp
 SOURCES += ../src/stitch.cpp
+SOURCES += ../src/stitchglyph.cpp
 SOURCES += ../src/stitchiconui.cpp
 SOURCES += ../src/stitchlibrary.cpp
 SOURCES += ../src/stitchlibrarydelegate.cpp
@@ -121,6 +147,7 @@ SOURCES += ../src/stitchreplacerui.cpp
 SOURCES += ../src/stitchset.cpp
 SOURCES += ../src/textview.cpp
 SOURCES += ../src/undogroup.cpp
+SOURCES += ../src/undomemory.cpp
 SOURCES += ../src/updater.cpp
 
 FORMS += ../src/aligndock.ui
@@ -137,3 +164,20 @@ FORMS += ../src/settings.ui
 FORMS += ../src/stitchicon.ui
 FORMS += ../src/stitchlibrary.ui
 FORMS += ../src/stitchreplacerui.ui
+
+#compile the built in stitches into glyph tables so they aren't parsed at startup.
+GLYPH_COMPILER = $$DESTDIR/glyphcompiler/glyphcompiler
+win32:GLYPH_COMPILER = $${GLYPH_COMPILER}.exe
+GLYPH_SVGS = $$files(../stitches/*.svg)
+
+glyphcompiler.target = $$GLYPH_COMPILER
+glyphcompiler.commands = $(MKDIR) $$DESTDIR/glyphcompiler && cd $$DESTDIR/glyphcompiler && $(QMAKE) $$PWD/glyphcompiler.pro && $(MAKE)
+QMAKE_EXTRA_TARGETS += glyphcompiler
+
+builtinglyphs.input = GLYPH_SVGS
+builtinglyphs.output = $$DESTDIR/builtinglyphs_data.cpp
+builtinglyphs.commands = $$GLYPH_COMPILER ${QMAKE_FILE_OUT} ${QMAKE_FILE_IN}
+builtinglyphs.depends = $$GLYPH_COMPILER
+builtinglyphs.CONFIG += combine
+builtinglyphs.variable_out = SOURCES
+QMAKE_EXTRA_COMPILERS += builtinglyphs
@@ -1,6 +1,7 @@
 #include "ChartImage.h"
 #include "debug.h"
 #include "ChartItemTools.h"
+#include "scene.h"
 #include <QMessageBox>
 
 ChartImage::ChartImage(const QString& filename, QGraphicsItem* parent):
@@ -21,6 +22,7 @@ ChartImage::ChartImage(const QString& filename, QGraphicsItem* parent):
 	
     setFlag(QGraphicsItem::ItemIsMovable);
     setFlag(QGraphicsItem::ItemIsSelectable);
+    setFlag(QGraphicsItem::ItemSendsGeometryChanges);
 }
 
 ChartImage::ChartImage(QDataStream& stream, QGraphicsItem* parent):
@@ -34,13 +36,27 @@ ChartImage::ChartImage(QDataStream& stream, QGraphicsItem* parent):
 	
     setFlag(QGraphicsItem::ItemIsMovable);
     setFlag(QGraphicsItem::ItemIsSelectable);
+    setFlag(QGraphicsItem::ItemSendsGeometryChanges);
 }
 
 ChartImage::~ChartImage()
 {
+	Scene::trackItemChange(this, QGraphicsItem::ItemSceneChange, QVariant());
 	delete mPixmap;
 }
 
+QVariant ChartImage::itemChange(GraphicsItemChange change, const QVariant& value)
+{
+	Scene::trackItemChange(this, change, value);
+	return QGraphicsObject::itemChange(change, value);
+}
+
+void ChartImage::setLayer(unsigned int layer)
+{
+	mLayer = layer;
+	Scene::trackLayerChange(this);
+}
+
 QRectF ChartImage::boundingRect() const
 {
 	
@@ -55,6 +71,8 @@ QRectF ChartImage::boundingRect() const
 
 void ChartImage::paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget)
 {
+	if (Scene::isDrawnFromLayerCache(this, mLayer, widget))
+		return;
 	if (mPixmap) {
 		painter->drawPixmap(option->rect.x(), option->rect.y(), *mPixmap);
 	}
@@ -76,9 +94,11 @@ void ChartImage::setFile(const QString& filename)
 	}
 	
 	//otherwise, delete the old pixmap and replace it
+	prepareGeometryChange();
 	delete mPixmap;
 	mPixmap = newPixmap;
 	mFilename = filename;
+	Scene::trackGeometryChange(this);
 }
 
 void ChartImage::setZLayer(const QString& zlayer)
@@ -93,4 +113,5 @@ void ChartImage::setZLayer(const QString& zlayer)
 		WARN("Unknown z value: ");
 		WARN(mZLayer);
 	}
+	Scene::trackPaintChange(this);
 }
\ No newline at end of file
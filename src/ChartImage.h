@@ -6,6 +6,7 @@
 #include <QPainter>
 #include <QStyleOptionGraphicsItem>
 #include <QDataStream>
+#include "ChartItemTools.h"
 
 class ChartImage : public QGraphicsObject
 {
@@ -24,19 +25,28 @@ public:
 	const QPixmap* pixmap() const { return mPixmap; } 
 	
 	unsigned int layer() const { return mLayer; }
-	void setLayer(unsigned int layer) { mLayer = layer; }
+	void setLayer(unsigned int layer);
 	
 	const QString& filename() const { return mFilename; }
 	void setFile(const QString& filename);
 	
 	void setZLayer(const QString& zlayer);
 	const QString& ZLayer() const { return mZLayer; }
+
+	/**
+	 * The rotation and scale ChartItemTools sets on the image.
+	 */
+	ChartItemTransform* chartTransform() { return &mChartTransform; }
+
+protected:
+	QVariant itemChange(GraphicsItemChange change, const QVariant& value);
 	
 private:
 	unsigned int mLayer;
 	QPixmap* mPixmap;
 	QString mFilename;
 	QString mZLayer;
+	ChartItemTransform mChartTransform;
 
 };
 
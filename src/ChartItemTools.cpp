@@ -3,9 +3,7 @@
 #include <QList>
 #include <QTransform>
 #include <QVector2D>
-
-#define ROTATION_MATRIX_INDEX 	0
-#define SCALE_MATRIX_INDEX 		1
+#include "scene.h"
 
 qreal constrainAngle180(qreal x) {
     x = fmod(x + 180,360);
@@ -22,224 +20,277 @@ qreal constrainAngle360(qreal x) {
 }	
 	
 
+QPointF ChartItemTransform::mapToRotation(QPointF point) const
+{
+	QTransform t;
+	t.translate(rotationPivot.x(), rotationPivot.y());
+	t.rotate(rotation);
+	t.translate(-rotationPivot.x(), -rotationPivot.y());
+	return t.map(point);
+}
+
+QPointF ChartItemTransform::mapToScale(QPointF point) const
+{
+	return scalePivot + QPointF((point.x() - scalePivot.x()) * scaleX,
+								(point.y() - scalePivot.y()) * scaleY);
+}
+
+QTransform ChartItemTransform::toTransform() const
+{
+	QTransform scale;
+	scale.translate(scalePivot.x(), scalePivot.y());
+	scale.scale(scaleX, scaleY);
+	scale.translate(-scalePivot.x(), -scalePivot.y());
+	
+	QTransform rotate;
+	rotate.translate(rotationPivot.x(), rotationPivot.y());
+	rotate.rotate(rotation);
+	rotate.translate(-rotationPivot.x(), -rotationPivot.y());
+	
+	//scale first, then rotate
+	return scale * rotate;
+}
+
 qreal ChartItemTools::getRotation(QGraphicsItem* item)
 {
-	return getGraphicsRotation(item)->angle();
+	return transformData(item).rotation;
 }
 
 void ChartItemTools::setRotation(QGraphicsItem* item, qreal rotation)
 {
-	getGraphicsRotation(item)->setAngle(rotation);
+	ChartItemTransform* t = chartTransform(item);
+	if (!t)
+		return;
+	t->rotation = rotation;
+	apply(item, *t);
 }
 
 void ChartItemTools::addRotation(QGraphicsItem* item, qreal rotation)
 {
-	QGraphicsRotation* r = getGraphicsRotation(item);
-	r->setAngle(r->angle() + rotation);
+	ChartItemTransform* t = chartTransform(item);
+	if (!t)
+		return;
+	t->rotation += rotation;
+	apply(item, *t);
 }
 
 QPointF ChartItemTools::getRotationPivot(QGraphicsItem* item)
 {
-	return getGraphicsRotation(item)->origin().toPointF();
+	return transformData(item).rotationPivot;
 }
 
 void ChartItemTools::setRotationPivot(QGraphicsItem* item, QPointF pivot, bool reposition)
 {
-	QGraphicsRotation* r = getGraphicsRotation(item);
+	ChartItemTransform* t = chartTransform(item);
+	if (!t)
+		return;
 	
 	if (reposition) {
 		//get the new pivot point on the scaled stitch
-		QPointF newPivotLocation = mapToRotation(item, pivot);
+		QPointF newPivotLocation = t->mapToRotation(pivot);
 		QPointF diff = newPivotLocation - pivot;
 		//translate by that diff, to offset the translation caused by moving the pivot
 		item->moveBy(diff.x(), diff.y());
 	}
 	
-	r->setOrigin(QVector3D(pivot));
+	t->rotationPivot = pivot;
+	apply(item, *t);
 }
 
 void ChartItemTools::addRotationPivot(QGraphicsItem* item, QPointF pivot, bool reposition)
 {
-	QGraphicsRotation* r = getGraphicsRotation(item);
-	QPointF curPivot = r->origin().toPointF();
-	setRotationPivot(item, curPivot + pivot, reposition);
+	setRotationPivot(item, getRotationPivot(item) + pivot, reposition);
 }
 
 qreal ChartItemTools::getScaleX(QGraphicsItem* item)
 {
-	return getGraphicsScale(item)->xScale();
+	return transformData(item).scaleX;
 }
 
 void ChartItemTools::setScaleX(QGraphicsItem* item, qreal scaleX)
 {
-	getGraphicsScale(item)->setXScale(scaleX);
+	ChartItemTransform* t = chartTransform(item);
+	if (!t)
+		return;
+	t->scaleX = scaleX;
+	apply(item, *t);
 }
 
 void ChartItemTools::addScaleX(QGraphicsItem* item, qreal scaleX)
 {
-	QGraphicsScale* s = getGraphicsScale(item);
-	s->setXScale(s->xScale() + scaleX);
+	ChartItemTransform* t = chartTransform(item);
+	if (!t)
+		return;
+	t->scaleX += scaleX;
+	apply(item, *t);
 }
 
 qreal ChartItemTools::getScaleY(QGraphicsItem* item)
 {
-	return getGraphicsScale(item)->yScale();
+	return transformData(item).scaleY;
 }
 
 void ChartItemTools::setScaleY(QGraphicsItem* item, qreal scaleY)
 {
-	getGraphicsScale(item)->setYScale(scaleY);
+	ChartItemTransform* t = chartTransform(item);
+	if (!t)
+		return;
+	t->scaleY = scaleY;
+	apply(item, *t);
 }
 
 void ChartItemTools::addScaleY(QGraphicsItem* item, qreal scaleY)
 {
-	QGraphicsScale* s = getGraphicsScale(item);
-	s->setYScale(s->yScale() + scaleY);
+	ChartItemTransform* t = chartTransform(item);
+	if (!t)
+		return;
+	t->scaleY += scaleY;
+	apply(item, *t);
 }
 
 QPointF ChartItemTools::getScale(QGraphicsItem* item)
 {
-	QGraphicsScale* s = getGraphicsScale(item);
-	return QPointF(s->xScale(), s->yScale());
+	ChartItemTransform t = transformData(item);
+	return QPointF(t.scaleX, t.scaleY);
+}
+
+void ChartItemTools::setScale(QGraphicsItem* item, QPointF scale)
+{
+	ChartItemTransform* t = chartTransform(item);
+	if (!t)
+		return;
+	t->scaleX = scale.x();
+	t->scaleY = scale.y();
+	apply(item, *t);
 }
 
 QPointF ChartItemTools::getScalePivot(QGraphicsItem* item)
 {
-	return getGraphicsScale(item)->origin().toPointF();
+	return transformData(item).scalePivot;
 }
 
 void ChartItemTools::setScalePivot(QGraphicsItem* item, QPointF pivot, bool reposition)
 {
-	item->setScale(1);
-	QGraphicsScale* r = getGraphicsScale(item);
+	ChartItemTransform* t = chartTransform(item);
+	if (!t)
+		return;
 	
 	if (reposition) {
 		//get the new pivot point on the scaled stitch
-		QPointF newPivotLocation = mapToRotationAndScale(item, pivot);
-		QPointF diff = newPivotLocation - mapToRotation(item, pivot);
+		QPointF newPivotLocation = t->mapToRotation(t->mapToScale(pivot));
+		QPointF diff = newPivotLocation - t->mapToRotation(pivot);
 		//translate by that diff, to offset the translation caused by moving the pivot
 		item->moveBy(diff.x(), diff.y());
 	}
 	
-	r->setOrigin(QVector3D(pivot));
+	t->scalePivot = pivot;
+	apply(item, *t);
 }
 
 void ChartItemTools::addScalePivot(QGraphicsItem* item, QPointF pivot, bool reposition)
 {
-	QGraphicsScale* r = getGraphicsScale(item);
-	QPointF curPivot = r->origin().toPointF();
-	setScalePivot(item, curPivot + pivot, reposition);
+	setScalePivot(item, getScalePivot(item) + pivot, reposition);
 }
 
 QPointF ChartItemTools::mapToRotation(QGraphicsItem* item, QPointF point)
 {
-	//create an identity matrix
-	QMatrix4x4 mat;
-	//rotate it by the graphicsrotation
-	getGraphicsRotation(item)->applyTo(&mat);
-	//return the point mapped by this matrix
-	return mat.map(point);
+	return transformData(item).mapToRotation(point);
 }
 
 QPointF ChartItemTools::mapToScale(QGraphicsItem* item, QPointF point)
 {
-	//create an identity matrix
-	QMatrix4x4 mat;
-	//scale it by the graphicsrotation
-	getGraphicsScale(item)->applyTo(&mat);
-	//return the point mapped by this matrix
-	return mat.map(point);
+	return transformData(item).mapToScale(point);
 }
 
 QPointF ChartItemTools::mapToRotationAndScale(QGraphicsItem* item, QPointF point)
 {
-	//create an identity matrix
-	QMatrix4x4 mat;
-	//rotate  and scale it
-	getGraphicsRotation(item)->applyTo(&mat);
-	getGraphicsScale(item)->applyTo(&mat);
-	//return the point mapped by this matrix
-	return mat.map(point);
+	ChartItemTransform t = transformData(item);
+	return t.mapToRotation(t.mapToScale(point));
 }
 
-void ChartItemTools::initIfNotAlreadyInitialised(QGraphicsItem* item)
+void ChartItemTools::copyTransformations(QGraphicsItem* source, QGraphicsItem* target)
 {
-	QList<QGraphicsTransform*> transforms = item->transformations();
-	if (transforms.length() == 0) {
-		QGraphicsRotation* rot = new QGraphicsRotation();
-		QGraphicsScale* scale = new QGraphicsScale();
-		rot->setParent(item->parentObject());
-		scale->setParent(item->parentObject());
-		transforms.append(rot);
-		transforms.append(scale);
-		item->setTransformations(transforms);
-	} else if (transforms.length() == 1) {
-		QGraphicsScale* scale = new QGraphicsScale();
-		scale->setParent(item->parentObject());
-		transforms.append(scale);
-		item->setTransformations(transforms);
-	}
+	ChartItemTransform* t = chartTransform(target);
+	if (!t)
+		return;
+	*t = transformData(source);
+	apply(target, *t);
 }
 
-QGraphicsRotation* ChartItemTools::getGraphicsRotation(QGraphicsItem* item)
+ChartItemTransform* ChartItemTools::chartTransform(QGraphicsItem* item)
 {
-	return static_cast<QGraphicsRotation*>(getGraphicsTransformations(item)[ROTATION_MATRIX_INDEX]);
+	switch (item->type()) {
+		case Cell::Type:
+			return static_cast<Cell*>(item)->chartTransform();
+		case Indicator::Type:
+			return static_cast<Indicator*>(item)->chartTransform();
+		case ItemGroup::Type:
+			return static_cast<ItemGroup*>(item)->chartTransform();
+		case ChartImage::Type:
+			return static_cast<ChartImage*>(item)->chartTransform();
+		default:
+			return 0;
+	}
 }
 
-QGraphicsScale* ChartItemTools::getGraphicsScale(QGraphicsItem* item)
+ChartItemTransform ChartItemTools::transformData(QGraphicsItem* item)
 {
-	return static_cast<QGraphicsScale*>(getGraphicsTransformations(item)[SCALE_MATRIX_INDEX]);
+	ChartItemTransform* t = chartTransform(item);
+	return t ? *t : ChartItemTransform();
 }
 
-QList<QGraphicsTransform*> ChartItemTools::getGraphicsTransformations(QGraphicsItem* item)
+void ChartItemTools::apply(QGraphicsItem* item, const ChartItemTransform& data)
 {
-	initIfNotAlreadyInitialised(item);
-	QList<QGraphicsTransform*> transforms = item->transformations();
-	return transforms;
+	//the item reports the change to the scene itself
+	item->setTransform(data.toTransform());
 }
 
-QList<QGraphicsTransform*> ChartItemTools::cloneGraphicsTransformations(QGraphicsItem* item)
+void ChartItemTools::recalculateTransformations(QGraphicsItem* item)
 {
-	QList<QGraphicsTransform*> newitems;
-	QGraphicsRotation* oldr = getGraphicsRotation(item);
-	QGraphicsScale* olds = getGraphicsScale(item);
+	//calculate the position of the item now
+	QPointF oldOrigin = item->mapToScene(0, 0);
+	
+	ChartItemTransform data = sceneTransformations(item->boundingRect(), item->sceneTransform());
+	
+	//now we reset the item
+	item->setRotation(0);
+	item->setScale(1);
+	item->setTransformOriginPoint(0, 0);
+	item->resetTransform();
 	
-	QGraphicsRotation* newr = new QGraphicsRotation;
-	QGraphicsScale* news = new QGraphicsScale;
+	//and apply the new transformations
+	ChartItemTransform* t = chartTransform(item);
+	if (t) {
+		*t = data;
+		apply(item, *t);
+	}
 	
-	newr->setOrigin(oldr->origin());
-	newr->setAngle(oldr->angle());
+	//get the position of the item after the changes
+	QPointF nowOrigin = item->mapToScene(0, 0);
 	
-	news->setOrigin(olds->origin());
-	news->setXScale(olds->xScale());
-	news->setYScale(olds->yScale());
+	//move the item back to the original point
+	item->moveBy(oldOrigin.x() - nowOrigin.x(), oldOrigin.y() - nowOrigin.y());
 	
-	newitems.append(newr);
-	newitems.append(news);
-	return newitems;
+	item->update();
 }
 
-void ChartItemTools::recalculateTransformations(QGraphicsItem* item)
+ChartItemTransform ChartItemTools::sceneTransformations(const QRectF& rect, const QTransform& sceneTransform, QPointF* pos)
 {
 	//plan of action:
 	//		1: get the position of the top left corner. this will also be our origin for scale and rotation
 	//		2: get the rotation of the item by mapping two corners and calculating the atan2
 	//		3: get the scale of the item by mapping three corners and comparing the ratio of the distances
-	//		4: reset all transformations of the chartitem
-	//		5: apply the new transformations
-	
-	//calculate the position of the item now
-	QPointF oldOrigin = item->mapToScene(0, 0);
+	//		4: build the new transformations from these
 	
 	//get the positions of three corners
-	QPointF topLeftLocal = item->boundingRect().topLeft();
-	QPointF bottomLeftLocal = item->boundingRect().bottomLeft();
-	QPointF topRightLocal = item->boundingRect().topRight();
+	QPointF topLeftLocal = rect.topLeft();
+	QPointF bottomLeftLocal = rect.bottomLeft();
+	QPointF topRightLocal = rect.topRight();
 	
 	//get these positions mapped
-	QPointF topLeftMapped = item->mapToScene(topLeftLocal);
-	QPointF bottomLeftMapped = item->mapToScene(bottomLeftLocal);
-	QPointF topRightMapped = item->mapToScene(topRightLocal);
+	QPointF topLeftMapped = sceneTransform.map(topLeftLocal);
+	QPointF bottomLeftMapped = sceneTransform.map(bottomLeftLocal);
+	QPointF topRightMapped = sceneTransform.map(topRightLocal);
 	
 	//get the differences in positions both mapped and local
 	QVector2D xDiffMapped = QVector2D(topRightMapped - topLeftMapped);
@@ -268,27 +319,19 @@ void ChartItemTools::recalculateTransformations(QGraphicsItem* item)
 		xrotation -= 180;
 	}
 	
-	//now we reset the item
-	item->setRotation(0);
-	item->setScale(1);
-	item->setTransformOriginPoint(0, 0);
-	item->resetTransform();
-	item->setTransformations(QList<QGraphicsTransform*>());
+	//first we set the scale
+	ChartItemTransform data;
+	data.scalePivot = topLeftLocal;
+	data.scaleX = scaleX;
+	data.scaleY = scaleY;
 	
-	//and apply the new transformations, first we set the scale
-	setScalePivot(item, topLeftLocal);
-	setScaleX(item, scaleX);
-	setScaleY(item, scaleY);
-
 	//and then the rotation
-	setRotationPivot(item, mapToScale(item, topLeftLocal));
-	setRotation(item, xrotation);
+	data.rotationPivot = data.mapToScale(topLeftLocal);
+	data.rotation = xrotation;
 	
-	//get the position of the item after the changes
-	QPointF nowOrigin = item->mapToScene(0, 0);
-	
-	//move the item back to the original point
-	item->moveBy(oldOrigin.x() - nowOrigin.x(), oldOrigin.y() - nowOrigin.y());
+	//the position that keeps the origin of the item where it is
+	if (pos)
+		*pos = sceneTransform.map(QPointF(0, 0)) - data.toTransform().map(QPointF(0, 0));
 	
-	item->update();
+	return data;
 }
\ No newline at end of file
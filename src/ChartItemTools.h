@@ -2,9 +2,32 @@
 #define CHARTITEM_H
 
 #include <QPointF>
+#include <QList>
+#include <QTransform>
 #include <QGraphicsItem>
-#include <QGraphicsRotation>
-#include <QGraphicsScale>
+
+/**
+ * The rotation and scale of a chart item and the points they are done around.
+ * The item is scaled first and then rotated.
+ */
+struct ChartItemTransform
+{
+	ChartItemTransform() : rotation(0), scaleX(1), scaleY(1) {}
+
+	qreal rotation;
+	QPointF rotationPivot;
+	qreal scaleX;
+	qreal scaleY;
+	QPointF scalePivot;
+
+	QPointF mapToRotation(QPointF point) const;
+	QPointF mapToScale(QPointF point) const;
+
+	/**
+	 * The transform set on the item, the same as a QGraphicsScale followed by a QGraphicsRotation.
+	 */
+	QTransform toTransform() const;
+};
 
 /**
  * static helping class to aid in manipulating the transform of graphicsitems
@@ -33,6 +56,7 @@ public:
 	static void addScaleY(QGraphicsItem* item, qreal scaleY);
 	
 	static QPointF getScale(QGraphicsItem* item);
+	static void setScale(QGraphicsItem* item, QPointF scale);
 
 	static QPointF getScalePivot(QGraphicsItem* item);
 	static void setScalePivot(QGraphicsItem* item, QPointF pivot, bool reposition = true);
@@ -44,6 +68,11 @@ public:
 	 * will be different.
 	 */
 	static void recalculateTransformations(QGraphicsItem* item);
+	/**
+	 * the transformations and position that show an item without a parent the way
+	 * sceneTransform shows it, without changing the item itself.
+	 */
+	static ChartItemTransform sceneTransformations(const QRectF& rect, const QTransform& sceneTransform, QPointF* pos = 0);
 	
 	/**
 	 * rotate a point in local coordinates (boundingrect coordinates) with the rotation of the graphicsitem
@@ -58,14 +87,19 @@ public:
 	 */
 	static QPointF mapToRotationAndScale(QGraphicsItem* item, QPointF point);
 	
-	static QList<QGraphicsTransform*> cloneGraphicsTransformations(QGraphicsItem* item);
-
-	static void initIfNotAlreadyInitialised(QGraphicsItem* item);
+	/**
+	 * give target the same rotation and scale as source
+	 */
+	static void copyTransformations(QGraphicsItem* source, QGraphicsItem* target);
 	
 protected:
-	static QGraphicsRotation* getGraphicsRotation(QGraphicsItem* item);
-	static QGraphicsScale* getGraphicsScale(QGraphicsItem* item);
-	static QList<QGraphicsTransform*> getGraphicsTransformations(QGraphicsItem* item);
+	/**
+	 * the transform data stored on chart items, 0 for any other item
+	 */
+	static ChartItemTransform* chartTransform(QGraphicsItem* item);
+	static ChartItemTransform transformData(QGraphicsItem* item);
+	//set the item's transform from its data
+	static void apply(QGraphicsItem* item, const ChartItemTransform& data);
 };
 
 #endif // CHARTITEM_H
@@ -18,28 +18,19 @@
  along with Crochet Charts. If not, see <http://www.gnu.org/licenses/>.
 
  \****************************************************************************/
-#include "guideline.h"
+#include "builtinglyphs.h"
 
-#include <QDebug>
-#include <QGraphicsSceneMouseEvent>
+#include <QHash>
+#include <QString>
 
-Guideline::Guideline(const QRectF &rect, QGraphicsItem *parent, QGraphicsScene *scene) :
-    QGraphicsEllipseItem(rect, parent, scene)
+const BuiltInGlyph* findBuiltInGlyph(const QString &file)
 {
-    setAcceptedMouseButtons(0);
-}
+    static QHash<QString, const BuiltInGlyph*> glyphs;
 
-void Guideline::mousePressEvent(QGraphicsSceneMouseEvent *event)
-{
-    event->ignore();
-}
+    if(glyphs.isEmpty()) {
+        for(int i = 0; i < builtInGlyphCount; ++i)
+            glyphs.insert(QString::fromLatin1(builtInGlyphs[i].file), &builtInGlyphs[i]);
+    }
 
-void Guideline::mouseMoveEvent(QGraphicsSceneMouseEvent *event)
-{
-    event->ignore();
-}
-
-void Guideline::mouseReleaseEvent(QGraphicsSceneMouseEvent *event)
-{
-    event->ignore();
+    return glyphs.value(file, 0);
 }
@@ -0,0 +1,78 @@
+/****************************************************************************\
+ Copyright (c) 2011-2014 Stitch Works Software
+ Brian C. Milco <bcmilco@gmail.com>
+
+ This file is part of Crochet Charts.
+
+ Crochet Charts is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ Crochet Charts is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with Crochet Charts. If not, see <http://www.gnu.org/licenses/>.
+
+ \****************************************************************************/
+#ifndef BUILTINGLYPHS_H
+#define BUILTINGLYPHS_H
+
+#include <QtGlobal>
+
+class QString;
+
+/**
+ * The built in stitch svgs compiled into drawing primitives at build time.
+ *
+ * The tables are generated by the glyphcompiler from the svgs in stitches/
+ * into builtinglyphs_data.cpp in the build directory.
+ */
+struct BuiltInGlyph
+{
+    struct PathElement {
+        int type; //QPainterPath::ElementType
+        qreal x;
+        qreal y;
+    };
+
+    struct Element {
+        const PathElement *path;
+        int pathCount;
+        int fillRule;
+
+        int penStyle;
+        unsigned int penColor;
+        qreal penWidth;
+        int penCapStyle;
+        int penJoinStyle;
+        qreal penMiterLimit;
+
+        int brushStyle;
+        unsigned int brushColor;
+
+        qreal transform[9];
+        qreal opacity;
+    };
+
+    //the resource path of the svg, ie: ":/stitches/ch.svg"
+    const char *file;
+    qreal width;
+    qreal height;
+
+    const Element *elements;
+    int elementCount;
+};
+
+extern const BuiltInGlyph builtInGlyphs[];
+extern const int builtInGlyphCount;
+
+/**
+ * Returns the compiled glyph for the given stitch file or 0 if it isn't built in.
+ */
+const BuiltInGlyph* findBuiltInGlyph(const QString &file);
+
+#endif // BUILTINGLYPHS_H
@@ -25,89 +25,166 @@
 #include <qsvgrenderer.h>
 #include "stitchlibrary.h"
 #include "stitchset.h"
+#include "stitchglyph.h"
 #include "settings.h"
 #include "ChartItemTools.h"
+#include "scene.h"
 #include <QStyleOption>
 #include <QEvent>
 
 #include <QGraphicsScene>
 
 Cell::Cell(QGraphicsItem *parent)
-    : QGraphicsSvgItem(parent),
+    : QGraphicsItem(parent),
 	mLayer(0),
-    mStitch(0),
+    mStitchId(-1),
+    mBgColorIndex(-1),
+    mColorIndex(-1),
     mHighlight(false)
 {
+    //a parent can already have put the cell in a scene.
+    mBgColorIndex = palette()->add(QColor(Qt::white).rgba());
 
-    setCachingEnabled(false);
     setAcceptHoverEvents(true);
     setFlag(QGraphicsItem::ItemIsMovable);
     setFlag(QGraphicsItem::ItemIsSelectable);
+    setFlag(QGraphicsItem::ItemSendsGeometryChanges);
 
-    //if we don't set the bgColor it'll end up black.
-    setBgColor();
 }
 
 Cell::~Cell()
 {
+    Scene::trackItemChange(this, QGraphicsItem::ItemSceneChange, QVariant());
+}
+
+ColorPalette* Cell::palette() const
+{
+    return Scene::colorPalette(scene());
+}
+
+QColor Cell::color() const
+{
+    if(mColorIndex < 0)
+        return QColor(Qt::black);
+    return QColor::fromRgba(palette()->color(mColorIndex));
+}
+
+QVariant Cell::itemChange(GraphicsItemChange change, const QVariant &value)
+{
+    //a scene the cell leaves counts its colors out while they're still in its palette.
+    Scene::trackItemChange(this, change, value);
+
+    if(change == QGraphicsItem::ItemSceneChange) {
+        //move the colors into the palette of the new scene.
+        ColorPalette *from = palette();
+        ColorPalette *to = Scene::colorPalette(value.value<QGraphicsScene*>());
+        if(from != to) {
+            if(mColorIndex >= 0)
+                mColorIndex = moveEntry(from, to, mColorIndex, mKeptColor);
+            mBgColorIndex = moveEntry(from, to, mBgColorIndex, mKeptBgColor);
+        }
+    }
+
+    return QGraphicsItem::itemChange(change, value);
+}
+
+int Cell::moveEntry(ColorPalette *from, ColorPalette *to, int index, KeptEntry &kept)
+{
+    //outside of a scene the cell keeps the entry it had, with its colors in
+    //every colorway, the loose palette only has the color shown right now.
+    if(from != ColorPalette::loose()) {
+        kept.palette = from->id();
+        kept.index = index;
+        kept.colors = from->entry(index);
+    }
+
+    if(to == ColorPalette::loose())
+        return to->add(from->color(index));
+
+    int entry;
+    if(kept.palette == to->id() && kept.index >= 0 && kept.index < to->count())
+        entry = kept.index;
+    else if(kept.colors.count() == to->colorwayCount())
+        entry = to->addEntry(kept.colors);
+    else
+        entry = to->add(from->color(index));
+
+    kept = KeptEntry();
+    return entry;
+}
+
+void Cell::setLayer(unsigned int layer)
+{
+    mLayer = layer;
+    Scene::trackLayerChange(this);
 }
 
 QRectF Cell::boundingRect() const
 {
-    if(!stitch())
+    Stitch *s = stitch();
+    if(!s)
         return QRectF(0,0,32,32);
 
-    if(stitch()->isSvg()) {
-		QRectF r = QGraphicsSvgItem::boundingRect();
-        return r;
+    if(s->isSvg()) {
+        StitchGlyph *glyph = s->glyph();
+        if(glyph)
+            return glyph->boundingRect();
+        QSvgRenderer *r = s->renderSvg();
+        if(r)
+            return QRectF(QPointF(0, 0), r->defaultSize());
+        return QRectF(0,0,32,32);
     } else
-        return stitch()->renderPixmap()->rect();
+        return s->renderPixmap()->rect();
+}
+
+QPainterPath Cell::shape() const
+{
+    Stitch *s = stitch();
+    if(s) {
+        StitchGlyph *glyph = s->glyph();
+        if(glyph)
+            return glyph->outline();
+    }
+
+    QPainterPath path;
+    path.addRect(boundingRect());
+    return path;
 }
 
 void Cell::paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget)
 {
-    if(!stitch())
+    Stitch *s = stitch();
+    if(!s)
+        return;
+
+    if(Scene::isDrawnFromLayerCache(this, mLayer, widget))
         return;
 
     QColor clr = bgColor();
-    if(!clr.isValid())
-        clr = QColor(Qt::white);
 
     if(clr != Qt::white)
         painter->fillRect(option->rect, clr);
     if(mHighlight)
         painter->fillRect(option->rect, option->palette.highlight());
 
-    if(stitch()->isSvg()) {
-        QGraphicsSvgItem::paint(painter, option, widget);
-    } else {
-        painter->drawPixmap(option->rect.x(), option->rect.y(), *(stitch()->renderPixmap()));
-
-         if(option->state & QStyle::State_Selected) {
-            painter->setPen(Qt::DashLine);
-            painter->drawRect(option->rect);
-            painter->setPen(Qt::SolidLine);
+    if(s->isSvg()) {
+        StitchGlyph *glyph = s->glyph();
+        if(!glyph) {
+            QSvgRenderer *r = s->renderSvg(color());
+            if(r)
+                r->render(painter, boundingRect());
+            return;
         }
-    }
-}
-
-bool Cell::event(QEvent *e)
-{
-    //Pass the mouse control back to the scene,
-    //allowing for changing stitches by click.
-    int selectedItems = 1;
-
-    if(scene()) {
-        selectedItems = scene()->selectedItems().count();
+        glyph->draw(painter, color());
+    } else {
+        painter->drawPixmap(option->rect.x(), option->rect.y(), *(s->renderPixmap()));
     }
 
-    if(isSelected() && selectedItems == 1
-		&& Settings::inst()->value("replaceStitchWithPress").toBool() == true) {
-        e->setAccepted(false);
-        return false;
+    if(option->state & QStyle::State_Selected) {
+        painter->setPen(Qt::DashLine);
+        painter->drawRect(option->rect);
+        painter->setPen(Qt::SolidLine);
     }
-
-    return QGraphicsSvgItem::event(e);
 }
 
 bool Cell::isGrouped()
@@ -123,24 +200,25 @@ bool Cell::isGrouped()
 
 void Cell::setStitch(Stitch *s)
 {
+    Stitch *current = stitch();
 
-    if (mStitch != s) {
+    if (current != s) {
         QString old;
         bool doUpdate = false;
         
-        if (mStitch) {
-            old = mStitch->name();
-            doUpdate = (mStitch->isSvg() != s->isSvg());
-        }
-        mStitch = s;
-        if(s->isSvg()) {
-            setSharedRenderer(s->renderSvg(mColor));
+        if (current) {
+            old = current->name();
+            doUpdate = (current->isSvg() != s->isSvg());
         }
+        prepareGeometryChange();
+        mStitchId = s->id();
+        Scene::trackGeometryChange(this);
+        Scene::trackCellChange(this);
 
         if(doUpdate)
             update();
         
-        emit stitchChanged(old, s->name());
+        Scene::trackStitchChange(this, old, s->name());
     }
     
     setTransformOriginPoint(s->width()/2, s->height());
@@ -148,33 +226,65 @@ void Cell::setStitch(Stitch *s)
 
 void Cell::setBgColor(QColor c)
 {
-    if (mBgColor != c) {
-        QString old = "";
-        if (mBgColor.isValid())
-            old = mBgColor.name();
-        mBgColor = c;
-        emit colorChanged(old, c.name());
-        update();
-    }
+    //an invalid color has always been drawn as white.
+    if (!c.isValid())
+        c = QColor(Qt::white);
+
+    if (bgColor().rgba() != c.rgba())
+        setBgColorIndex(palette()->add(c.rgba()));
+}
+
+void Cell::setBgColorIndex(int index)
+{
+    if(index < 0)
+        index = palette()->add(QColor(Qt::white).rgba());
+
+    if(index == mBgColorIndex)
+        return;
+
+    QString old = countedBgColor();
+    mBgColorIndex = index;
+    mKeptBgColor = KeptEntry();
+    Scene::trackCellChange(this);
+    Scene::trackColorChange(this, old, countedBgColor());
+    Scene::trackPaintChange(this);
+    update();
+}
+
+QString Cell::countedBgColor() const
+{
+    QColor bg = bgColor();
+    if(bg.rgba() == QColor(Qt::white).rgba())
+        return QString();
+    return bg.name();
 }
 
 void Cell::setColor(QColor c)
 {
+    if (!c.isValid())
+        c = QColor(Qt::black);
 
-    if(mColor != c) {
-        QString old = "";
-        if(mColor.isValid())
-            old = mColor.name();
-        mColor = c;
+    if(mColorIndex < 0 || color().rgba() != c.rgba())
+        setColorIndex(palette()->add(c.rgba()));
+}
 
-        QSvgRenderer *r = stitch()->renderSvg(c);
-        if(r)
-            setSharedRenderer(r);
+void Cell::setColorIndex(int index)
+{
+    if(index < 0)
+        index = -1;
 
-        emit colorChanged(old, c.name());
-        update();
-    }
+    if(index == mColorIndex)
+        return;
 
+    QString old;
+    if(mColorIndex >= 0)
+        old = color().name();
+    mColorIndex = index;
+    mKeptColor = KeptEntry();
+    Scene::trackCellChange(this);
+    Scene::trackColorChange(this, old, index >= 0 ? color().name() : QString());
+    Scene::trackPaintChange(this);
+    update();
 }
 
 void Cell::setStitch(QString s)
@@ -191,30 +301,31 @@ void Cell::setStitch(QString s)
 
 QString Cell::name()
 {
-    if(mStitch)
-        return mStitch->name();
+    Stitch *s = stitch();
+    if(s)
+        return s->name();
     else
         return QString();
 }
 
 void Cell::useAlternateRenderer(bool useAlt)
 {
-    if(mStitch->isSvg() && mStitch->renderSvg()->isValid()) {
+    Stitch *s = stitch();
+    if(s && s->isSvg() && (s->glyph() || s->renderSvg())) {
         QString primary = Settings::inst()->value("stitchPrimaryColor").toString();
         QString secondary = Settings::inst()->value("stitchAlternateColor").toString();
         QString color;
 
         //only use the primary and secondary colors if the stitch is using the default colors.
-        if(useAlt && mColor == primary) {
+        if(useAlt && this->color() == primary) {
             color = secondary;
-        } else if(!useAlt && mColor == secondary) {
+        } else if(!useAlt && this->color() == secondary) {
             color = primary;
         } else {
-            color = mColor.name();
+            color = this->color().name();
         }
 
-        mColor = QColor(color);
-        setSharedRenderer(mStitch->renderSvg(mColor.name()));
+        setColorIndex(palette()->add(QColor(color).rgba()));
     }
 }
 
@@ -228,13 +339,11 @@ Cell* Cell::copy(Cell *cell)
 
     c->setStitch(stitch());
     c->setBgColor(bgColor());
-    c->setColor(c->color());
+    c->setColor(color());
     c->setTransformOriginPoint(transformOriginPoint());
     c->setRotation(0);
     c->setTransform(QTransform());
-	c->setTransformations(ChartItemTools::cloneGraphicsTransformations(this));
-	foreach (QGraphicsTransform* t, transformations())
-		t->setParent(parentObject());
+	ChartItemTools::copyTransformations(this, c);
 
     return c;
 }
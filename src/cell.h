@@ -21,13 +21,21 @@
 #ifndef CELL_H
 #define CELL_H
 
-#include <QtSvg/QGraphicsSvgItem>
+#include <QGraphicsItem>
+#include <QColor>
 #include "stitch.h"
-#include <QPointer>
-
-class Cell : public QGraphicsSvgItem
+#include "ChartItemTools.h"
+#include "colorpalette.h"
+
+/**
+ * A single stitch on the chart.
+ *
+ * Cells aren't QObjects, changes to their stitch and colors are reported
+ * to the scene they are in which passes them on in batches. The colors are
+ * kept as indexes into the ColorPalette of the scene.
+ */
+class Cell : public QGraphicsItem
 {
-    Q_OBJECT
     friend class SaveFile;
     friend class File_v1;
     friend class File_v2;
@@ -39,28 +47,50 @@ public:
     ~Cell();
     
     QRectF boundingRect() const;
+    QPainterPath shape() const;
     void paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget = 0);
     int type () const { return Cell::Type; }
 
-    bool event(QEvent *e);
-
     bool isGrouped();
 
     void setHighlight(bool state) { mHighlight = state; update(); }
     Cell* copy(Cell *cell = 0);
     
     void setBgColor(QColor c = QColor(Qt::white));
-    QColor bgColor() const { return mBgColor; }
+    QColor bgColor() const { return QColor::fromRgba(palette()->color(mBgColorIndex)); }
     
     void setColor(QColor c = QColor(Qt::black));
-    QColor color() const { return mColor; }
+    QColor color() const;
+
+    /**
+     * The palette entries of the colors, colorIndex() is -1 until a color is set.
+     */
+    int colorIndex() const { return mColorIndex; }
+    int bgColorIndex() const { return mBgColorIndex; }
+
+    /**
+     * The name the background is counted under in the colors of the chart,
+     * empty for the white background every cell starts out with.
+     */
+    QString countedBgColor() const;
+
+    /**
+     * Point the cell at an entry of the palette of its scene, -1 goes back to no color.
+     */
+    void setColorIndex(int index);
+    void setBgColorIndex(int index);
 
     void setStitch(Stitch *s);
     void setStitch(QString s);
-    Stitch* stitch() const { return mStitch; }
+    Stitch* stitch() const { return Stitch::fromId(mStitchId); }
 	
 	unsigned int layer() { return mLayer; }
-	void setLayer(unsigned int layer) { mLayer = layer; }
+	void setLayer(unsigned int layer);
+
+    /**
+     * The rotation and scale ChartItemTools sets on the cell.
+     */
+    ChartItemTransform* chartTransform() { return &mChartTransform; }
 
     /**
      * The stitch name.
@@ -69,20 +99,36 @@ public:
 
     void useAlternateRenderer(bool useAlt);
     
-signals:
-    void stitchChanged(QString oldSt, QString newSt);
-    void colorChanged(QString oldColor, QString newColor);
-    void bgColorChanged(QString oldColor, QString newColor);
-    
+protected:
+    QVariant itemChange(GraphicsItemChange change, const QVariant &value);
+
 private:
+    //the palette the color indexes belong to.
+    ColorPalette* palette() const;
+
+    //the entry a color had in the last scene the cell was in.
+    struct KeptEntry {
+        KeptEntry() : palette(-1), index(-1) {}
+        int palette;
+        int index;
+        QVector<QRgb> colors;
+    };
+
+    int moveEntry(ColorPalette *from, ColorPalette *to, int index, KeptEntry &kept);
+
 	//the layer of the cell
 	unsigned int mLayer;
-    QColor mBgColor;
-    QColor mColor;
-    QPointer<Stitch> mStitch;
+    //the Stitch::id() of the stitch, -1 until one is set.
+    int mStitchId;
+    int mBgColorIndex;
+    //-1 until a color is set, the cell is drawn in black until then.
+    int mColorIndex;
+    KeptEntry mKeptBgColor;
+    KeptEntry mKeptColor;
 
     bool mHighlight;
 
+    ChartItemTransform mChartTransform;
 };
 
 #endif // CELL_H
@@ -0,0 +1,96 @@
+/****************************************************************************\
+ Copyright (c) 2011-2014 Stitch Works Software
+ Brian C. Milco <bcmilco@gmail.com>
+
+ This file is part of Crochet Charts.
+
+ Crochet Charts is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ Crochet Charts is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with Crochet Charts. If not, see <http://www.gnu.org/licenses/>.
+
+ \****************************************************************************/
+#include "cellindex.h"
+
+#include "cell.h"
+
+CellIndex::CellIndex()
+{
+}
+
+void CellIndex::insertKey(QHash<int, QSet<Cell*> >& index, int key, Cell* cell)
+{
+    index[key].insert(cell);
+}
+
+void CellIndex::removeKey(QHash<int, QSet<Cell*> >& index, int key, Cell* cell)
+{
+    QHash<int, QSet<Cell*> >::iterator i = index.find(key);
+    if(i == index.end())
+        return;
+
+    i.value().remove(cell);
+    if(i.value().isEmpty())
+        index.erase(i);
+}
+
+void CellIndex::update(Cell* cell)
+{
+    Keys keys;
+    Stitch* s = cell->stitch();
+    keys.stitch = s ? s->id() : -1;
+    keys.color = cell->colorIndex();
+    keys.bgColor = cell->bgColorIndex();
+
+    QHash<Cell*, Keys>::iterator i = mKeys.find(cell);
+    if(i == mKeys.end()) {
+        insertKey(mStitches, keys.stitch, cell);
+        insertKey(mColors, keys.color, cell);
+        insertKey(mBgColors, keys.bgColor, cell);
+        mKeys.insert(cell, keys);
+        return;
+    }
+
+    Keys& old = i.value();
+    if(old.stitch != keys.stitch) {
+        removeKey(mStitches, old.stitch, cell);
+        insertKey(mStitches, keys.stitch, cell);
+    }
+    if(old.color != keys.color) {
+        removeKey(mColors, old.color, cell);
+        insertKey(mColors, keys.color, cell);
+    }
+    if(old.bgColor != keys.bgColor) {
+        removeKey(mBgColors, old.bgColor, cell);
+        insertKey(mBgColors, keys.bgColor, cell);
+    }
+    old = keys;
+}
+
+void CellIndex::remove(Cell* cell)
+{
+    QHash<Cell*, Keys>::iterator i = mKeys.find(cell);
+    if(i == mKeys.end())
+        return;
+
+    removeKey(mStitches, i.value().stitch, cell);
+    removeKey(mColors, i.value().color, cell);
+    removeKey(mBgColors, i.value().bgColor, cell);
+    mKeys.erase(i);
+}
+
+void CellIndex::clear()
+{
+    mKeys.clear();
+    mStitches.clear();
+    mColors.clear();
+    mBgColors.clear();
+}
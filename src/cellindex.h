@@ -0,0 +1,87 @@
+/****************************************************************************\
+ Copyright (c) 2011-2014 Stitch Works Software
+ Brian C. Milco <bcmilco@gmail.com>
+
+ This file is part of Crochet Charts.
+
+ Crochet Charts is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ Crochet Charts is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with Crochet Charts. If not, see <http://www.gnu.org/licenses/>.
+
+ \****************************************************************************/
+#ifndef CELLINDEX_H
+#define CELLINDEX_H
+
+#include <QHash>
+#include <QSet>
+#include <QList>
+
+class Cell;
+
+/**
+ * The chart cells grouped by stitch and by the palette entries of their colors,
+ * so finding or counting every cell with a stitch or color doesn't scan the scene.
+ *
+ * Like the SpatialIndex it doesn't watch the cells, the owner has to update() a cell
+ * when its stitch or colors change and remove() it when it leaves.
+ */
+class CellIndex
+{
+public:
+    CellIndex();
+
+    /**
+     * Add the cell or file it under its current stitch and colors if it's already indexed.
+     */
+    void update(Cell* cell);
+    void remove(Cell* cell);
+    void clear();
+
+    bool contains(Cell* cell) const { return mKeys.contains(cell); }
+    int count() const { return mKeys.count(); }
+
+    /**
+     * The cells with the Stitch::id(), the foreground palette entry or the background palette entry.
+     * Cells without a foreground color are kept under entry -1.
+     */
+    QList<Cell*> stitchCells(int stitchId) const { return mStitches.value(stitchId).toList(); }
+    QList<Cell*> colorCells(int index) const { return mColors.value(index).toList(); }
+    QList<Cell*> bgColorCells(int index) const { return mBgColors.value(index).toList(); }
+
+    int stitchCount(int stitchId) const { return mStitches.value(stitchId).count(); }
+    int colorCount(int index) const { return mColors.value(index).count(); }
+    int bgColorCount(int index) const { return mBgColors.value(index).count(); }
+
+    /**
+     * The Stitch::id() of every stitch used by at least one cell.
+     */
+    QList<int> stitches() const { return mStitches.keys(); }
+
+private:
+    struct Keys {
+        int stitch;
+        int color;
+        int bgColor;
+    };
+
+    static void insertKey(QHash<int, QSet<Cell*> >& index, int key, Cell* cell);
+    static void removeKey(QHash<int, QSet<Cell*> >& index, int key, Cell* cell);
+
+    //what each cell was filed under, so it can be found again after it changed.
+    QHash<Cell*, Keys> mKeys;
+
+    QHash<int, QSet<Cell*> > mStitches;
+    QHash<int, QSet<Cell*> > mColors;
+    QHash<int, QSet<Cell*> > mBgColors;
+};
+
+#endif // CELLINDEX_H
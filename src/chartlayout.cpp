@@ -0,0 +1,142 @@
+/****************************************************************************\
+ Copyright (c) 2011-2014 Stitch Works Software
+ Brian C. Milco <bcmilco@gmail.com>
+
+ This file is part of Crochet Charts.
+
+ Crochet Charts is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ Crochet Charts is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with Crochet Charts. If not, see <http://www.gnu.org/licenses/>.
+
+ \****************************************************************************/
+#include "chartlayout.h"
+
+#include <math.h>
+
+ChartLayout::ChartLayout()
+{
+}
+
+void ChartLayout::resize(int count)
+{
+    mX.resize(count);
+    mY.resize(count);
+    mAngle.resize(count);
+}
+
+int ChartLayout::rowLength(int row) const
+{
+    int end = (row + 1 < mRowStarts.count()) ? mRowStarts.at(row + 1) : count();
+    return end - mRowStarts.at(row);
+}
+
+ChartLayout ChartLayout::rounds(int rounds, int stitches, int increaseBy, qreal roundHeight, const QSizeF& stitchSize)
+{
+    ChartLayout layout;
+    layout.mStitchSize = stitchSize;
+
+    int total = 0;
+    for(int r = 0; r < rounds; ++r)
+        total += qMax(0, stitches + r * increaseBy);
+    layout.resize(total);
+
+    qreal* x = layout.mX.data();
+    qreal* y = layout.mY.data();
+    qreal* angle = layout.mAngle.data();
+
+    qreal halfW = stitchSize.width() / 2;
+    qreal halfH = stitchSize.height() / 2;
+
+    int start = 0;
+    for(int r = 0; r < rounds; ++r) {
+        layout.mRowStarts.append(start);
+
+        int count = qMax(0, stitches + r * increaseBy);
+        if(count == 0)
+            continue;
+
+        double widthInDegrees = 360.0 / count;
+        //FIXME: this padding should be dependant on the height of the sts.
+        double radius = roundHeight * (r + 1) + 32;
+
+        qreal* rx = x + start;
+        qreal* ry = y + start;
+        qreal* ra = angle + start;
+
+        for(int i = 0; i < count; ++i)
+            ra[i] = widthInDegrees * i;
+
+        //centered on the point on the circle.
+        for(int i = 0; i < count; ++i) {
+            qreal radians = ra[i] * M_PI / 180;
+            rx[i] = radius * cos(radians) - halfW;
+            ry[i] = radius * sin(radians) - halfH;
+        }
+
+        //standing on the circle facing away from the center.
+        for(int i = 0; i < count; ++i)
+            ra[i] += 90;
+
+        start += count;
+    }
+
+    return layout;
+}
+
+ChartLayout ChartLayout::rows(int rows, int stitches, const QSizeF& spacing, const QSizeF& stitchSize)
+{
+    ChartLayout layout;
+    layout.mStitchSize = stitchSize;
+
+    rows = qMax(0, rows);
+    stitches = qMax(0, stitches);
+    layout.resize(rows * stitches);
+
+    qreal* x = layout.mX.data();
+    qreal* y = layout.mY.data();
+    qreal* angle = layout.mAngle.data();
+
+    qreal stepX = stitchSize.width() + spacing.width();
+
+    for(int r = 0; r < rows; ++r) {
+        int start = r * stitches;
+        layout.mRowStarts.append(start);
+
+        qreal rowY = spacing.height() * (r + 1);
+        for(int i = 0; i < stitches; ++i) {
+            x[start + i] = stepX * (stitches - i);
+            y[start + i] = rowY;
+            angle[start + i] = 0;
+        }
+    }
+
+    return layout;
+}
+
+QRectF ChartLayout::boundingRect() const
+{
+    if(mX.isEmpty())
+        return QRectF();
+
+    const qreal* x = mX.constData();
+    const qreal* y = mY.constData();
+    qreal left = x[0], right = x[0], top = y[0], bottom = y[0];
+    for(int i = 1; i < mX.count(); ++i) {
+        left = qMin(left, x[i]);
+        right = qMax(right, x[i]);
+        top = qMin(top, y[i]);
+        bottom = qMax(bottom, y[i]);
+    }
+
+    qreal reach = qMax(mStitchSize.width(), mStitchSize.height());
+    return QRectF(left, top, right - left, bottom - top).adjusted(-reach, -reach, reach, reach);
+}
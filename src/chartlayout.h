@@ -0,0 +1,85 @@
+/****************************************************************************\
+ Copyright (c) 2011-2014 Stitch Works Software
+ Brian C. Milco <bcmilco@gmail.com>
+
+ This file is part of Crochet Charts.
+
+ Crochet Charts is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ Crochet Charts is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with Crochet Charts. If not, see <http://www.gnu.org/licenses/>.
+
+ \****************************************************************************/
+#ifndef CHARTLAYOUT_H
+#define CHARTLAYOUT_H
+
+#include <QVector>
+#include <QPointF>
+#include <QSizeF>
+#include <QRectF>
+
+/**
+ * Where every stitch of a new rows or rounds chart goes.
+ *
+ * The positions and angles of all the stitches are worked out in one pass and
+ * kept in plain arrays, so the loops have nothing carried from one stitch to
+ * the next and the compiler can vectorize them. The same layout is used to
+ * create the chart and to preview it in the new chart options.
+ *
+ * Positions are the scene positions of the stitches, their transform origin is
+ * the middle of the bottom of the stitch.
+ */
+class ChartLayout
+{
+public:
+    ChartLayout();
+
+    /**
+     * Rounds of stitches around the center, each round has increaseBy more
+     * stitches than the one before it.
+     */
+    static ChartLayout rounds(int rounds, int stitches, int increaseBy, qreal roundHeight, const QSizeF& stitchSize);
+
+    /**
+     * Rows of stitches from the top down, the last stitch of each row on the left.
+     */
+    static ChartLayout rows(int rows, int stitches, const QSizeF& spacing, const QSizeF& stitchSize);
+
+    int count() const { return mX.count(); }
+    int rowCount() const { return mRowStarts.count(); }
+
+    int rowStart(int row) const { return mRowStarts.at(row); }
+    int rowLength(int row) const;
+
+    QPointF pos(int i) const { return QPointF(mX.at(i), mY.at(i)); }
+    qreal angle(int i) const { return mAngle.at(i); }
+
+    const QSizeF& stitchSize() const { return mStitchSize; }
+
+    /**
+     * The area covered by the positions of the stitches and one stitch around them.
+     */
+    QRectF boundingRect() const;
+
+private:
+    void resize(int count);
+
+    QVector<qreal> mX;
+    QVector<qreal> mY;
+    QVector<qreal> mAngle;
+
+    //the index of the first stitch of each row.
+    QVector<int> mRowStarts;
+
+    QSizeF mStitchSize;
+};
+
+#endif // CHARTLAYOUT_H
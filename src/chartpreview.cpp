@@ -0,0 +1,78 @@
+/****************************************************************************\
+ Copyright (c) 2011-2014 Stitch Works Software
+ Brian C. Milco <bcmilco@gmail.com>
+
+ This file is part of Crochet Charts.
+
+ Crochet Charts is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ Crochet Charts is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with Crochet Charts. If not, see <http://www.gnu.org/licenses/>.
+
+ \****************************************************************************/
+#include "chartpreview.h"
+
+#include <QPainter>
+#include <QPaintEvent>
+#include <math.h>
+
+ChartPreview::ChartPreview(QWidget* parent)
+    : QWidget(parent)
+{
+    setSizePolicy(QSizePolicy::Fixed, QSizePolicy::Preferred);
+}
+
+QSize ChartPreview::sizeHint() const
+{
+    return QSize(96, 96);
+}
+
+void ChartPreview::setChartLayout(const ChartLayout& layout)
+{
+    mBounds = layout.boundingRect();
+    mLines.resize(layout.count());
+
+    //the base of a stitch is its transform origin, the top is a stitch height away turned by its angle.
+    qreal halfW = layout.stitchSize().width() / 2;
+    qreal height = layout.stitchSize().height();
+    QLineF* line = mLines.data();
+    for(int i = 0; i < layout.count(); ++i) {
+        QPointF base = layout.pos(i) + QPointF(halfW, height);
+        qreal radians = layout.angle(i) * M_PI / 180;
+        line[i] = QLineF(base, base + QPointF(height * sin(radians), -height * cos(radians)));
+    }
+
+    update();
+}
+
+void ChartPreview::paintEvent(QPaintEvent* event)
+{
+    Q_UNUSED(event);
+
+    QPainter p(this);
+    p.fillRect(rect(), palette().base());
+
+    if(mLines.isEmpty() || mBounds.isEmpty())
+        return;
+
+    QRectF target = QRectF(rect()).adjusted(2, 2, -2, -2);
+    qreal scale = qMin(target.width() / mBounds.width(), target.height() / mBounds.height());
+
+    p.setRenderHint(QPainter::Antialiasing);
+    p.translate(target.center());
+    p.scale(scale, scale);
+    p.translate(-mBounds.center());
+
+    QPen pen(palette().text().color());
+    pen.setCosmetic(true);
+    p.setPen(pen);
+    p.drawLines(mLines);
+}
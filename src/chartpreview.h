@@ -0,0 +1,55 @@
+/****************************************************************************\
+ Copyright (c) 2011-2014 Stitch Works Software
+ Brian C. Milco <bcmilco@gmail.com>
+
+ This file is part of Crochet Charts.
+
+ Crochet Charts is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ Crochet Charts is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with Crochet Charts. If not, see <http://www.gnu.org/licenses/>.
+
+ \****************************************************************************/
+#ifndef CHARTPREVIEW_H
+#define CHARTPREVIEW_H
+
+#include <QWidget>
+#include <QVector>
+#include <QLineF>
+#include <QRectF>
+
+#include "chartlayout.h"
+
+/**
+ * A small drawing of the chart the new chart options will create.
+ * Each stitch is drawn as a line from its base to its top.
+ */
+class ChartPreview : public QWidget
+{
+    Q_OBJECT
+
+public:
+    explicit ChartPreview(QWidget* parent = 0);
+
+    QSize sizeHint() const;
+
+    void setChartLayout(const ChartLayout& layout);
+
+protected:
+    void paintEvent(QPaintEvent* event);
+
+private:
+    //in chart coordinates.
+    QVector<QLineF> mLines;
+    QRectF mBounds;
+};
+
+#endif // CHARTPREVIEW_H
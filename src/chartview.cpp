@@ -24,13 +24,35 @@
 #include <QDebug>
 #include <QScrollBar>
 #include <QGLWidget>
+#include <QTimer>
+#include <QPainter>
+#include <QPaintEvent>
+#include <QGestureEvent>
+#include <QPinchGesture>
+
+#include "scene.h"
+
+//how long the zoom input has to stop before the view is repainted at full quality.
+#define INTERACTIVE_ZOOM_DELAY 150
+//how much of the viewport size is rendered around it into the layer cache so scrolling can reuse it.
+#define LAYER_CACHE_MARGIN 0.25
 
 ChartView::ChartView(QWidget* parent)
-    : QGraphicsView(parent)
-	
+    : QGraphicsView(parent),
+    mInteractiveZoom(false),
+    mZoomTimer(new QTimer(this)),
+    mPinchStartZoom(1.0),
+    mLayerCacheValid(false),
+    mLayerCacheVersion(0)
 {
 	setAcceptDrops(true);
 	//update();
+
+    mZoomTimer->setSingleShot(true);
+    mZoomTimer->setInterval(INTERACTIVE_ZOOM_DELAY);
+    connect(mZoomTimer, SIGNAL(timeout()), SLOT(endInteractiveZoom()));
+
+    viewport()->grabGesture(Qt::PinchGesture);
 }
 
 ChartView::~ChartView()
@@ -105,12 +127,179 @@ void ChartView::mouseReleaseEvent(QMouseEvent* event)
 
 void ChartView::wheelEvent(QWheelEvent* event)
 {
-    if (event->modifiers() && Qt::CTRL)
+    if (event->modifiers() && Qt::CTRL) {
+        beginInteractiveZoom();
         zoom(event->delta());
-    else
+    } else
         QGraphicsView::wheelEvent(event);
 }
 
+bool ChartView::viewportEvent(QEvent* event)
+{
+    if(event->type() == QEvent::Gesture) {
+        gestureEvent(static_cast<QGestureEvent*>(event));
+        return true;
+    }
+
+    return QGraphicsView::viewportEvent(event);
+}
+
+void ChartView::gestureEvent(QGestureEvent* event)
+{
+    QPinchGesture* pinch = static_cast<QPinchGesture*>(event->gesture(Qt::PinchGesture));
+    if(!pinch)
+        return;
+
+    if(pinch->state() == Qt::GestureStarted)
+        mPinchStartZoom = transform().m11();
+
+    if(pinch->changeFlags() & QPinchGesture::ScaleFactorChanged) {
+        beginInteractiveZoom();
+        //scale from where the pinch started so small steps don't get rounded away.
+        setZoom(mPinchStartZoom * pinch->totalScaleFactor());
+        emit zoomLevelChanged(transform().m11()*100);
+    }
+
+    event->accept(pinch);
+}
+
+void ChartView::beginInteractiveZoom()
+{
+    //keep the full quality repaint waiting until the input stops.
+    mZoomTimer->start();
+
+    if(mInteractiveZoom)
+        return;
+
+    //scale what was painted last instead of rendering the viewport again.
+    mZoomPixmap = mLastFrame;
+    mZoomSceneRect = mapToScene(viewport()->rect()).boundingRect();
+
+    mInteractiveZoom = true;
+}
+
+void ChartView::endInteractiveZoom()
+{
+    if(!mInteractiveZoom)
+        return;
+
+    mInteractiveZoom = false;
+    mZoomPixmap = QPixmap();
+
+    viewport()->update();
+}
+
+void ChartView::paintEvent(QPaintEvent* event)
+{
+    if(mInteractiveZoom && !mZoomPixmap.isNull()) {
+        //draw the old viewport where its part of the scene is now,
+        //unfiltered, the full quality repaint follows when the zoom ends.
+        QRect target = mapFromScene(mZoomSceneRect).boundingRect();
+
+        QPainter p(viewport());
+        p.fillRect(event->rect(), QColor(212,212,212));
+        p.drawPixmap(target, mZoomPixmap);
+        return;
+    }
+
+    if(mLastFrame.size() != viewport()->size()) {
+        mLastFrame = QPixmap(viewport()->size());
+        //the copy is only whole once all of the viewport has been painted into it.
+        if(event->rect() != viewport()->rect())
+            viewport()->update();
+    }
+
+    //paint the exposed part into the copy of the viewport and show it from there.
+    QPainter fill(&mLastFrame);
+    fill.setClipRegion(event->region());
+    fill.fillRect(mLastFrame.rect(), viewport()->palette().brush(viewport()->backgroundRole()));
+    fill.end();
+
+    QPainter::setRedirected(viewport(), &mLastFrame);
+    QGraphicsView::paintEvent(event);
+    QPainter::restoreRedirected(viewport());
+
+    QPainter p(viewport());
+    foreach(const QRect& r, event->region().rects())
+        p.drawPixmap(r, mLastFrame, r);
+}
+
+void ChartView::scrollContentsBy(int dx, int dy)
+{
+    QGraphicsView::scrollContentsBy(dx, dy);
+
+    //keep the copy of the viewport in step with the pixels scrolled on screen.
+    if(!mLastFrame.isNull())
+        mLastFrame.scroll(isRightToLeft() ? -dx : dx, dy, mLastFrame.rect());
+}
+
+void ChartView::drawBackground(QPainter* painter, const QRectF& rect)
+{
+    QGraphicsView::drawBackground(painter, rect);
+
+    Scene* s = qobject_cast<Scene*>(scene());
+    if(!s || s->layerCacheView() != this)
+        return;
+
+    //the items stacked below the cells stay below the cached layers.
+    s->drawBelowLayerCache(painter, rect);
+
+    QTransform t = viewportTransform();
+    QTransform scale(t.m11(), t.m12(), t.m21(), t.m22(), 0, 0);
+    QRectF visible = mapToScene(viewport()->rect()).boundingRect();
+
+    if(!mLayerCacheValid || mLayerCacheVersion != s->layerCacheVersion() ||
+            mLayerCacheScale != scale || !mLayerCacheSceneRect.contains(visible))
+        updateLayerCache();
+
+    if(mLayerCache.isNull())
+        return;
+
+    //blit the cache in viewport coordinates so it isn't scaled again.
+    painter->save();
+    painter->setWorldTransform(QTransform());
+    painter->drawImage(t.map(mLayerCacheSceneRect.topLeft()), mLayerCache);
+    painter->restore();
+}
+
+void ChartView::updateLayerCache()
+{
+    Scene* s = qobject_cast<Scene*>(scene());
+    if(!s)
+        return;
+
+    QTransform t = viewportTransform();
+    mLayerCacheScale = QTransform(t.m11(), t.m12(), t.m21(), t.m22(), 0, 0);
+    mLayerCacheVersion = s->layerCacheVersion();
+    mLayerCacheValid = true;
+
+    QRectF visible = mapToScene(viewport()->rect()).boundingRect();
+    qreal dx = visible.width() * LAYER_CACHE_MARGIN;
+    qreal dy = visible.height() * LAYER_CACHE_MARGIN;
+
+    QRect device = mLayerCacheScale.mapRect(visible.adjusted(-dx, -dy, dx, dy)).toAlignedRect();
+    if(device.isEmpty()) {
+        mLayerCache = QImage();
+        mLayerCacheSceneRect = QRectF();
+        return;
+    }
+
+    //the scene area covered by the whole pixels of the image.
+    mLayerCacheSceneRect = mLayerCacheScale.inverted().mapRect(QRectF(device));
+
+    mLayerCache = QImage(device.size(), QImage::Format_ARGB32_Premultiplied);
+    mLayerCache.fill(0);
+
+    QPainter p(&mLayerCache);
+    p.setRenderHints(renderHints());
+    p.setWorldTransform(mLayerCacheScale * QTransform::fromTranslate(-device.left(), -device.top()));
+    int drawn = s->drawInactiveLayers(&p, mLayerCacheSceneRect);
+    p.end();
+
+    if(drawn == 0)
+        mLayerCache = QImage();
+}
+
 void ChartView::zoomIn()
 {
     zoomLevel((transform().m11()*100) + 5);
@@ -133,9 +322,17 @@ void ChartView::zoom(int mouseDelta)
 
 void ChartView::zoomLevel(int percent)
 {
-    qreal pcent = percent / 100.0;
-    if(pcent <= 0)
-        pcent = 0.01;
-    qreal diff = pcent / transform().m11();
+    setZoom(percent / 100.0);
+}
+
+void ChartView::setZoom(qreal factor)
+{
+    if(factor <= 0)
+        factor = 0.01;
+    qreal diff = factor / transform().m11();
     scale(diff, diff);
+
+    //the scaled pixmap only covers what's changed, redraw all of it.
+    if(mInteractiveZoom)
+        viewport()->update();
 }
\ No newline at end of file
@@ -22,6 +22,11 @@
 #define CHARTVIEW_H
 
 #include <QGraphicsView>
+#include <QPixmap>
+#include <QImage>
+
+class QTimer;
+class QGestureEvent;
 
 /**
  * The default view on the ChartScene.
@@ -55,9 +60,52 @@ protected:
     void mousePressEvent(QMouseEvent* event);
     void mouseReleaseEvent(QMouseEvent* event);
     void wheelEvent(QWheelEvent* event);
-    
+    void paintEvent(QPaintEvent* event);
+    void scrollContentsBy(int dx, int dy);
+    bool viewportEvent(QEvent* event);
+    void drawBackground(QPainter* painter, const QRectF& rect);
+
+private slots:
+    /**
+     * Leave the interactive zoom and repaint the view at full quality.
+     */
+    void endInteractiveZoom();
+
 private:
+    /**
+     * While the wheel or a pinch is zooming the view the last rendered viewport is
+     * scaled instead of repainting the scene. The scene is repainted once the input stops.
+     */
+    void beginInteractiveZoom();
+    void gestureEvent(QGestureEvent* event);
+    //zoomLevel() without rounding to whole percents, 1.0 is 100%.
+    void setZoom(qreal factor);
+
+    bool mInteractiveZoom;
+    //the viewport as it was rendered when the zoom started.
+    QPixmap mZoomPixmap;
+    //the part of the scene shown in mZoomPixmap.
+    QRectF mZoomSceneRect;
+    //a copy of the viewport as it was last painted, see paintEvent().
+    QPixmap mLastFrame;
+    QTimer* mZoomTimer;
+    //the zoom when the current pinch started.
+    qreal mPinchStartZoom;
+
+    /**
+     * Render the layers that aren't being edited for the visible part of the scene
+     * and some margin around it, at the resolution of the viewport.
+     */
+    void updateLayerCache();
 
+    bool mLayerCacheValid;
+    //null when there's nothing to draw from the cache.
+    QImage mLayerCache;
+    //the part of the scene in mLayerCache.
+    QRectF mLayerCacheSceneRect;
+    //the zoom and rotation of the view when the cache was rendered.
+    QTransform mLayerCacheScale;
+    quint64 mLayerCacheVersion;
 };
 
 #endif //CHARTVIEW_H
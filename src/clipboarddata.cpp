@@ -0,0 +1,181 @@
+/****************************************************************************\
+ Copyright (c) 2011-2014 Stitch Works Software
+ Brian C. Milco <bcmilco@gmail.com>
+
+ This file is part of Crochet Charts.
+
+ Crochet Charts is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ Crochet Charts is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with Crochet Charts. If not, see <http://www.gnu.org/licenses/>.
+
+ \****************************************************************************/
+#include "clipboarddata.h"
+
+#include "cell.h"
+#include "indicator.h"
+#include "itemgroup.h"
+#include "ChartImage.h"
+#include "debug.h"
+
+#include <QDataStream>
+
+ClipboardItem::ClipboardItem()
+    : type(0),
+    color(0),
+    bgColor(0),
+    layer(0),
+    rotation(0),
+    scaleX(1),
+    scaleY(1)
+{
+}
+
+static void encodeItem(QDataStream& stream, const ClipboardItem& item)
+{
+    stream << item.type;
+
+    switch(item.type) {
+        case Cell::Type:
+            stream << item.name << QColor::fromRgba(item.color) << QColor::fromRgba(item.bgColor)
+                << item.rotation << item.rotationPivot << item.scaleX << item.scaleY
+                << item.scalePivot << item.transformOrigin << item.pos;
+            break;
+        case Indicator::Type:
+            stream << item.pos << item.name << item.rotation << item.rotationPivot
+                << item.scaleX << item.scaleY << item.scalePivot;
+            break;
+        case ItemGroup::Type:
+            stream << item.pos << item.children.count() << item.rotation << item.rotationPivot
+                << item.scaleX << item.scaleY << item.scalePivot;
+            foreach(const ClipboardItem& child, item.children)
+                encodeItem(stream, child);
+            break;
+        case ChartImage::Type:
+            stream << item.name << item.pos << item.rotation << item.rotationPivot
+                << item.scaleX << item.scaleY << item.scalePivot;
+            break;
+        default:
+            WARN("Unknown data type: " + QString::number(item.type));
+            break;
+    }
+}
+
+static bool decodeItem(QDataStream& stream, ClipboardItem& item)
+{
+    stream >> item.type;
+
+    switch(item.type) {
+        case Cell::Type: {
+            QColor color, bgColor;
+            stream >> item.name >> color >> bgColor >> item.rotation >> item.rotationPivot
+                >> item.scaleX >> item.scaleY >> item.scalePivot >> item.transformOrigin >> item.pos;
+            item.color = color.rgba();
+            item.bgColor = bgColor.rgba();
+            break;
+        }
+        case Indicator::Type:
+            stream >> item.pos >> item.name >> item.rotation >> item.rotationPivot
+                >> item.scaleX >> item.scaleY >> item.scalePivot;
+            break;
+        case ItemGroup::Type: {
+            int count = 0;
+            stream >> item.pos >> count >> item.rotation >> item.rotationPivot
+                >> item.scaleX >> item.scaleY >> item.scalePivot;
+            for(int i = 0; i < count && stream.status() == QDataStream::Ok; ++i) {
+                ClipboardItem child;
+                if(decodeItem(stream, child))
+                    item.children.append(child);
+            }
+            break;
+        }
+        case ChartImage::Type:
+            stream >> item.name >> item.pos >> item.rotation >> item.rotationPivot
+                >> item.scaleX >> item.scaleY >> item.scalePivot;
+            break;
+        default:
+            //the rest of the stream can't be read without knowing the size of this item.
+            WARN("Unknown data type: " + QString::number(item.type));
+            stream.setStatus(QDataStream::ReadCorruptData);
+            return false;
+    }
+
+    return stream.status() == QDataStream::Ok;
+}
+
+ClipboardData::ClipboardData(const QList<ClipboardItem>& items)
+    : QMimeData(),
+    mItems(items)
+{
+}
+
+QStringList ClipboardData::formats() const
+{
+    return QStringList() << mimeType();
+}
+
+bool ClipboardData::hasFormat(const QString& mimetype) const
+{
+    return mimetype == mimeType();
+}
+
+QVariant ClipboardData::retrieveData(const QString& mimetype, QVariant::Type type) const
+{
+    if(mimetype != mimeType())
+        return QMimeData::retrieveData(mimetype, type);
+
+    if(mEncoded.isEmpty())
+        mEncoded = encode(mItems);
+    return mEncoded;
+}
+
+QList<ClipboardItem> ClipboardData::items(const QMimeData* data)
+{
+    if(!data)
+        return QList<ClipboardItem>();
+
+    const ClipboardData* own = qobject_cast<const ClipboardData*>(data);
+    if(own)
+        return own->items();
+
+    if(!data->hasFormat(mimeType()))
+        return QList<ClipboardItem>();
+
+    return decode(data->data(mimeType()));
+}
+
+QByteArray ClipboardData::encode(const QList<ClipboardItem>& items)
+{
+    QByteArray data;
+    QDataStream stream(&data, QIODevice::WriteOnly);
+
+    stream << items.count();
+    foreach(const ClipboardItem& item, items)
+        encodeItem(stream, item);
+
+    return data;
+}
+
+QList<ClipboardItem> ClipboardData::decode(const QByteArray& data)
+{
+    QList<ClipboardItem> items;
+    QDataStream stream(data);
+
+    int count = 0;
+    stream >> count;
+    for(int i = 0; i < count && stream.status() == QDataStream::Ok; ++i) {
+        ClipboardItem item;
+        if(decodeItem(stream, item))
+            items.append(item);
+    }
+
+    return items;
+}
@@ -0,0 +1,97 @@
+/****************************************************************************\
+ Copyright (c) 2011-2014 Stitch Works Software
+ Brian C. Milco <bcmilco@gmail.com>
+
+ This file is part of Crochet Charts.
+
+ Crochet Charts is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ Crochet Charts is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with Crochet Charts. If not, see <http://www.gnu.org/licenses/>.
+
+ \****************************************************************************/
+#ifndef CLIPBOARDDATA_H
+#define CLIPBOARDDATA_H
+
+#include <QMimeData>
+#include <QColor>
+#include <QPointF>
+#include <QList>
+#include <QString>
+#include <QStringList>
+
+/**
+ * A copied chart item with the values needed to create it again.
+ */
+struct ClipboardItem
+{
+    ClipboardItem();
+
+    int type;
+    //the stitch of a cell, the text of an indicator or the file of an image.
+    QString name;
+    QRgb color;
+    QRgb bgColor;
+    //the layer the item was copied from, it isn't streamed.
+    unsigned int layer;
+
+    QPointF pos;
+    QPointF transformOrigin;
+    qreal rotation;
+    QPointF rotationPivot;
+    qreal scaleX;
+    qreal scaleY;
+    QPointF scalePivot;
+
+    //the items in a group.
+    QList<ClipboardItem> children;
+};
+
+/**
+ * The chart items put on the clipboard by copy.
+ *
+ * The items are kept as they are and a paste in the same process uses them
+ * directly. They're only turned into the application/crochet-cells stream
+ * when something asks for that format, ie another running copy of the program.
+ */
+class ClipboardData : public QMimeData
+{
+    Q_OBJECT
+public:
+    explicit ClipboardData(const QList<ClipboardItem>& items);
+
+    static const char* mimeType() { return "application/crochet-cells"; }
+
+    const QList<ClipboardItem>& items() const { return mItems; }
+
+    QStringList formats() const;
+    bool hasFormat(const QString& mimetype) const;
+
+    /**
+     * The items in mime data from the clipboard, read from the stream if it
+     * wasn't put there by this process.
+     */
+    static QList<ClipboardItem> items(const QMimeData* data);
+
+    static QByteArray encode(const QList<ClipboardItem>& items);
+    static QList<ClipboardItem> decode(const QByteArray& data);
+
+protected:
+    QVariant retrieveData(const QString& mimetype, QVariant::Type type) const;
+
+private:
+    const QList<ClipboardItem> mItems;
+
+    //filled in the first time the stream is asked for.
+    mutable QByteArray mEncoded;
+};
+
+#endif // CLIPBOARDDATA_H
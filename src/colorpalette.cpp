@@ -0,0 +1,285 @@
+/****************************************************************************\
+ Copyright (c) 2011-2014 Stitch Works Software
+ Brian C. Milco <bcmilco@gmail.com>
+
+ This file is part of Crochet Charts.
+
+ Crochet Charts is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ Crochet Charts is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with Crochet Charts. If not, see <http://www.gnu.org/licenses/>.
+
+ \****************************************************************************/
+#include "colorpalette.h"
+
+#include <QObject>
+#include <QDebug>
+
+ColorPalette::ColorPalette()
+    : mCurrent(0),
+    mNextColorwayId(1)
+{
+    static int lastId = 0;
+    mId = ++lastId;
+
+    Colorway main;
+    main.id = 0;
+    main.name = QObject::tr("Main");
+    mColorways.append(main);
+}
+
+ColorPalette* ColorPalette::loose()
+{
+    //never deleted so cells destroyed during shutdown can still use it.
+    static ColorPalette* palette = new ColorPalette();
+    return palette;
+}
+
+bool ColorPalette::isValid(int colorway, int index) const
+{
+    if(colorway < 0 || colorway >= mColorways.count()) {
+        qWarning() << "ColorPalette: no colorway" << colorway;
+        return false;
+    }
+
+    if(index < 0 || index >= count()) {
+        qWarning() << "ColorPalette: no entry" << index;
+        return false;
+    }
+
+    return true;
+}
+
+int ColorPalette::add(QRgb color)
+{
+    QHash<QRgb, int>::const_iterator i = mLookup.constFind(color);
+    if(i != mLookup.constEnd())
+        return i.value();
+
+    int index = count();
+    for(int c = 0; c < mColorways.count(); ++c)
+        mColorways[c].colors.append(color);
+    mLookup.insert(color, index);
+    return index;
+}
+
+int ColorPalette::indexOf(QRgb color) const
+{
+    return mLookup.value(color, -1);
+}
+
+QList<int> ColorPalette::indexesOf(QRgb color) const
+{
+    QList<int> indexes;
+    const QVector<QRgb>& colors = current();
+    for(int i = 0; i < colors.count(); ++i) {
+        if(colors.at(i) == color)
+            indexes.append(i);
+    }
+    return indexes;
+}
+
+QRgb ColorPalette::color(int index) const
+{
+    if(!isValid(mCurrent, index))
+        return QColor(Qt::black).rgba();
+
+    return current().at(index);
+}
+
+void ColorPalette::setColor(int index, QRgb color)
+{
+    if(!isValid(mCurrent, index))
+        return;
+
+    QVector<QRgb>& colors = mColorways[mCurrent].colors;
+    QRgb old = colors.at(index);
+    if(old == color)
+        return;
+
+    colors[index] = color;
+
+    if(mLookup.value(old, -1) == index) {
+        mLookup.remove(old);
+        //another entry might still have the old color.
+        int other = colors.indexOf(old);
+        if(other != -1)
+            mLookup.insert(old, other);
+    }
+
+    if(!mLookup.contains(color))
+        mLookup.insert(color, index);
+}
+
+int ColorPalette::addColorway(const QString& name)
+{
+    Colorway colorway;
+    colorway.id = mNextColorwayId++;
+    colorway.name = name;
+    colorway.colors = current();
+    mColorways.append(colorway);
+    return mColorways.count() - 1;
+}
+
+void ColorPalette::removeColorway(int colorway)
+{
+    if(mColorways.count() <= 1 || colorway < 0 || colorway >= mColorways.count()) {
+        qWarning() << "ColorPalette: can't remove colorway" << colorway;
+        return;
+    }
+
+    mColorways.removeAt(colorway);
+
+    if(colorway == mCurrent) {
+        mCurrent = 0;
+        rebuildLookup();
+    } else if(colorway < mCurrent) {
+        --mCurrent;
+    }
+}
+
+int ColorPalette::colorwayId(int colorway) const
+{
+    if(colorway < 0 || colorway >= mColorways.count())
+        return -1;
+    return mColorways.at(colorway).id;
+}
+
+int ColorPalette::findColorway(int id) const
+{
+    for(int c = 0; c < mColorways.count(); ++c) {
+        if(mColorways.at(c).id == id)
+            return c;
+    }
+    return -1;
+}
+
+QVector<QRgb> ColorPalette::colorwayColors(int colorway) const
+{
+    if(colorway < 0 || colorway >= mColorways.count())
+        return QVector<QRgb>();
+    return mColorways.at(colorway).colors;
+}
+
+void ColorPalette::insertColorway(int colorway, int id, const QString& name, const QVector<QRgb>& colors)
+{
+    if(id < 0 || findColorway(id) != -1) {
+        qWarning() << "ColorPalette: can't insert colorway" << id;
+        return;
+    }
+
+    Colorway c;
+    c.id = id;
+    c.name = name;
+    c.colors = colors;
+    c.colors.resize(count());
+    for(int i = colors.count(); i < count(); ++i)
+        c.colors[i] = current().at(i);
+
+    colorway = qBound(0, colorway, mColorways.count());
+    mColorways.insert(colorway, c);
+    if(colorway <= mCurrent)
+        ++mCurrent;
+    if(id >= mNextColorwayId)
+        mNextColorwayId = id + 1;
+}
+
+QString ColorPalette::colorwayName(int colorway) const
+{
+    if(colorway < 0 || colorway >= mColorways.count())
+        return QString();
+    return mColorways.at(colorway).name;
+}
+
+void ColorPalette::setColorwayName(int colorway, const QString& name)
+{
+    if(colorway < 0 || colorway >= mColorways.count())
+        return;
+    mColorways[colorway].name = name;
+}
+
+void ColorPalette::setCurrentColorway(int colorway)
+{
+    if(colorway < 0 || colorway >= mColorways.count()) {
+        qWarning() << "ColorPalette: no colorway" << colorway;
+        return;
+    }
+
+    if(colorway == mCurrent)
+        return;
+
+    mCurrent = colorway;
+    rebuildLookup();
+}
+
+QRgb ColorPalette::colorwayColor(int colorway, int index) const
+{
+    if(!isValid(colorway, index))
+        return QColor(Qt::black).rgba();
+
+    return mColorways.at(colorway).colors.at(index);
+}
+
+void ColorPalette::setColorwayColor(int colorway, int index, QRgb color)
+{
+    if(colorway == mCurrent) {
+        setColor(index, color);
+        return;
+    }
+
+    if(!isValid(colorway, index))
+        return;
+
+    mColorways[colorway].colors[index] = color;
+}
+
+QVector<QRgb> ColorPalette::entry(int index) const
+{
+    QVector<QRgb> colors;
+    if(!isValid(mCurrent, index))
+        return colors;
+
+    colors.reserve(mColorways.count());
+    foreach(const Colorway& colorway, mColorways)
+        colors.append(colorway.colors.at(index));
+    return colors;
+}
+
+int ColorPalette::addEntry(const QVector<QRgb>& colors)
+{
+    if(colors.count() != mColorways.count()) {
+        qWarning() << "ColorPalette: entry has" << colors.count() << "colorways, expected" << mColorways.count();
+        return add(colors.value(mCurrent, QColor(Qt::black).rgba()));
+    }
+
+    foreach(int index, indexesOf(colors.at(mCurrent))) {
+        if(entry(index) == colors)
+            return index;
+    }
+
+    int index = count();
+    for(int c = 0; c < mColorways.count(); ++c)
+        mColorways[c].colors.append(colors.at(c));
+    if(!mLookup.contains(colors.at(mCurrent)))
+        mLookup.insert(colors.at(mCurrent), index);
+    return index;
+}
+
+void ColorPalette::rebuildLookup()
+{
+    mLookup.clear();
+
+    const QVector<QRgb>& colors = current();
+    for(int i = 0; i < colors.count(); ++i) {
+        if(!mLookup.contains(colors.at(i)))
+            mLookup.insert(colors.at(i), i);
+    }
+}
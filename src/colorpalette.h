@@ -0,0 +1,139 @@
+/****************************************************************************\
+ Copyright (c) 2011-2014 Stitch Works Software
+ Brian C. Milco <bcmilco@gmail.com>
+
+ This file is part of Crochet Charts.
+
+ Crochet Charts is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ Crochet Charts is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with Crochet Charts. If not, see <http://www.gnu.org/licenses/>.
+
+ \****************************************************************************/
+#ifndef COLORPALETTE_H
+#define COLORPALETTE_H
+
+#include <QColor>
+#include <QVector>
+#include <QHash>
+#include <QList>
+#include <QString>
+
+/**
+ * The colors used by the cells of a chart.
+ *
+ * Cells keep the index of their colors in the palette of the scene they are in,
+ * so changing a palette entry recolors every cell using it at once.
+ * Entries are never removed, an index stays valid for as long as the palette exists.
+ *
+ * A palette can have several colorways, each one a full set of colors for the entries.
+ * Switching colorways changes the colors of the palette without touching the cells.
+ */
+class ColorPalette
+{
+public:
+    ColorPalette();
+
+    /**
+     * Returns the index of an entry with the color, adding one if there isn't one yet.
+     */
+    int add(QRgb color);
+
+    /**
+     * The index of an entry with the color or -1.
+     */
+    int indexOf(QRgb color) const;
+
+    /**
+     * Every entry with the color, more than one entry can end up with the
+     * same color when entries are changed.
+     */
+    QList<int> indexesOf(QRgb color) const;
+
+    QRgb color(int index) const;
+    void setColor(int index, QRgb color);
+
+    int count() const { return current().count(); }
+
+    /**
+     * There is always at least one colorway. New colorways start out with the
+     * colors of the current one and new entries get the same color in every colorway.
+     */
+    int colorwayCount() const { return mColorways.count(); }
+    int addColorway(const QString& name);
+    void removeColorway(int colorway);
+
+    /**
+     * Colorways are listed by position, which changes when an earlier one is removed.
+     * The id of a colorway never changes and isn't reused, so undo commands keep the id.
+     * findColorway() returns the position of the colorway with the id or -1.
+     */
+    int colorwayId(int colorway) const;
+    int findColorway(int id) const;
+
+    /**
+     * The colors of every entry in a colorway, used to put a removed colorway back with
+     * insertColorway(). Entries added since it was removed get the current color.
+     */
+    QVector<QRgb> colorwayColors(int colorway) const;
+    void insertColorway(int colorway, int id, const QString& name, const QVector<QRgb>& colors);
+
+    QString colorwayName(int colorway) const;
+    void setColorwayName(int colorway, const QString& name);
+
+    int currentColorway() const { return mCurrent; }
+    void setCurrentColorway(int colorway);
+
+    QRgb colorwayColor(int colorway, int index) const;
+    void setColorwayColor(int colorway, int index, QRgb color);
+
+    /**
+     * The colors of an entry in every colorway.
+     */
+    QVector<QRgb> entry(int index) const;
+
+    /**
+     * Returns the index of an entry with these colors in every colorway,
+     * adding one if there isn't one yet.
+     */
+    int addEntry(const QVector<QRgb>& colors);
+
+    /**
+     * Tells palettes apart, unlike an address it isn't reused by a later palette.
+     */
+    int id() const { return mId; }
+
+    /**
+     * The palette used by cells that aren't in a scene.
+     */
+    static ColorPalette* loose();
+
+private:
+    struct Colorway {
+        int id;
+        QString name;
+        QVector<QRgb> colors;
+    };
+
+    const QVector<QRgb>& current() const { return mColorways.at(mCurrent).colors; }
+    bool isValid(int colorway, int index) const;
+    void rebuildLookup();
+
+    QList<Colorway> mColorways;
+    int mCurrent;
+    int mId;
+    int mNextColorwayId;
+
+    //the entry add() returns for each color of the current colorway.
+    QHash<QRgb, int> mLookup;
+};
+
+#endif // COLORPALETTE_H
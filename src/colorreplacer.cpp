@@ -27,14 +27,17 @@
 #include <QColorDialog>
 
 #include "colorlistwidget.h"
+#include "scene.h"
 
-ColorReplacer::ColorReplacer(QList<QString> colorList, QWidget *parent) :
+ColorReplacer::ColorReplacer(QList<QString> colorList, Scene *scene, QWidget *parent) :
     QDialog(parent),
 	selection(3),
     ui(new Ui::ColorReplacer),
-    mOriginalColorList(colorList)
+    mOriginalColorList(colorList),
+    mScene(scene)
 {
     ui->setupUi(this);
+    ui->matchCount->setVisible(mScene != 0);
 
     if(mOriginalColorList.isEmpty()) {
         QPushButton *ok = ui->buttonBox->button(QDialogButtonBox::Ok);
@@ -80,11 +83,14 @@ void ColorReplacer::setSelection()
     else if(sender() == ui->backgroundOnly)
         selection = 2;
 
+    updateMatchCount();
+
 }
 
 void ColorReplacer::origColorChanged(QString color)
 {
     originalColor = QColor(color);
+    updateMatchCount();
 }
 
 void ColorReplacer::newColorChanged(QString color)
@@ -127,3 +133,14 @@ void ColorReplacer::populateColorLists()
 
     ui->newColor->addItem(tr("More colors..."));
 }
+
+void ColorReplacer::updateMatchCount()
+{
+    if(!mScene || !originalColor.isValid())
+        return;
+
+    bool foreground = (selection == 1 || selection == 3);
+    bool background = (selection == 2 || selection == 3);
+    int count = mScene->cellsWithColor(originalColor, foreground, background).count();
+    ui->matchCount->setText(tr("%n stitch(es) will change.", "", count));
+}
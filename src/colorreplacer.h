@@ -23,6 +23,8 @@
 
 #include <QDialog>
 
+class Scene;
+
 namespace Ui {
 class ColorReplacer;
 }
@@ -32,7 +34,10 @@ class ColorReplacer : public QDialog
     Q_OBJECT
     
 public:
-    explicit ColorReplacer(QList<QString> colorList, QWidget *parent = 0);
+    /**
+     * When a scene is given the dialog shows how many of its cells will change.
+     */
+    explicit ColorReplacer(QList<QString> colorList, Scene *scene = 0, QWidget *parent = 0);
     ~ColorReplacer();
     
     QColor originalColor;
@@ -52,6 +57,9 @@ private:
     QList<QString> mOriginalColorList;
 
     void populateColorLists();
+
+    Scene *mScene;
+    void updateMatchCount();
 };
 
 #endif // COLORREPLACER_H
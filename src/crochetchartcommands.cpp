@@ -21,9 +21,18 @@
 #include "crochetchartcommands.h"
 #include "ChartItemTools.h"
 #include "settings.h"
+#include "stitchlibrary.h"
 #include <QDebug>
 #include <QObject>
 
+//edits of the same items closer together than this (in ms) are undone in one step.
+static const int mergeInterval = 1000;
+
+static bool canMerge(const QElapsedTimer &lastChange)
+{
+    return lastChange.isValid() && lastChange.elapsed() <= mergeInterval;
+}
+
 /*************************************************\
 | SetIndicatorText                                   |
 \*************************************************/
@@ -139,9 +148,10 @@ SetCellBgColor::SetCellBgColor(Cell* cell, QColor newCl, QUndoCommand* parent)
     : QUndoCommand(parent)
 {
     c = cell;
-    oldColor = c->bgColor();
+    oldIndex = c->bgColorIndex();
     newColor = newCl;
     setText(QObject::tr("change background color"));
+    mTime.start();
 }
 
 void SetCellBgColor::redo()
@@ -151,7 +161,18 @@ void SetCellBgColor::redo()
 
 void SetCellBgColor::undo()
 {
-    setBgColor(c, oldColor);
+    c->setBgColorIndex(oldIndex);
+}
+
+bool SetCellBgColor::mergeWith(const QUndoCommand *command)
+{
+    const SetCellBgColor *other = static_cast<const SetCellBgColor*>(command);
+    if(other->c != c || !canMerge(mTime))
+        return false;
+
+    newColor = other->newColor;
+    mTime.restart();
+    return true;
 }
 
 void SetCellBgColor::setBgColor(Cell *cell, QColor color)
@@ -166,9 +187,10 @@ SetCellColor::SetCellColor(Cell *cell, QColor newCl, QUndoCommand *parent)
     : QUndoCommand(parent)
 {
     c = cell;
-    oldColor = c->color();
+    oldIndex = c->colorIndex();
     newColor = newCl;
     setText(QObject::tr("change stitch color"));
+    mTime.start();
 }
 
 void SetCellColor::redo()
@@ -178,7 +200,18 @@ void SetCellColor::redo()
 
 void SetCellColor::undo()
 {
-    setColor(c, oldColor);
+    c->setColorIndex(oldIndex);
+}
+
+bool SetCellColor::mergeWith(const QUndoCommand *command)
+{
+    const SetCellColor *other = static_cast<const SetCellColor*>(command);
+    if(other->c != c || !canMerge(mTime))
+        return false;
+
+    newColor = other->newColor;
+    mTime.restart();
+    return true;
 }
 
 void SetCellColor::setColor(Cell *cell, QColor color)
@@ -197,6 +230,7 @@ SetItemRotation::SetItemRotation(QGraphicsItem *item, qreal oldAngl, QPointF piv
     newAngle = ChartItemTools::getRotation(item);
     pvtPt = pivotPt;
     setText(QObject::tr("rotate item"));
+    mTime.start();
 }
 
 void SetItemRotation::redo()
@@ -209,6 +243,17 @@ void SetItemRotation::undo()
     setRotation(i, oldAngle, pvtPt);
 }
 
+bool SetItemRotation::mergeWith(const QUndoCommand *command)
+{
+    const SetItemRotation *other = static_cast<const SetItemRotation*>(command);
+    if(other->i != i || other->pvtPt != pvtPt || !canMerge(mTime))
+        return false;
+
+    newAngle = other->newAngle;
+    mTime.restart();
+    return true;
+}
+
 void SetItemRotation::setRotation(QGraphicsItem *item, qreal angle, QPointF pivot)
 {
     //item->setTransformOriginPoint(pivot);
@@ -279,6 +324,7 @@ SetItemCoordinates::SetItemCoordinates(QGraphicsItem *item, QPointF oldPos, QUnd
     oldCoord = oldPos;
     newCoord = i->pos();
     setText(QObject::tr("change item position"));
+    mTime.start();
 }
 
 void SetItemCoordinates::undo()
@@ -291,6 +337,17 @@ void SetItemCoordinates::redo()
     setPosition(i, newCoord);
 }
 
+bool SetItemCoordinates::mergeWith(const QUndoCommand *command)
+{
+    const SetItemCoordinates *other = static_cast<const SetItemCoordinates*>(command);
+    if(other->i != i || !canMerge(mTime))
+        return false;
+
+    newCoord = other->newCoord;
+    mTime.restart();
+    return true;
+}
+
 void SetItemCoordinates::setPosition(QGraphicsItem *item, QPointF position)
 {
     item->setPos(position);
@@ -307,6 +364,7 @@ SetItemScale::SetItemScale(QGraphicsItem *item, QPointF oldScle, QPointF pivotPt
     newScale = QPointF(ChartItemTools::getScaleX(i), ChartItemTools::getScaleY(i));
     oldScale = oldScle;
     setText(QObject::tr("change item scale"));
+    mTime.start();
 }
 
 void SetItemScale::undo()
@@ -319,11 +377,21 @@ void SetItemScale::redo()
     setScale(i, newScale, mPivot);
 }
 
+bool SetItemScale::mergeWith(const QUndoCommand *command)
+{
+    const SetItemScale *other = static_cast<const SetItemScale*>(command);
+    if(other->i != i || other->mPivot != mPivot || !canMerge(mTime))
+        return false;
+
+    newScale = other->newScale;
+    mTime.restart();
+    return true;
+}
+
 void SetItemScale::setScale(QGraphicsItem *item, QPointF scale, QPointF pivot)
 {
 	ChartItemTools::setScalePivot(item, pivot);
-	ChartItemTools::setScaleX(item, scale.x());
-	ChartItemTools::setScaleY(item, scale.y());
+	ChartItemTools::setScale(item, scale);
 }
 
 /*************************************************\
@@ -391,30 +459,84 @@ void RemoveItem::remove(Scene *scene, QGraphicsItem *item)
 | RemoveItems                                     |
 \*************************************************/
 RemoveItems::RemoveItems(Scene *scene, QList<QGraphicsItem*> i, QUndoCommand *parent)
-    : QUndoCommand(parent)
+    : SpillableCommand(parent)
 {
-    items = i;
     s = scene;
+
+    if(i.count() > 1) {
+        QSet<QGraphicsItem*> removing = i.toSet();
+        i.clear();
+        foreach(QGraphicsItem *item, s->items(Qt::AscendingOrder)) {
+            if(removing.contains(item))
+                i.append(item);
+        }
+    }
+
+    mItems.reserve(i.count());
+    mPositions.reserve(i.count());
+    mZValues.reserve(i.count());
+    foreach(QGraphicsItem *item, i) {
+        mItems.append(item);
+        mPositions.append(item->pos());
+        mZValues.append(item->zValue());
+    }
     setText(QObject::tr("remove items"));
-	removegroup = NULL;
-}
-RemoveItems::~RemoveItems()
-{
-	if (removegroup)
-		delete removegroup;
 }
+
 void RemoveItems::redo()
 {
-	removegroup = s->createItemGroup(items);
-    RemoveItem::remove(s, removegroup);
+    restore();
+
+    mGridPositions.clear();
+    mEmptiedRows.clear();
+    mGridPositions.reserve(mItems.count());
+    s->removeItems(mItems.toList(), &mGridPositions, &mEmptiedRows);
 }
 
 void RemoveItems::undo()
 {
-    AddItem::add(s, removegroup);
-	//this call already deletes the itemgroup (according to the QT 4.8 doc. This may have changed in QT 5)
-	s->destroyItemGroup(removegroup);
-	removegroup = NULL;
+    restore();
+
+    s->restoreItems(mItems.toList(), mGridPositions, mEmptiedRows);
+
+    for(int i = 0; i < mItems.count(); ++i) {
+        QGraphicsItem *item = mItems.at(i);
+        item->setZValue(mZValues.at(i));
+
+        if(item->type() == Indicator::Type) {
+            Indicator *ind = qgraphicsitem_cast<Indicator*>(item);
+            ind->setPos(mPositions.at(i));
+            ind->setTextInteractionFlags(Qt::TextEditorInteraction);
+        }
+    }
+}
+
+qint64 RemoveItems::byteSize() const
+{
+    return sizeof(*this) + mItems.capacity() * sizeof(QGraphicsItem*)
+            + mPositions.capacity() * sizeof(QPointF) + mZValues.capacity() * sizeof(qreal)
+            + mGridPositions.capacity() * sizeof(QPoint) + mEmptiedRows.count() * sizeof(int);
+}
+
+void RemoveItems::saveValues(QDataStream &out) const
+{
+    savePointers(out, mItems);
+    out << mPositions << mZValues << mGridPositions << mEmptiedRows;
+}
+
+void RemoveItems::loadValues(QDataStream &in)
+{
+    loadPointers(in, mItems);
+    in >> mPositions >> mZValues >> mGridPositions >> mEmptiedRows;
+}
+
+void RemoveItems::dropValues()
+{
+    mItems = QVector<QGraphicsItem*>();
+    mPositions = QVector<QPointF>();
+    mZValues = QVector<qreal>();
+    mGridPositions = QVector<QPoint>();
+    mEmptiedRows = QList<int>();
 }
 
 /*************************************************\
@@ -480,12 +602,11 @@ AddLayer::~AddLayer()
 void AddLayer::undo()
 {
 	s->removeLayer(mLayer->uid());
-	s->refreshLayers();
 }
 void AddLayer::redo()
 {
 	s->addLayer(mLayer);
-	s->refreshLayers();
+	s->editedLayer(mLayer);
 }
 
 /*************************************************\
@@ -501,12 +622,11 @@ RemoveLayer::RemoveLayer(Scene* scene, ChartLayer* layer, QUndoCommand* parent)
 void RemoveLayer::undo()
 {
 	s->addLayer(mLayer);
-	s->refreshLayers();
+	s->editedLayer(mLayer);
 }
 void RemoveLayer::redo()
 {
 	s->removeLayer(mLayer->uid());
-	s->refreshLayers();
 }
 
 /*************************************************\
@@ -595,4 +715,609 @@ void SetLayerImage::undo()
 void SetLayerImage::redo()
 {
 	c->setLayer(mNew);
-}
\ No newline at end of file
+}
+
+/*************************************************\
+| SetPaletteColor                                 |
+\*************************************************/
+SetPaletteColor::SetPaletteColor(Scene *scene, int index, QColor newCl, QUndoCommand *parent)
+    : QUndoCommand(parent)
+{
+    s = scene;
+    ColorPalette *palette = s->cellPalette();
+    mColorway = palette->colorwayId(palette->currentColorway());
+    mIndex = index;
+    oldColor = QColor::fromRgba(palette->colorwayColor(palette->currentColorway(), index));
+    newColor = newCl;
+    setText(QObject::tr("change palette color"));
+}
+
+void SetPaletteColor::redo()
+{
+    s->setPaletteColor(mColorway, mIndex, newColor);
+}
+
+void SetPaletteColor::undo()
+{
+    s->setPaletteColor(mColorway, mIndex, oldColor);
+}
+
+/*************************************************\
+| AddColorway                                     |
+\*************************************************/
+AddColorway::AddColorway(Scene *scene, const QString& name, QUndoCommand *parent)
+    : QUndoCommand(parent)
+{
+    s = scene;
+    mName = name;
+    mColorway = -1;
+    mPosition = -1;
+    ColorPalette *palette = s->cellPalette();
+    mPrevious = palette->colorwayId(palette->currentColorway());
+    setText(QObject::tr("add colorway"));
+}
+
+void AddColorway::redo()
+{
+    ColorPalette *palette = s->cellPalette();
+    if(mColorway == -1) {
+        mPosition = s->addColorway(mName);
+        mColorway = palette->colorwayId(mPosition);
+    } else {
+        s->insertColorway(mPosition, mColorway, mName, mColors);
+    }
+
+    s->setCurrentColorway(palette->findColorway(mColorway));
+}
+
+void AddColorway::undo()
+{
+    ColorPalette *palette = s->cellPalette();
+    mPosition = palette->findColorway(mColorway);
+    mColors = palette->colorwayColors(mPosition);
+
+    s->setCurrentColorway(palette->findColorway(mPrevious));
+    s->removeColorway(mPosition);
+}
+
+/*************************************************\
+| RemoveColorway                                  |
+\*************************************************/
+RemoveColorway::RemoveColorway(Scene *scene, int colorway, QUndoCommand *parent)
+    : QUndoCommand(parent)
+{
+    s = scene;
+    ColorPalette *palette = s->cellPalette();
+    mColorway = palette->colorwayId(colorway);
+    mPosition = colorway;
+    mPrevious = palette->colorwayId(palette->currentColorway());
+    setText(QObject::tr("remove colorway"));
+}
+
+void RemoveColorway::redo()
+{
+    ColorPalette *palette = s->cellPalette();
+    mPosition = palette->findColorway(mColorway);
+    mName = palette->colorwayName(mPosition);
+    mColors = palette->colorwayColors(mPosition);
+
+    s->removeColorway(mPosition);
+}
+
+void RemoveColorway::undo()
+{
+    s->insertColorway(mPosition, mColorway, mName, mColors);
+    s->setCurrentColorway(s->cellPalette()->findColorway(mPrevious));
+}
+
+/*************************************************\
+| SetColorwayName                                 |
+\*************************************************/
+SetColorwayName::SetColorwayName(Scene *scene, int colorway, const QString& name, QUndoCommand *parent)
+    : QUndoCommand(parent)
+{
+    s = scene;
+    mColorway = s->cellPalette()->colorwayId(colorway);
+    oldName = s->cellPalette()->colorwayName(colorway);
+    newName = name;
+    setText(QObject::tr("rename colorway"));
+}
+
+void SetColorwayName::redo()
+{
+    ColorPalette *palette = s->cellPalette();
+    palette->setColorwayName(palette->findColorway(mColorway), newName);
+}
+
+void SetColorwayName::undo()
+{
+    ColorPalette *palette = s->cellPalette();
+    palette->setColorwayName(palette->findColorway(mColorway), oldName);
+}
+
+/*************************************************\
+| SetCellsStitch                                  |
+\*************************************************/
+SetCellsStitch::SetCellsStitch(const QList<Cell*>& cells, QString newSt, QUndoCommand *parent)
+    : SpillableCommand(parent)
+{
+    mCells.reserve(cells.count());
+    mOldStitches.reserve(cells.count());
+    foreach(Cell *c, cells) {
+        mCells.append(c);
+        mOldStitches.append(c->name());
+    }
+    newStitch = newSt;
+    setText(QObject::tr("change stitches"));
+}
+
+void SetCellsStitch::redo()
+{
+    restore();
+
+    Stitch *s = StitchLibrary::inst()->findStitch(newStitch);
+    if(!s) {
+        //let the cells fall back to the default stitch.
+        foreach(Cell *c, mCells)
+            c->setStitch(newStitch);
+        return;
+    }
+
+    foreach(Cell *c, mCells)
+        c->setStitch(s);
+}
+
+void SetCellsStitch::undo()
+{
+    restore();
+
+    //most cells share a few stitches, only look each one up once.
+    QHash<QString, Stitch*> stitches;
+    for(int i = 0; i < mCells.count(); ++i) {
+        const QString& name = mOldStitches.at(i);
+        Stitch *s = stitches.value(name);
+        if(!s) {
+            s = StitchLibrary::inst()->findStitch(name);
+            stitches.insert(name, s);
+        }
+
+        if(s)
+            mCells.at(i)->setStitch(s);
+        else
+            mCells.at(i)->setStitch(name);
+    }
+}
+
+qint64 SetCellsStitch::byteSize() const
+{
+    //the stitch names are shared with the stitches so only the references count.
+    return sizeof(*this) + mCells.capacity() * sizeof(Cell*)
+            + mOldStitches.capacity() * sizeof(QString);
+}
+
+void SetCellsStitch::saveValues(QDataStream &out) const
+{
+    savePointers(out, mCells);
+    out << mOldStitches;
+}
+
+void SetCellsStitch::loadValues(QDataStream &in)
+{
+    loadPointers(in, mCells);
+    in >> mOldStitches;
+}
+
+void SetCellsStitch::dropValues()
+{
+    mCells = QVector<Cell*>();
+    mOldStitches = QVector<QString>();
+}
+
+/*************************************************\
+| SetCellsColor                                   |
+\*************************************************/
+SetCellsColor::SetCellsColor(const QList<Cell*>& fgCells, const QList<Cell*>& bgCells, QColor newCl, QUndoCommand *parent)
+    : SpillableCommand(parent)
+{
+    mFgCells.reserve(fgCells.count());
+    mOldFgIndexes.reserve(fgCells.count());
+    foreach(Cell *c, fgCells) {
+        mFgCells.append(c);
+        mOldFgIndexes.append(c->colorIndex());
+    }
+
+    mBgCells.reserve(bgCells.count());
+    mOldBgIndexes.reserve(bgCells.count());
+    foreach(Cell *c, bgCells) {
+        mBgCells.append(c);
+        mOldBgIndexes.append(c->bgColorIndex());
+    }
+
+    newColor = newCl;
+    setText(QObject::tr("change colors"));
+    mTime.start();
+}
+
+void SetCellsColor::redo()
+{
+    restore();
+
+    foreach(Cell *c, mFgCells)
+        c->setColor(newColor);
+    foreach(Cell *c, mBgCells)
+        c->setBgColor(newColor);
+}
+
+void SetCellsColor::undo()
+{
+    restore();
+
+    for(int i = 0; i < mFgCells.count(); ++i)
+        mFgCells.at(i)->setColorIndex(mOldFgIndexes.at(i));
+    for(int i = 0; i < mBgCells.count(); ++i)
+        mBgCells.at(i)->setBgColorIndex(mOldBgIndexes.at(i));
+}
+
+bool SetCellsColor::mergeWith(const QUndoCommand *command)
+{
+    const SetCellsColor *other = static_cast<const SetCellsColor*>(command);
+    if(!canMerge(mTime))
+        return false;
+
+    restore();
+    if(other->mFgCells != mFgCells || other->mBgCells != mBgCells)
+        return false;
+
+    newColor = other->newColor;
+    mTime.restart();
+    return true;
+}
+
+qint64 SetCellsColor::byteSize() const
+{
+    return sizeof(*this) + (mFgCells.capacity() + mBgCells.capacity()) * sizeof(Cell*)
+            + (mOldFgIndexes.capacity() + mOldBgIndexes.capacity()) * sizeof(int);
+}
+
+void SetCellsColor::saveValues(QDataStream &out) const
+{
+    savePointers(out, mFgCells);
+    out << mOldFgIndexes;
+    savePointers(out, mBgCells);
+    out << mOldBgIndexes;
+}
+
+void SetCellsColor::loadValues(QDataStream &in)
+{
+    loadPointers(in, mFgCells);
+    in >> mOldFgIndexes;
+    loadPointers(in, mBgCells);
+    in >> mOldBgIndexes;
+}
+
+void SetCellsColor::dropValues()
+{
+    mFgCells = QVector<Cell*>();
+    mOldFgIndexes = QVector<int>();
+    mBgCells = QVector<Cell*>();
+    mOldBgIndexes = QVector<int>();
+}
+
+/*************************************************\
+| SetItemsCoordinates                             |
+\*************************************************/
+SetItemsCoordinates::SetItemsCoordinates(const QList<QGraphicsItem*>& items, const QVector<QPointF>& newPos,
+                                         QUndoCommand *parent)
+    : SpillableCommand(parent)
+{
+    mItems.reserve(items.count());
+    mOldCoords.reserve(items.count());
+    foreach(QGraphicsItem *i, items) {
+        mItems.append(i);
+        mOldCoords.append(i->pos());
+    }
+    mNewCoords = newPos;
+    setText(QObject::tr("change item positions"));
+    mTime.start();
+}
+
+SetItemsCoordinates::SetItemsCoordinates(const QList<QGraphicsItem*>& items, const QVector<QPointF>& oldPos,
+                                         const QVector<QPointF>& newPos, QUndoCommand *parent)
+    : SpillableCommand(parent)
+{
+    mItems.reserve(items.count());
+    foreach(QGraphicsItem *i, items)
+        mItems.append(i);
+    mOldCoords = oldPos;
+    mNewCoords = newPos;
+    setText(QObject::tr("change item positions"));
+    mTime.start();
+}
+
+void SetItemsCoordinates::undo()
+{
+    restore();
+
+    for(int i = 0; i < mItems.count(); ++i)
+        mItems.at(i)->setPos(mOldCoords.at(i));
+}
+
+void SetItemsCoordinates::redo()
+{
+    restore();
+
+    for(int i = 0; i < mItems.count(); ++i)
+        mItems.at(i)->setPos(mNewCoords.at(i));
+}
+
+bool SetItemsCoordinates::mergeWith(const QUndoCommand *command)
+{
+    const SetItemsCoordinates *other = static_cast<const SetItemsCoordinates*>(command);
+    if(!canMerge(mTime))
+        return false;
+
+    restore();
+    if(other->mItems != mItems)
+        return false;
+
+    mNewCoords = other->mNewCoords;
+    valuesChanged();
+    mTime.restart();
+    return true;
+}
+
+qint64 SetItemsCoordinates::byteSize() const
+{
+    return sizeof(*this) + mItems.capacity() * sizeof(QGraphicsItem*)
+            + (mOldCoords.capacity() + mNewCoords.capacity()) * sizeof(QPointF);
+}
+
+void SetItemsCoordinates::saveValues(QDataStream &out) const
+{
+    savePointers(out, mItems);
+    out << mOldCoords << mNewCoords;
+}
+
+void SetItemsCoordinates::loadValues(QDataStream &in)
+{
+    loadPointers(in, mItems);
+    in >> mOldCoords >> mNewCoords;
+}
+
+void SetItemsCoordinates::dropValues()
+{
+    mItems = QVector<QGraphicsItem*>();
+    mOldCoords = QVector<QPointF>();
+    mNewCoords = QVector<QPointF>();
+}
+
+/*************************************************\
+| SetItemsRotation                                |
+\*************************************************/
+SetItemsRotation::SetItemsRotation(const QList<QGraphicsItem*>& items, qreal newAngl, QUndoCommand *parent)
+    : SpillableCommand(parent)
+{
+    mItems.reserve(items.count());
+    mOldAngles.reserve(items.count());
+    mPivots.reserve(items.count());
+    foreach(QGraphicsItem *i, items) {
+        mItems.append(i);
+        mOldAngles.append(ChartItemTools::getRotation(i));
+        mPivots.append(ChartItemTools::getRotationPivot(i));
+    }
+    mNewAngles.fill(newAngl, mItems.count());
+    setText(QObject::tr("rotate items"));
+    mTime.start();
+}
+
+SetItemsRotation::SetItemsRotation(const QList<QGraphicsItem*>& items, const QVector<qreal>& newAngles,
+                                   QUndoCommand *parent)
+    : SpillableCommand(parent)
+{
+    mItems.reserve(items.count());
+    mOldAngles.reserve(items.count());
+    mPivots.reserve(items.count());
+    foreach(QGraphicsItem *i, items) {
+        mItems.append(i);
+        mOldAngles.append(ChartItemTools::getRotation(i));
+        mPivots.append(ChartItemTools::getRotationPivot(i));
+    }
+    mNewAngles = newAngles;
+    setText(QObject::tr("rotate items"));
+    mTime.start();
+}
+
+void SetItemsRotation::undo()
+{
+    restore();
+
+    for(int i = 0; i < mItems.count(); ++i)
+        SetItemRotation::setRotation(mItems.at(i), mOldAngles.at(i), mPivots.at(i));
+}
+
+void SetItemsRotation::redo()
+{
+    restore();
+
+    for(int i = 0; i < mItems.count(); ++i)
+        SetItemRotation::setRotation(mItems.at(i), mNewAngles.at(i), mPivots.at(i));
+}
+
+bool SetItemsRotation::mergeWith(const QUndoCommand *command)
+{
+    const SetItemsRotation *other = static_cast<const SetItemsRotation*>(command);
+    if(!canMerge(mTime))
+        return false;
+
+    restore();
+    if(other->mItems != mItems || other->mPivots != mPivots)
+        return false;
+
+    mNewAngles = other->mNewAngles;
+    valuesChanged();
+    mTime.restart();
+    return true;
+}
+
+qint64 SetItemsRotation::byteSize() const
+{
+    return sizeof(*this) + mItems.capacity() * sizeof(QGraphicsItem*)
+            + (mOldAngles.capacity() + mNewAngles.capacity()) * sizeof(qreal)
+            + mPivots.capacity() * sizeof(QPointF);
+}
+
+void SetItemsRotation::saveValues(QDataStream &out) const
+{
+    savePointers(out, mItems);
+    out << mOldAngles << mNewAngles << mPivots;
+}
+
+void SetItemsRotation::loadValues(QDataStream &in)
+{
+    loadPointers(in, mItems);
+    in >> mOldAngles >> mNewAngles >> mPivots;
+}
+
+void SetItemsRotation::dropValues()
+{
+    mItems = QVector<QGraphicsItem*>();
+    mOldAngles = QVector<qreal>();
+    mNewAngles = QVector<qreal>();
+    mPivots = QVector<QPointF>();
+}
+
+/*************************************************\
+| SetItemsScale                                   |
+\*************************************************/
+SetItemsScale::SetItemsScale(const QList<QGraphicsItem*>& items, const QVector<QPointF>& newScales,
+                             QUndoCommand *parent)
+    : SpillableCommand(parent)
+{
+    mItems.reserve(items.count());
+    mOldScales.reserve(items.count());
+    mPivots.reserve(items.count());
+    foreach(QGraphicsItem *i, items) {
+        mItems.append(i);
+        mOldScales.append(ChartItemTools::getScale(i));
+        mPivots.append(ChartItemTools::getScalePivot(i));
+    }
+    mNewScales = newScales;
+    setText(QObject::tr("change item scales"));
+    mTime.start();
+}
+
+void SetItemsScale::undo()
+{
+    restore();
+
+    for(int i = 0; i < mItems.count(); ++i)
+        SetItemScale::setScale(mItems.at(i), mOldScales.at(i), mPivots.at(i));
+}
+
+void SetItemsScale::redo()
+{
+    restore();
+
+    for(int i = 0; i < mItems.count(); ++i)
+        SetItemScale::setScale(mItems.at(i), mNewScales.at(i), mPivots.at(i));
+}
+
+bool SetItemsScale::mergeWith(const QUndoCommand *command)
+{
+    const SetItemsScale *other = static_cast<const SetItemsScale*>(command);
+    if(!canMerge(mTime))
+        return false;
+
+    restore();
+    if(other->mItems != mItems || other->mPivots != mPivots)
+        return false;
+
+    mNewScales = other->mNewScales;
+    valuesChanged();
+    mTime.restart();
+    return true;
+}
+
+qint64 SetItemsScale::byteSize() const
+{
+    return sizeof(*this) + mItems.capacity() * sizeof(QGraphicsItem*)
+            + (mOldScales.capacity() + mNewScales.capacity() + mPivots.capacity()) * sizeof(QPointF);
+}
+
+void SetItemsScale::saveValues(QDataStream &out) const
+{
+    savePointers(out, mItems);
+    out << mOldScales << mNewScales << mPivots;
+}
+
+void SetItemsScale::loadValues(QDataStream &in)
+{
+    loadPointers(in, mItems);
+    in >> mOldScales >> mNewScales >> mPivots;
+}
+
+void SetItemsScale::dropValues()
+{
+    mItems = QVector<QGraphicsItem*>();
+    mOldScales = QVector<QPointF>();
+    mNewScales = QVector<QPointF>();
+    mPivots = QVector<QPointF>();
+}
+
+/*************************************************\
+| AddItems                                        |
+\*************************************************/
+AddItems::AddItems(Scene *scene, const QList<QGraphicsItem*>& items, QUndoCommand *parent)
+    : SpillableCommand(parent)
+{
+    s = scene;
+    mItems.reserve(items.count());
+    foreach(QGraphicsItem *i, items)
+        mItems.append(i);
+    setText(QObject::tr("add items"));
+}
+
+AddItems::~AddItems()
+{
+    restore();
+
+    foreach(QGraphicsItem *i, mItems) {
+        if(!i->scene())
+            delete i;
+    }
+}
+
+void AddItems::undo()
+{
+    restore();
+
+    s->removeItems(mItems.toList());
+}
+
+void AddItems::redo()
+{
+    restore();
+
+    foreach(QGraphicsItem *i, mItems)
+        s->addItem(i);
+}
+
+qint64 AddItems::byteSize() const
+{
+    return sizeof(*this) + mItems.capacity() * sizeof(QGraphicsItem*);
+}
+
+void AddItems::saveValues(QDataStream &out) const
+{
+    savePointers(out, mItems);
+}
+
+void AddItems::loadValues(QDataStream &in)
+{
+    loadPointers(in, mItems);
+}
+
+void AddItems::dropValues()
+{
+    mItems = QVector<QGraphicsItem*>();
+}
@@ -22,10 +22,13 @@
 #define CROCHETCHARTCOMMANDS_H
 
 #include <QUndoCommand>
+#include <QVector>
+#include <QElapsedTimer>
 
 #include "cell.h"
 #include "ChartImage.h"
 #include "scene.h"
+#include "undomemory.h"
 
 class SetIndicatorText : public QUndoCommand
 {
@@ -116,13 +119,18 @@ public:
     void redo();
 
     int id() const { return Id; }
+    bool mergeWith(const QUndoCommand *command);
     
     static void setBgColor(Cell *cell, QColor color);
 
 private:
-    QColor oldColor;
+    //the palette entry, the color might have been given to another entry since.
+    int oldIndex;
     QColor newColor;
     Cell *c;
+
+    //when the command was last changed, for merging.
+    QElapsedTimer mTime;
 };
 
 class SetCellColor : public QUndoCommand
@@ -136,13 +144,18 @@ public:
     void redo();
 
     int id() const { return Id; }
+    bool mergeWith(const QUndoCommand *command);
 
     static void setColor(Cell *cell, QColor color);
 
 private:
-    QColor oldColor;
+    //the palette entry, -1 for a cell without a color.
+    int oldIndex;
     QColor newColor;
     Cell *c;
+
+    //when the command was last changed, for merging.
+    QElapsedTimer mTime;
 };
 
 class SetItemRotation : public QUndoCommand
@@ -156,6 +169,7 @@ public:
     void redo();
 
     int id() const { return Id; }
+    bool mergeWith(const QUndoCommand *command);
 
     static void setRotation(QGraphicsItem *item, qreal angle, QPointF pivot);
 
@@ -165,6 +179,8 @@ private:
     qreal newAngle;
     QPointF pvtPt;
 
+    //when the command was last changed, for merging.
+    QElapsedTimer mTime;
 };
 
 /**
@@ -211,6 +227,7 @@ public:
     void redo();
 
     int id() const { return Id; }
+    bool mergeWith(const QUndoCommand *command);
 
     static void setPosition(QGraphicsItem *item, QPointF position);
 
@@ -218,6 +235,9 @@ private:
     QPointF oldCoord;
     QPointF newCoord;
     QGraphicsItem *i;
+
+    //when the command was last changed, for merging.
+    QElapsedTimer mTime;
 };
 
 class SetItemScale : public QUndoCommand
@@ -231,6 +251,7 @@ public:
     void redo();
 
     int id() const { return Id; }
+    bool mergeWith(const QUndoCommand *command);
 
     static void setScale(QGraphicsItem *item, QPointF scale, QPointF pivot);
 
@@ -241,6 +262,8 @@ private:
 
     QGraphicsItem *i;
 
+    //when the command was last changed, for merging.
+    QElapsedTimer mTime;
 };
 
 class AddItem : public QUndoCommand
@@ -283,22 +306,39 @@ private:
     Scene *s;
 };
 
-class RemoveItems : public QUndoCommand
+/**
+ * Remove many items from the scene as one command.
+ * Undo puts the cells back in the rows at the same places.
+ */
+class RemoveItems : public SpillableCommand
 {
 public:
     enum { Id = 1220 };
 
     RemoveItems(Scene *scene, QList<QGraphicsItem*> items, QUndoCommand *parent = 0);
-	~RemoveItems();
-	
+
     void redo();
     void undo();
 
     int id() const { return Id; }
 
+    qint64 byteSize() const;
+
+protected:
+    void saveValues(QDataStream &out) const;
+    void loadValues(QDataStream &in);
+    void dropValues();
+
 private:
-    QList<QGraphicsItem*> items;
-	QGraphicsItemGroup* removegroup;
+    //in stacking order, so adding them back keeps the order they were drawn in.
+    QVector<QGraphicsItem*> mItems;
+    //indicators are put back where they were.
+    QVector<QPointF> mPositions;
+    QVector<qreal> mZValues;
+
+    //where the cells were in the grid, filled in by redo().
+    QVector<QPoint> mGridPositions;
+    QList<int> mEmptiedRows;
 
     Scene *s;
 };
@@ -446,4 +486,288 @@ private:
 	unsigned int mOld;
 };
 
+class SetPaletteColor : public QUndoCommand
+{
+public:
+    enum { Id = 1310 };
+
+    SetPaletteColor(Scene *scene, int index, QColor newCl, QUndoCommand *parent = 0);
+
+    void undo();
+    void redo();
+
+    int id() const { return Id; }
+
+private:
+    Scene *s;
+    //the id of the colorway that was edited, not the one current when undoing.
+    int mColorway;
+    int mIndex;
+    QColor oldColor;
+    QColor newColor;
+};
+
+/**
+ * The colorway commands keep the id of the colorway, its position changes
+ * when the colorways before it are removed.
+ */
+class AddColorway : public QUndoCommand
+{
+public:
+    enum { Id = 1380 };
+
+    AddColorway(Scene *scene, const QString& name, QUndoCommand *parent = 0);
+
+    void undo();
+    void redo();
+
+    int id() const { return Id; }
+
+private:
+    Scene *s;
+    QString mName;
+    //-1 until the colorway is added the first time.
+    int mColorway;
+    int mPosition;
+    //the colorway that was current before.
+    int mPrevious;
+    QVector<QRgb> mColors;
+};
+
+class RemoveColorway : public QUndoCommand
+{
+public:
+    enum { Id = 1390 };
+
+    RemoveColorway(Scene *scene, int colorway, QUndoCommand *parent = 0);
+
+    void undo();
+    void redo();
+
+    int id() const { return Id; }
+
+private:
+    Scene *s;
+    int mColorway;
+    int mPosition;
+    int mPrevious;
+    QString mName;
+    QVector<QRgb> mColors;
+};
+
+class SetColorwayName : public QUndoCommand
+{
+public:
+    enum { Id = 1400 };
+
+    SetColorwayName(Scene *scene, int colorway, const QString& name, QUndoCommand *parent = 0);
+
+    void undo();
+    void redo();
+
+    int id() const { return Id; }
+
+private:
+    Scene *s;
+    int mColorway;
+    QString oldName;
+    QString newName;
+};
+
+/**
+ * Change the stitch of many cells as one command.
+ */
+class SetCellsStitch : public SpillableCommand
+{
+public:
+    enum { Id = 1320 };
+
+    SetCellsStitch(const QList<Cell*>& cells, QString newSt, QUndoCommand *parent = 0);
+
+    void undo();
+    void redo();
+
+    int id() const { return Id; }
+
+    qint64 byteSize() const;
+
+protected:
+    void saveValues(QDataStream &out) const;
+    void loadValues(QDataStream &in);
+    void dropValues();
+
+private:
+    QVector<Cell*> mCells;
+    QVector<QString> mOldStitches;
+    QString newStitch;
+};
+
+/**
+ * Change the foreground color of some cells and the background color of others as one command.
+ */
+class SetCellsColor : public SpillableCommand
+{
+public:
+    enum { Id = 1330 };
+
+    SetCellsColor(const QList<Cell*>& fgCells, const QList<Cell*>& bgCells, QColor newCl, QUndoCommand *parent = 0);
+
+    void undo();
+    void redo();
+
+    int id() const { return Id; }
+    bool mergeWith(const QUndoCommand *command);
+
+    qint64 byteSize() const;
+
+protected:
+    void saveValues(QDataStream &out) const;
+    void loadValues(QDataStream &in);
+    void dropValues();
+
+private:
+    //the old colors are kept as palette entries.
+    QVector<Cell*> mFgCells;
+    QVector<int> mOldFgIndexes;
+    QVector<Cell*> mBgCells;
+    QVector<int> mOldBgIndexes;
+    QColor newColor;
+
+    //when the command was last changed, for merging.
+    QElapsedTimer mTime;
+};
+
+/**
+ * Move many items as one command.
+ */
+class SetItemsCoordinates : public SpillableCommand
+{
+public:
+    enum { Id = 1340 };
+
+    SetItemsCoordinates(const QList<QGraphicsItem*>& items, const QVector<QPointF>& newPos, QUndoCommand *parent = 0);
+    /**
+     * For items that have already been moved, such as at the end of a drag.
+     */
+    SetItemsCoordinates(const QList<QGraphicsItem*>& items, const QVector<QPointF>& oldPos,
+                        const QVector<QPointF>& newPos, QUndoCommand *parent = 0);
+
+    void undo();
+    void redo();
+
+    int id() const { return Id; }
+    bool mergeWith(const QUndoCommand *command);
+
+    qint64 byteSize() const;
+
+protected:
+    void saveValues(QDataStream &out) const;
+    void loadValues(QDataStream &in);
+    void dropValues();
+
+private:
+    QVector<QGraphicsItem*> mItems;
+    QVector<QPointF> mOldCoords;
+    QVector<QPointF> mNewCoords;
+
+    //when the command was last changed, for merging.
+    QElapsedTimer mTime;
+};
+
+/**
+ * Rotate many items as one command, each item keeps its own pivot.
+ */
+class SetItemsRotation : public SpillableCommand
+{
+public:
+    enum { Id = 1350 };
+
+    SetItemsRotation(const QList<QGraphicsItem*>& items, qreal newAngl, QUndoCommand *parent = 0);
+    SetItemsRotation(const QList<QGraphicsItem*>& items, const QVector<qreal>& newAngles, QUndoCommand *parent = 0);
+
+    void undo();
+    void redo();
+
+    int id() const { return Id; }
+    bool mergeWith(const QUndoCommand *command);
+
+    qint64 byteSize() const;
+
+protected:
+    void saveValues(QDataStream &out) const;
+    void loadValues(QDataStream &in);
+    void dropValues();
+
+private:
+    QVector<QGraphicsItem*> mItems;
+    QVector<qreal> mOldAngles;
+    QVector<qreal> mNewAngles;
+    QVector<QPointF> mPivots;
+
+    //when the command was last changed, for merging.
+    QElapsedTimer mTime;
+};
+
+/**
+ * Scale many items as one command, each item keeps its own pivot.
+ */
+class SetItemsScale : public SpillableCommand
+{
+public:
+    enum { Id = 1360 };
+
+    SetItemsScale(const QList<QGraphicsItem*>& items, const QVector<QPointF>& newScales, QUndoCommand *parent = 0);
+
+    void undo();
+    void redo();
+
+    int id() const { return Id; }
+    bool mergeWith(const QUndoCommand *command);
+
+    qint64 byteSize() const;
+
+protected:
+    void saveValues(QDataStream &out) const;
+    void loadValues(QDataStream &in);
+    void dropValues();
+
+private:
+    QVector<QGraphicsItem*> mItems;
+    QVector<QPointF> mOldScales;
+    QVector<QPointF> mNewScales;
+    QVector<QPointF> mPivots;
+
+    //when the command was last changed, for merging.
+    QElapsedTimer mTime;
+};
+
+/**
+ * Add many new items to the scene as one command.
+ * Items that aren't in the scene when the command is deleted are deleted with it.
+ */
+class AddItems : public SpillableCommand
+{
+public:
+    enum { Id = 1370 };
+
+    AddItems(Scene *scene, const QList<QGraphicsItem*>& items, QUndoCommand *parent = 0);
+    ~AddItems();
+
+    void undo();
+    void redo();
+
+    int id() const { return Id; }
+
+    qint64 byteSize() const;
+
+protected:
+    void saveValues(QDataStream &out) const;
+    void loadValues(QDataStream &in);
+    void dropValues();
+
+private:
+    QVector<QGraphicsItem*> mItems;
+    Scene *s;
+};
+
 #endif //CROCHETCHARTCOMMANDS_H
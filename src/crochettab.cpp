@@ -68,13 +68,14 @@ CrochetTab::CrochetTab(Scene::ChartStyle style, int defEditMode, QString defStit
 
     connect(mView, SIGNAL(scrollBarChanged(int,int)), mScene, SLOT(updateRubberBand(int,int)));
     
-    connect(mScene, SIGNAL(stitchChanged(QString,QString)), SLOT(stitchChanged(QString,QString)));
-    connect(mScene, SIGNAL(colorChanged(QString,QString)), SLOT(colorChanged(QString,QString)));
+    connect(mScene, SIGNAL(stitchesChanged(QMap<QString,int>)), SLOT(stitchesChanged(QMap<QString,int>)));
+    connect(mScene, SIGNAL(colorsChanged(QMap<QString,int>)), SLOT(colorsChanged(QMap<QString,int>)));
     connect(mScene, SIGNAL(rowEdited(bool)), SIGNAL(tabModified(bool)));
     connect(mScene, SIGNAL(guidelinesUpdated(Guidelines)), SIGNAL(guidelinesUpdated(Guidelines)));
 	connect(mScene, SIGNAL(layersChanged(QList<ChartLayer*>&, ChartLayer*)), this, SLOT(layersChangedSlot(QList<ChartLayer*>&, ChartLayer*)));
 	
     mView->setScene(mScene);
+    mScene->setLayerCacheView(mView);
     QPoint pt = mView->mapFromScene(centerOn);
     mView->centerOn(pt.x(), pt.y());
 
@@ -171,39 +172,42 @@ void CrochetTab::renderChart(QPainter* painter, QRectF rect)
     mView->centerOn(r.center());
 }
 
-void CrochetTab::stitchChanged(QString oldSt, QString newSt)
+void CrochetTab::stitchesChanged(QMap<QString, int> changes)
 {
 
-    if (!oldSt.isEmpty()) {
-        mPatternStitches->operator[](oldSt)--;
-        if (mPatternStitches->operator[](oldSt) == 0)
-            mPatternStitches->remove(oldSt);
+    QMap<QString, int>::const_iterator i;
+    for (i = changes.constBegin(); i != changes.constEnd(); ++i) {
+        int count = mPatternStitches->value(i.key()) + i.value();
+        if (count > 0)
+            mPatternStitches->insert(i.key(), count);
+        else
+            mPatternStitches->remove(i.key());
     }
 
-    if (!mPatternStitches->contains(newSt))
-        mPatternStitches->insert(newSt, 1);
-    else
-        mPatternStitches->operator[](newSt)++;
-
     emit chartStitchChanged();
 }
 
-void CrochetTab::colorChanged(QString oldColor, QString newColor)
+void CrochetTab::colorsChanged(QMap<QString, int> changes)
 {
 
-    if (!oldColor.isEmpty()) {
-        mPatternColors->operator[](oldColor)["count"]--;
-        if (mPatternColors->operator[](oldColor)["count"] == 0)
-            mPatternColors->remove(oldColor);
-    }
+    QMap<QString, int>::const_iterator i;
+    for (i = changes.constBegin(); i != changes.constEnd(); ++i) {
+        if (!mPatternColors->contains(i.key())) {
+            if (i.value() <= 0)
+                continue;
+            QMap<QString, qint64> properties;
+            properties["added"] = QDateTime::currentDateTime().toMSecsSinceEpoch();
+            properties["count"] = i.value();
+            mPatternColors->insert(i.key(), properties);
+            continue;
+        }
 
-    if (!mPatternColors->contains(newColor)) {
-        QMap<QString, qint64> properties;
-        properties["added"] = QDateTime::currentDateTime().toMSecsSinceEpoch();
-        properties["count"] = 1;
-        mPatternColors->insert(newColor, properties);
-    } else
-        mPatternColors->operator[](newColor)["count"]++;
+        qint64 count = mPatternColors->value(i.key()).value("count") + i.value();
+        if (count > 0)
+            mPatternColors->operator[](i.key())["count"] = count;
+        else
+            mPatternColors->remove(i.key());
+    }
 
     emit chartColorChanged();
 }
@@ -397,6 +401,11 @@ void CrochetTab::rotate(qreal degrees)
     mScene->rotate(degrees);
 }
 
+void CrochetTab::replicate(int copies, qreal degrees, QPointF step)
+{
+    mScene->replicate(copies, degrees, step);
+}
+
 void CrochetTab::resizeScene(QRectF rectangle)
 {
 	mScene->resizeScene(rectangle);
@@ -91,6 +91,7 @@ public:
     void copy(int direction);
     void mirror(int direction);
     void rotate(qreal degrees);
+    void replicate(int copies, qreal degrees, QPointF step);
 	void resizeScene(QRectF rectangle);
     void copy();
     void cut();
@@ -128,8 +129,8 @@ public slots:
     void zoomIn();
     void zoomOut();
 
-    void stitchChanged(QString oldSt, QString newSt);
-    void colorChanged(QString oldColor, QString newColor);
+    void stitchesChanged(QMap<QString, int> changes);
+    void colorsChanged(QMap<QString, int> changes);
 	void layersChangedSlot(QList<ChartLayer*>& layers, ChartLayer* selected);
 
     QUndoStack* undoStack();
@@ -28,6 +28,8 @@
 
 #include <QMessageBox>
 #include <QFileDialog>
+#include <QFileInfo>
+#include <QRegExp>
 
 #include <QPrinter> //for pdf
 #include <QSvgGenerator> //for svg
@@ -296,6 +298,7 @@ void ExportUi::exportData()
     pageToChartSize = ui->pageToChartSize->isChecked();
 	selectionOnly = ui->selectionOnly->isChecked();
 	includeHeaderFooter = ui->headerFooter->isChecked();
+    allColorways = ui->allColorways->isChecked();
 		
     QString filter;
     if(exportType == "pdf")
@@ -341,12 +344,10 @@ void ExportUi::exportData()
             exportLegendImg();
 
     } else { //charts
-        if(exportType == "pdf")
-            exportPdf();
-        else if(exportType == "svg")
-            exportSvg();
+        if(allColorways)
+            exportColorways();
         else
-            exportImg();
+            exportChart();
     }
 	
 	//restore the selected items
@@ -359,6 +360,70 @@ void ExportUi::exportData()
     QApplication::restoreOverrideCursor();
 }
 
+void ExportUi::exportChart()
+{
+    if(exportType == "pdf")
+        exportPdf();
+    else if(exportType == "svg")
+        exportSvg();
+    else
+        exportImg();
+}
+
+void ExportUi::exportColorways()
+{
+    QList<CrochetTab*> tabs;
+    QList<int> current;
+    QStringList names;
+
+    //colorways with the same name are exported together.
+    for(int i = 0; i < mTabWidget->count(); ++i) {
+        if(selection != tr("All Charts") && selection != mTabWidget->tabText(i))
+            continue;
+
+        CrochetTab* tab = qobject_cast<CrochetTab*>(mTabWidget->widget(i));
+        if(!tab)
+            continue;
+
+        ColorPalette* palette = tab->scene()->cellPalette();
+        tabs.append(tab);
+        current.append(palette->currentColorway());
+        for(int c = 0; c < palette->colorwayCount(); ++c) {
+            if(!names.contains(palette->colorwayName(c)))
+                names.append(palette->colorwayName(c));
+        }
+    }
+
+    QFileInfo info(fileName);
+    QString exportName = fileName;
+
+    foreach(QString name, names) {
+        foreach(CrochetTab* tab, tabs) {
+            ColorPalette* palette = tab->scene()->cellPalette();
+            int colorway = 0;
+            for(int c = 0; c < palette->colorwayCount(); ++c) {
+                if(palette->colorwayName(c) == name) {
+                    colorway = c;
+                    break;
+                }
+            }
+            tab->scene()->setCurrentColorway(colorway);
+        }
+
+        QString safeName = name;
+        safeName.replace(QRegExp("[/\\\\:*?\"<>|]"), "_");
+        fileName = info.path() + "/" + info.completeBaseName() + "-" + safeName;
+        if(!info.suffix().isEmpty())
+            fileName += "." + info.suffix();
+
+        exportChart();
+    }
+
+    for(int i = 0; i < tabs.count(); ++i)
+        tabs.at(i)->scene()->setCurrentColorway(current.at(i));
+    fileName = exportName;
+}
+
 int ExportUi::exec()
 {
     int retValue = QDialog::exec();
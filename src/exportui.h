@@ -49,6 +49,7 @@ public:
     bool pageToChartSize;
 	bool selectionOnly;
 	bool includeHeaderFooter;
+    bool allColorways;
     QGraphicsScene* scene;
     
 public slots:
@@ -78,6 +79,10 @@ private:
     void exportLegendSvg();
     void exportLegendImg();
 
+    void exportChart();
+    //export the charts once per colorway with the colorway's name added to the file name.
+    void exportColorways();
+
     void exportPdf();
     void exportSvg();
     void exportImg();
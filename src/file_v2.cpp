@@ -37,6 +37,25 @@
 
 #include "crochettab.h"
 
+//#AARRGGBB, QColor::name() drops the alpha.
+static QString rgbaName(QRgb color)
+{
+    return QString("#%1").arg(color, 8, 16, QChar('0'));
+}
+
+static QRgb rgbaFromName(const QString& name)
+{
+    QString hex = name.mid(1);
+    bool ok = false;
+    QRgb color = hex.toUInt(&ok, 16);
+    if(!ok)
+        return QColor(Qt::black).rgba();
+
+    if(hex.length() <= 6)
+        color |= 0xff000000;
+    return color;
+}
+
 File_v2::File_v2(MainWindow *mw, FileFactory *parent)
     : File(mw, parent)
 {
@@ -160,6 +179,8 @@ void File_v2::loadChart(QXmlStreamReader *stream)
     MainWindow *mw = mMainWindow;
     CrochetTab *tab = 0;
     QString tabName = "", defaultSt = "";
+    int colorways = 0, currentColorway = 0;
+    mPaletteEntries.clear();
 
     while(!(stream->isEndElement() && stream->name() == "chart")) {
         stream->readNext();
@@ -248,11 +269,21 @@ void File_v2::loadChart(QXmlStreamReader *stream)
 			tab->scene()->setSceneRect(size);
 			
 			stream->readElementText();
+        } else if(tag == "palette") {
+            currentColorway = loadPalette(stream, tab->scene());
+
+        } else if(tag == "colorway") {
+            //older files map the colors of the first colorway.
+            if(loadColorway(stream, tab->scene(), colorways))
+                currentColorway = colorways;
+            ++colorways;
 		} else {
             qWarning() << "loadChart Unknown tag:" << tag;
         }
     }
 	
+    tab->scene()->setCurrentColorway(currentColorway);
+
 	//refresh the layers so the visibility and selectability of items is correct
 	tab->scene()->refreshLayers();
 		
@@ -285,6 +316,67 @@ void File_v2::loadGrid(QXmlStreamReader *stream, Scene *scene)
     }
 }
 
+bool File_v2::loadColorway(QXmlStreamReader *stream, Scene *scene, int colorway)
+{
+    ColorPalette *palette = scene->cellPalette();
+    QString name = stream->attributes().value("name").toString();
+    bool current = stream->attributes().value("current").toString().toInt();
+
+    //the first colorway is the one the cells were saved in.
+    if(colorway == 0)
+        palette->setColorwayName(0, name);
+    else
+        colorway = palette->addColorway(name);
+
+    while(!(stream->isEndElement() && stream->name() == "colorway")) {
+        stream->readNext();
+        QString tag = stream->name().toString();
+
+        if(tag == "color") {
+            QColor original(stream->attributes().value("original").toString());
+            QColor color(stream->readElementText());
+            foreach(int index, palette->indexesOf(original.rgba()))
+                palette->setColorwayColor(colorway, index, color.rgba());
+        }
+    }
+
+    return current;
+}
+
+int File_v2::loadPalette(QXmlStreamReader *stream, Scene *scene)
+{
+    ColorPalette *palette = scene->cellPalette();
+    int current = stream->attributes().value("current").toString().toInt();
+    int colorways = 0;
+
+    while(!(stream->isEndElement() && stream->name() == "palette")) {
+        stream->readNext();
+        QString tag = stream->name().toString();
+
+        if(tag == "colorway") {
+            QString name = stream->attributes().value("name").toString();
+            if(colorways == 0)
+                palette->setColorwayName(0, name);
+            else
+                palette->addColorway(name);
+            ++colorways;
+            stream->readElementText();
+
+        } else if(tag == "entry") {
+            //one color for each colorway.
+            QVector<QRgb> colors;
+            while(!(stream->isEndElement() && stream->name() == "entry")) {
+                stream->readNext();
+                if(stream->name() == "color")
+                    colors.append(rgbaFromName(stream->readElementText()));
+            }
+            mPaletteEntries.append(palette->addEntry(colors));
+        }
+    }
+
+    return current;
+}
+
 void File_v2::loadIndicator(CrochetTab *tab, QXmlStreamReader *stream)
 {
     Indicator *i = new Indicator();
@@ -323,6 +415,12 @@ void File_v2::loadIndicator(CrochetTab *tab, QXmlStreamReader *stream)
             textColor = stream->readElementText();
         } else if(tag == "bgColor") {
             bgColor = stream->readElementText();
+
+        } else if(tag == "colorEntry") {
+            colorEntry = stream->readElementText().toInt();
+
+        } else if(tag == "bgColorEntry") {
+            bgColorEntry = stream->readElementText().toInt();
         } else if(tag == "style") {
             style = stream->readElementText();
         } else if(tag == "group") {
@@ -366,12 +464,6 @@ void File_v2::loadIndicator(CrochetTab *tab, QXmlStreamReader *stream)
 	DEBUG(style);
 	transform.setMatrix(m11, m12, m13, m21, m22, m23, m31, m32, m33);
     tab->scene()->addItem(i);
-    i->setTransform(transform);
-	ChartItemTools::setRotation(i, rotation);
-	ChartItemTools::setScaleX(i, scaleX);
-	ChartItemTools::setScaleY(i, scaleY);
-	ChartItemTools::setRotationPivot(i, pivotRotation, false);
-	ChartItemTools::setScalePivot(i, pivotScale, false);
     i->setPos(x,y);
 	i->setText(text);
 	qDebug() << "loading text " << text;
@@ -380,9 +472,17 @@ void File_v2::loadIndicator(CrochetTab *tab, QXmlStreamReader *stream)
 	i->setLayer(layer);
 	if (fontused)
 		i->setFont(QFont(fontname, fontsize));
-	
+
+	//the text and font set the bounding rect the transformations are folded against.
+	ChartItemTools::setRotation(i, rotation);
+	ChartItemTools::setScaleX(i, scaleX);
+	ChartItemTools::setScaleY(i, scaleY);
+	ChartItemTools::setRotationPivot(i, pivotRotation, false);
+	ChartItemTools::setScalePivot(i, pivotScale, false);
+	//older files store a transformation that goes before the rotation and scale.
+    i->setTransform(transform, true);
 	ChartItemTools::recalculateTransformations(i);
-	
+
     //i->setTextInteractionFlags(Qt::TextEditorInteraction);
 
     if(style.isEmpty())
@@ -472,7 +572,6 @@ void File_v2::loadChartImage(CrochetTab* tab, QXmlStreamReader* stream)
     tab->scene()->addItem(c);
 
 	transform.setMatrix(m11, m12, m13, m21, m22, m23, m31, m32, m33);
-	c->setTransform(transform);
 	c->setLayer(layer);
     c->setZValue(10);
 	c->setPos(position);
@@ -484,6 +583,8 @@ void File_v2::loadChartImage(CrochetTab* tab, QXmlStreamReader* stream)
 	ChartItemTools::setScaleY(c, scaleY);
 	ChartItemTools::setRotationPivot(c, pivotRotation, false);
 	ChartItemTools::setScalePivot(c, pivotScale, false);
+	//older files store a transformation that goes before the rotation and scale.
+	c->setTransform(transform, true);
 	ChartItemTools::recalculateTransformations(c);
     if(group != -1) {
         tab->scene()->addToGroup(group, c);
@@ -499,6 +600,7 @@ void File_v2::loadCell(CrochetTab *tab, QXmlStreamReader *stream)
     int row = -1, column = -1;
     int group = -1;
     QString bgColor, color;
+    int bgColorEntry = -1, colorEntry = -1;
     QPointF position(0.0,0.0);
     QPointF pivotPoint;
 	unsigned int layer = 0;
@@ -598,11 +700,17 @@ void File_v2::loadCell(CrochetTab *tab, QXmlStreamReader *stream)
         c->setZValue(10);
     }
 
-    c->setTransform(transform);
     c->setRotation(angle);
     c->setPos(position);
-    c->setBgColor(QColor(bgColor));
-    c->setColor(QColor(color));
+    //newer files point the cells at the entries of the palette.
+    if(bgColorEntry >= 0 && bgColorEntry < mPaletteEntries.count())
+        c->setBgColorIndex(mPaletteEntries.at(bgColorEntry));
+    else
+        c->setBgColor(QColor(bgColor));
+    if(colorEntry >= 0 && colorEntry < mPaletteEntries.count())
+        c->setColorIndex(mPaletteEntries.at(colorEntry));
+    else
+        c->setColor(QColor(color));
     c->setTransformOriginPoint(pivotPoint);
 	
 	ChartItemTools::setRotation(c, rotation);
@@ -610,6 +718,8 @@ void File_v2::loadCell(CrochetTab *tab, QXmlStreamReader *stream)
 	ChartItemTools::setScaleY(c, scaleY);
 	ChartItemTools::setRotationPivot(c, pivotRotation, false);
 	ChartItemTools::setScalePivot(c, pivotScale, false);
+	//older files store a transformation that goes before the rotation and scale.
+	c->setTransform(transform, true);
 	ChartItemTools::recalculateTransformations(c);
     if(group != -1) {
         tab->scene()->addToGroup(group, c);
@@ -711,6 +821,8 @@ bool File_v2::saveCharts(QXmlStreamWriter *stream)
             stream->writeTextElement("group", QString::number(tab->scene()->mGroups.indexOf(g)));
         }
 
+        savePalette(stream, tab->scene());
+
         foreach(QGraphicsItem *item, tab->scene()->items()) {
 
             Cell *c = qgraphicsitem_cast<Cell*>(item);
@@ -782,8 +894,18 @@ bool File_v2::saveCharts(QXmlStreamWriter *stream)
 				g->addToGroup(c);
 			}
 
-            stream->writeTextElement("color", c->color().name());
-            stream->writeTextElement("bgColor", c->bgColor().name());
+            //the colors of the first colorway are still written for older versions.
+            ColorPalette *palette = tab->scene()->cellPalette();
+            QColor color = c->color();
+            if(c->colorIndex() >= 0)
+                color = QColor::fromRgba(palette->colorwayColor(0, c->colorIndex()));
+            QColor bgColor = QColor::fromRgba(palette->colorwayColor(0, c->bgColorIndex()));
+
+            stream->writeTextElement("color", color.name());
+            stream->writeTextElement("bgColor", bgColor.name());
+            if(c->colorIndex() >= 0)
+                stream->writeTextElement("colorEntry", QString::number(c->colorIndex()));
+            stream->writeTextElement("bgColorEntry", QString::number(c->bgColorIndex()));
 
             stream->writeStartElement("pivotPoint");
             stream->writeAttribute("x", QString::number(c->transformOriginPoint().x()));
@@ -919,3 +1041,27 @@ void File_v2::cleanUp()
     if(mInternalStitchSet)
         StitchLibrary::inst()->removeSet(mInternalStitchSet);
 }
+
+void File_v2::savePalette(QXmlStreamWriter *stream, Scene *scene)
+{
+    ColorPalette *palette = scene->cellPalette();
+
+    stream->writeStartElement("palette");
+    stream->writeAttribute("current", QString::number(palette->currentColorway()));
+
+    for(int colorway = 0; colorway < palette->colorwayCount(); ++colorway) {
+        stream->writeStartElement("colorway");
+        stream->writeAttribute("name", palette->colorwayName(colorway));
+        stream->writeEndElement(); //end colorway
+    }
+
+    //the cells refer to the entries by index, so every entry is written in order.
+    for(int i = 0; i < palette->count(); ++i) {
+        stream->writeStartElement("entry");
+        foreach(QRgb color, palette->entry(i))
+            stream->writeTextElement("color", rgbaName(color));
+        stream->writeEndElement(); //end entry
+    }
+
+    stream->writeEndElement(); //end palette
+}
@@ -25,6 +25,7 @@
 
 #include <QXmlStreamReader>
 #include <QXmlStreamWriter>
+#include <QVector>
 
 class QDataStream;
 class CrochetTab;
@@ -49,10 +50,17 @@ private:
     void loadGrid(QXmlStreamReader* stream, Scene* scene);
     void loadIndicator(CrochetTab* tab, QXmlStreamReader* stream);
 	void loadChartImage(CrochetTab* tab, QXmlStreamReader* stream);
+    //returns true if the colorway was the current one when it was saved.
+    bool loadColorway(QXmlStreamReader* stream, Scene* scene, int colorway);
+    //returns the colorway that was current when it was saved.
+    int loadPalette(QXmlStreamReader* stream, Scene* scene);
 
     void saveCustomStitches(QXmlStreamWriter* stream);
     void saveColors(QXmlStreamWriter* stream);
     bool saveCharts(QXmlStreamWriter* stream);
+    void savePalette(QXmlStreamWriter* stream, Scene* scene);
 
+    //the palette entry of each entry of the palette being loaded.
+    QVector<int> mPaletteEntries;
 };
 #endif // FINE_V2_H
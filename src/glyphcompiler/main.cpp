@@ -0,0 +1,148 @@
+/****************************************************************************\
+ Copyright (c) 2011-2014 Stitch Works Software
+ Brian C. Milco <bcmilco@gmail.com>
+
+ This file is part of Crochet Charts.
+
+ Crochet Charts is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ Crochet Charts is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with Crochet Charts. If not, see <http://www.gnu.org/licenses/>.
+
+ \****************************************************************************/
+
+/*
+ * glyphcompiler <output.cpp> <stitch.svg>...
+ *
+ * Flattens the built in stitch svgs into the tables declared in
+ * builtinglyphs.h so the application doesn't have to parse them at startup.
+ * Stitches that can't be represented by the tables are left out and are
+ * loaded from their svg at runtime as before.
+ */
+
+#include <QApplication>
+#include <QFile>
+#include <QFileInfo>
+#include <QStringList>
+#include <QTextStream>
+
+#include "stitchglyph.h"
+
+static QString number(qreal value)
+{
+    return QString::number(value, 'g', 10);
+}
+
+static bool isCompilable(const StitchGlyph &glyph)
+{
+    if(glyph.elements().isEmpty())
+        return false;
+
+    foreach(const StitchGlyph::Element &e, glyph.elements()) {
+        if(e.brush.style() != Qt::NoBrush && e.brush.style() != Qt::SolidPattern)
+            return false;
+        if(e.pen.style() == Qt::CustomDashLine)
+            return false;
+        if(e.pen.style() != Qt::NoPen && e.pen.brush().style() != Qt::SolidPattern)
+            return false;
+    }
+    return true;
+}
+
+static void writeGlyph(QTextStream &out, const StitchGlyph &glyph, int index)
+{
+    QList<StitchGlyph::Element> elements = glyph.elements();
+
+    for(int i = 0; i < elements.count(); ++i) {
+        const QPainterPath &path = elements[i].path;
+
+        out << "static const BuiltInGlyph::PathElement glyph" << index << "_path" << i << "[] = {\n";
+        for(int j = 0; j < path.elementCount(); ++j) {
+            const QPainterPath::Element &pe = path.elementAt(j);
+            out << "    { " << (int)pe.type << ", " << number(pe.x) << ", " << number(pe.y) << " },\n";
+        }
+        out << "};\n";
+    }
+
+    out << "static const BuiltInGlyph::Element glyph" << index << "_elements[] = {\n";
+    for(int i = 0; i < elements.count(); ++i) {
+        const StitchGlyph::Element &e = elements[i];
+        const QTransform &t = e.transform;
+
+        out << "    { glyph" << index << "_path" << i << ", " << e.path.elementCount()
+            << ", " << (int)e.path.fillRule()
+            << ", " << (int)e.pen.style() << ", 0x" << QString::number(e.pen.color().rgba(), 16) << "u"
+            << ", " << number(e.pen.widthF()) << ", " << (int)e.pen.capStyle()
+            << ", " << (int)e.pen.joinStyle() << ", " << number(e.pen.miterLimit())
+            << ", " << (int)e.brush.style() << ", 0x" << QString::number(e.brush.color().rgba(), 16) << "u"
+            << ", { " << number(t.m11()) << ", " << number(t.m12()) << ", " << number(t.m13())
+            << ", " << number(t.m21()) << ", " << number(t.m22()) << ", " << number(t.m23())
+            << ", " << number(t.m31()) << ", " << number(t.m32()) << ", " << number(t.m33()) << " }"
+            << ", " << number(e.opacity) << " },\n";
+    }
+    out << "};\n\n";
+}
+
+int main(int argc, char *argv[])
+{
+    //the svg renderer needs QtGui but there's nothing to show.
+    QApplication app(argc, argv, false);
+
+    QStringList args = app.arguments();
+    if(args.count() < 3) {
+        qWarning("usage: glyphcompiler <output.cpp> <stitch.svg>...");
+        return 1;
+    }
+
+    QFile output(args.at(1));
+    if(!output.open(QIODevice::WriteOnly | QIODevice::Text)) {
+        qWarning("glyphcompiler: cannot open %s for writing", qPrintable(args.at(1)));
+        return 1;
+    }
+
+    QTextStream out(&output);
+    out << "/* Generated by glyphcompiler from the built in stitch svgs. Do not edit. */\n";
+    out << "#include \"builtinglyphs.h\"\n\n";
+
+    QStringList compiled;
+    QList<QSizeF> sizes;
+
+    for(int i = 2; i < args.count(); ++i) {
+        QFile file(args.at(i));
+        if(!file.open(QIODevice::ReadOnly)) {
+            qWarning("glyphcompiler: cannot open %s", qPrintable(args.at(i)));
+            continue;
+        }
+
+        StitchGlyph glyph;
+        if(!glyph.load(file.readAll()) || !isCompilable(glyph)) {
+            qWarning("glyphcompiler: %s will be loaded at runtime", qPrintable(args.at(i)));
+            continue;
+        }
+
+        writeGlyph(out, glyph, compiled.count());
+        compiled.append(QFileInfo(args.at(i)).fileName());
+        sizes.append(glyph.boundingRect().size());
+    }
+
+    out << "const BuiltInGlyph builtInGlyphs[] = {\n";
+    for(int i = 0; i < compiled.count(); ++i) {
+        out << "    { \":/stitches/" << compiled.at(i) << "\", " << number(sizes.at(i).width())
+            << ", " << number(sizes.at(i).height()) << ", glyph" << i << "_elements, "
+            << "sizeof(glyph" << i << "_elements) / sizeof(BuiltInGlyph::Element) },\n";
+    }
+    //keep the array from being empty if nothing could be compiled.
+    out << "    { 0, 0, 0, 0, 0 }\n";
+    out << "};\n\n";
+    out << "const int builtInGlyphCount = " << compiled.count() << ";\n";
+
+    return 0;
+}
@@ -43,6 +43,7 @@ Indicator::Indicator(QGraphicsItem* parent, QGraphicsScene* scene)
     setFlag(QGraphicsItem::ItemIsMovable);
     setFlag(QGraphicsItem::ItemIsSelectable);
     setFlag(QGraphicsItem::ItemIsFocusable);
+    setFlag(QGraphicsItem::ItemSendsGeometryChanges);
     setZValue(150);
 	
     mStyle = Settings::inst()->value("chartRowIndicator").toString();
@@ -50,6 +51,26 @@ Indicator::Indicator(QGraphicsItem* parent, QGraphicsScene* scene)
 
 Indicator::~Indicator()
 {
+    Scene::trackItemChange(this, QGraphicsItem::ItemSceneChange, QVariant());
+}
+
+QVariant Indicator::itemChange(GraphicsItemChange change, const QVariant& value)
+{
+    Scene::trackItemChange(this, change, value);
+    return QGraphicsTextItem::itemChange(change, value);
+}
+
+void Indicator::setLayer(unsigned int layer)
+{
+    mLayer = layer;
+    Scene::trackLayerChange(this);
+}
+
+void Indicator::setStyle(QString style)
+{
+    mStyle = style;
+    Scene::trackPaintChange(this);
+    update();
 }
 
 QRectF Indicator::boundingRect() const
@@ -71,10 +92,13 @@ QString Indicator::text() {
 void Indicator::setText(QString t)
 {
 	setPlainText(t);
+	Scene::trackGeometryChange(this);
 }
 
 void Indicator::paint(QPainter* painter, const QStyleOptionGraphicsItem* option, QWidget* widget)
 {
+    if(Scene::isDrawnFromLayerCache(this, mLayer, widget))
+        return;
 
     QString color = Settings::inst()->value("chartIndicatorColor").toString();
 
@@ -120,6 +144,8 @@ void Indicator::focusOutEvent(QFocusEvent* event)
 {
     QGraphicsTextItem::focusOutEvent(event);
     setTextInteractionFlags(Qt::NoTextInteraction);
+    //the text may have changed the size of the indicator.
+    Scene::trackGeometryChange(this);
 	
 	//if the old text is different from the current text, add it to the undo stack
 	if (oldText.compare(text()) != 0) {
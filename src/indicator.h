@@ -24,6 +24,7 @@
 #include <QGraphicsTextItem>
 
 #include <QLineEdit>
+#include "ChartItemTools.h"
 
 class QFocusEvent;
 class QGraphicsItem;
@@ -56,20 +57,26 @@ public:
     void setTextColor(QColor c) { mTextColor = c; }
 
     QString style() { return mStyle; }
-    void setStyle(QString style) { mStyle = style; update();}
+    void setStyle(QString style);
 
     QPainterPath shape() const;
 
     bool highlight;
 	
 	unsigned int layer() { return mLayer; }
-	void setLayer(unsigned int layer) { mLayer = layer; }
+	void setLayer(unsigned int layer);
+
+    /**
+     * The rotation and scale ChartItemTools sets on the indicator.
+     */
+    ChartItemTransform* chartTransform() { return &mChartTransform; }
 
 signals:
     void lostFocus(Indicator *item);
     void gotFocus(Indicator *item);
 
 protected:
+    QVariant itemChange(GraphicsItemChange change, const QVariant& value);
     void focusInEvent(QFocusEvent* event);
     void focusOutEvent(QFocusEvent* event);
     void keyReleaseEvent(QKeyEvent* event);
@@ -84,6 +91,7 @@ private:
 
     QString mStyle;
 	QString oldText;
+    ChartItemTransform mChartTransform;
 
 };
 #endif //INDICATOR_H
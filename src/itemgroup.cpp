@@ -22,6 +22,7 @@
 #include <QPainter>
 #include <QGraphicsSceneEvent>
 #include "ChartItemTools.h"
+#include "scene.h"
 #include "debug.h"
 
 ItemGroup::ItemGroup(QGraphicsItem *parent, QGraphicsScene *scene)
@@ -35,11 +36,25 @@ ItemGroup::ItemGroup(QGraphicsItem *parent, QGraphicsScene *scene)
 
     setFlag(QGraphicsItem::ItemIsMovable);
     setFlag(QGraphicsItem::ItemIsSelectable);
+    setFlag(QGraphicsItem::ItemSendsGeometryChanges);
     setHandlesChildEvents(true);
 }
 
 ItemGroup::~ItemGroup()
 {
+    Scene::trackItemChange(this, QGraphicsItem::ItemSceneChange, QVariant());
+}
+
+QVariant ItemGroup::itemChange(GraphicsItemChange change, const QVariant &value)
+{
+    Scene::trackItemChange(this, change, value);
+    return QGraphicsItemGroup::itemChange(change, value);
+}
+
+void ItemGroup::setLayer(unsigned int layer)
+{
+    mLayer = layer;
+    Scene::trackLayerChange(this);
 }
 
 QRectF ItemGroup::boundingRect() const
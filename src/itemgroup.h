@@ -22,6 +22,7 @@
 #define ITEMGROUP_H
 
 #include <QGraphicsItemGroup>
+#include "ChartItemTools.h"
 
 class ItemGroup : public QGraphicsItemGroup
 {
@@ -42,10 +43,20 @@ public:
     void addToGroup(QGraphicsItem *item);
 	
 	unsigned int layer() { return mLayer; }
-	void setLayer(unsigned int layer) { mLayer = layer; }
+	void setLayer(unsigned int layer);
+
+    /**
+     * The rotation and scale ChartItemTools sets on the group.
+     */
+    ChartItemTransform* chartTransform() { return &mChartTransform; }
+
+protected:
+    QVariant itemChange(GraphicsItemChange change, const QVariant &value);
+
 private:
 	//the layer of the group
 	unsigned int mLayer;
     QPointF mScale;
+    ChartItemTransform mChartTransform;
 };
 #endif //ITEMGROUP_H
@@ -36,6 +36,7 @@
 
 #include "stitchreplacerui.h"
 #include "colorreplacer.h"
+#include "chartlayout.h"
 
 #include "debug.h"
 #include <QDialog>
@@ -54,6 +55,8 @@
 #include <QCloseEvent>
 #include <QUndoStack>
 #include <QUndoView>
+#include <QVBoxLayout>
+#include <QLabel>
 #include <QTimer>
 
 #include <QSortFilterProxyModel>
@@ -68,6 +71,7 @@ MainWindow::MainWindow(QStringList fileNames, QWidget* parent)
     mRowsDock(0),
     mMirrorDock(0),
     mPropertiesDock(0),
+    mMinimapDock(0),
     mEditMode(10),
     mStitch("ch"),
     mFgColor(QColor(Qt::black)),
@@ -248,7 +252,15 @@ void MainWindow::setupNewTabDialog()
     ui->chartStyle->setCurrentIndex(ui->chartStyle->findText(defStyle));
 
     newChartUpdateStyle(defStyle);
+    newChartUpdatePreview();
     connect(ui->chartStyle, SIGNAL(currentIndexChanged(QString)), SLOT(newChartUpdateStyle(QString)));
+
+    connect(ui->chartStyle, SIGNAL(currentIndexChanged(int)), SLOT(newChartUpdatePreview()));
+    connect(ui->rows, SIGNAL(valueChanged(int)), SLOT(newChartUpdatePreview()));
+    connect(ui->stitches, SIGNAL(valueChanged(int)), SLOT(newChartUpdatePreview()));
+    connect(ui->increaseBy, SIGNAL(valueChanged(int)), SLOT(newChartUpdatePreview()));
+    connect(ui->rowSpacing, SIGNAL(currentIndexChanged(int)), SLOT(newChartUpdatePreview()));
+    connect(ui->defaultStitch, SIGNAL(currentIndexChanged(int)), SLOT(newChartUpdatePreview()));
     
     connect(ui->newDocBttnBox, SIGNAL(accepted()), this, SLOT(newChart()));
     connect(ui->newDocBttnBox, SIGNAL(rejected()), ui->newDocument, SLOT(hide()));   
@@ -268,6 +280,7 @@ void MainWindow::newChartUpdateStyle(QString style)
         ui->defaultStitchLbl->setVisible(false);
         ui->increaseBy->setVisible(false);
         ui->increaseByLbl->setVisible(false);
+        ui->chartPreview->setVisible(false);
     } else if(style == tr("Rounds")){
         ui->rows->setVisible(true);
         ui->rowsLbl->setVisible(true);
@@ -281,6 +294,7 @@ void MainWindow::newChartUpdateStyle(QString style)
         ui->stitchesLbl->setText(tr("Starting Stitches:"));
         ui->increaseBy->setVisible(true);
         ui->increaseByLbl->setVisible(true);
+        ui->chartPreview->setVisible(true);
     } else if (style == tr("Rows")) {
         ui->rows->setVisible(true);
         ui->rowsLbl->setVisible(true);
@@ -294,9 +308,52 @@ void MainWindow::newChartUpdateStyle(QString style)
         ui->stitchesLbl->setText(tr("Stitches:"));
         ui->increaseBy->setVisible(false);
         ui->increaseByLbl->setVisible(false);
+        ui->chartPreview->setVisible(true);
     }
 }
 
+void MainWindow::newChartUpdatePreview()
+{
+    QString style = ui->chartStyle->currentText();
+    if(style == tr("Blank"))
+        return;
+
+    Stitch* s = StitchLibrary::inst()->findStitch(ui->defaultStitch->currentText());
+    if(!s)
+        s = StitchLibrary::inst()->findStitch(Settings::inst()->value("defaultStitch").toString());
+    QSizeF stitchSize = s ? QSizeF(s->width(), s->height()) : QSizeF(32, 32);
+
+    int rows = ui->rows->value();
+    int cols = ui->stitches->value();
+    qreal rowHeight = newChartRowHeight();
+
+    if(style == tr("Rounds"))
+        ui->chartPreview->setChartLayout(ChartLayout::rounds(rows, cols, ui->increaseBy->value(), rowHeight, stitchSize));
+    else
+        ui->chartPreview->setChartLayout(ChartLayout::rows(rows, cols, QSizeF(32, rowHeight), stitchSize));
+}
+
+qreal MainWindow::newChartRowHeight() const
+{
+    QString ddValue = ui->rowSpacing->currentText();
+    qreal rowHeight = 96;
+
+    if(ddValue == tr("1 Chain"))
+        rowHeight = 32;
+    else if (ddValue == tr("2 Chains"))
+        rowHeight = 64;
+    else if (ddValue == tr("3 Chains"))
+        rowHeight = 96;
+    else if (ddValue == tr("4 Chains"))
+        rowHeight = 128;
+    else if (ddValue == tr("5 Chains"))
+        rowHeight = 160;
+    else if (ddValue == tr("6 Chains"))
+        rowHeight = 182;
+
+    return rowHeight;
+}
+
 void MainWindow::propertiesUpdate(QString property, QVariant newValue)
 {
 
@@ -412,8 +469,16 @@ void MainWindow::setupDocks()
     mUndoDock = new QDockWidget(this);
     mUndoDock->setVisible(false);
     mUndoDock->setObjectName("undoHistory");
-    QUndoView* view = new QUndoView(&mUndoGroup, mUndoDock);
-    mUndoDock->setWidget(view);
+    QWidget* undoWidget = new QWidget(mUndoDock);
+    QVBoxLayout* undoLayout = new QVBoxLayout(undoWidget);
+    undoLayout->setContentsMargins(0, 0, 0, 0);
+    QUndoView* view = new QUndoView(&mUndoGroup, undoWidget);
+    undoLayout->addWidget(view);
+    mUndoMemoryLabel = new QLabel(undoWidget);
+    undoLayout->addWidget(mUndoMemoryLabel);
+    mUndoDock->setWidget(undoWidget);
+    connect(&mUndoGroup, SIGNAL(activeStackChanged(QUndoStack*)), SLOT(undoStackChanged(QUndoStack*)));
+    undoStackChanged(0);
     mUndoDock->setWindowTitle(tr("Undo History"));
     mUndoDock->setFloating(true);
 	
@@ -440,12 +505,18 @@ void MainWindow::setupDocks()
     connect(mMirrorDock, SIGNAL(mirror(int)), SLOT(mirror(int)));
 	connect(mMirrorDock, SIGNAL(copy(int)), SLOT(copy(int)));
     connect(mMirrorDock, SIGNAL(rotate(qreal)), SLOT(rotate(qreal)));
+    connect(mMirrorDock, SIGNAL(replicate(int,qreal,QPointF)), SLOT(replicate(int,qreal,QPointF)));
     connect(mMirrorDock, SIGNAL(visibilityChanged(bool)), ui->actionShowMirrorDock, SLOT(setChecked(bool)));
 
     mPropertiesDock = new PropertiesDock(ui->tabWidget, this);
     connect(mPropertiesDock, SIGNAL(visibilityChanged(bool)), ui->actionShowProperties, SLOT(setChecked(bool)));
     connect(mPropertiesDock, SIGNAL(propertiesUpdated(QString,QVariant)), SLOT(propertiesUpdate(QString,QVariant)));
 	connect(mPropertiesDock, SIGNAL(setGridType(QString)), SLOT(setSelectedGridMode(QString)));
+
+    //Overview of the whole chart.
+    mMinimapDock = new MinimapDock(ui->tabWidget, this);
+    connect(mMinimapDock, SIGNAL(visibilityChanged(bool)), ui->actionShowMinimap, SLOT(setChecked(bool)));
+    connect(ui->tabWidget, SIGNAL(currentChanged(int)), mMinimapDock, SLOT(updateContent(int)));
 }
 
 void MainWindow::setupMenus()
@@ -516,6 +587,7 @@ void MainWindow::setupMenus()
 	connect(ui->actionShowLayers, SIGNAL(triggered()), SLOT(viewShowLayers()));
 
     connect(ui->actionShowUndoHistory, SIGNAL(triggered()), SLOT(viewShowUndoHistory()));
+    connect(ui->actionShowMinimap, SIGNAL(triggered()), SLOT(viewShowMinimap()));
     
     connect(ui->actionShowMainToolbar, SIGNAL(triggered()), SLOT(viewShowMainToolbar()));
     connect(ui->actionShowEditModeToolbar, SIGNAL(triggered()), SLOT(viewShowEditModeToolbar()));
@@ -580,6 +652,12 @@ void MainWindow::setupMenus()
     
     connect(ui->menuChart, SIGNAL(aboutToShow()), SLOT(menuChartAboutToShow()));
     connect(ui->actionEditName, SIGNAL(triggered()), SLOT(chartEditName()));
+
+    //the colorways are listed when the menu is opened.
+    mColorwaysMenu = ui->menuChart->addMenu(tr("Colorways"));
+    mColorwayGroup = new QActionGroup(this);
+    connect(mColorwaysMenu, SIGNAL(aboutToShow()), SLOT(menuColorwaysAboutToShow()));
+    connect(mColorwayGroup, SIGNAL(triggered(QAction*)), SLOT(chartSelectColorway(QAction*)));
     //TODO: get more icons from the theme for use with table editing.
     //http://doc.qt.nokia.com/4.7/qstyle.html#StandardPixmap-enum
 
@@ -597,6 +675,12 @@ void MainWindow::setupMenus()
     connect(ui->actionReplaceStitch, SIGNAL(triggered()), SLOT(stitchesReplaceStitch()));
     connect(ui->actionColorReplacer, SIGNAL(triggered()), SLOT(stitchesReplaceColor()));
 
+    ui->menuStitches->addSeparator();
+    mActionSelectSameStitch = ui->menuStitches->addAction(tr("Select All With This Stitch"),
+                                                          this, SLOT(stitchesSelectSameStitch()));
+    mActionSelectSameColor = ui->menuStitches->addAction(tr("Select All With This Color"),
+                                                         this, SLOT(stitchesSelectSameColor()));
+
     //stitches menu
     connect(ui->menuStitches, SIGNAL(aboutToShow()), SLOT(menuStitchesAboutToShow()));
 
@@ -1258,6 +1342,7 @@ void MainWindow::menuViewAboutToShow()
 	ui->actionShowLayers->setChecked(ui->layersDock->isVisible());
 
     ui->actionShowUndoHistory->setChecked(mUndoDock->isVisible());
+    ui->actionShowMinimap->setChecked(mMinimapDock->isVisible());
     
     ui->actionShowEditModeToolbar->setChecked(ui->editModeToolBar->isVisible());
     ui->actionShowMainToolbar->setChecked(ui->mainToolBar->isVisible());
@@ -1288,6 +1373,40 @@ void MainWindow::menuStitchesAboutToShow()
     ui->actionGroup->setEnabled(hasTab() && curCrochetTab());
     ui->actionUngroup->setEnabled(hasTab() && curCrochetTab());
 
+    bool hasCell = (selectedCell() != 0);
+    mActionSelectSameStitch->setEnabled(hasCell);
+    mActionSelectSameColor->setEnabled(hasCell);
+}
+
+Cell* MainWindow::selectedCell()
+{
+    CrochetTab *tab = curCrochetTab();
+    if(!tab)
+        return 0;
+
+    foreach(QGraphicsItem *i, tab->selectedItems()) {
+        if(i->type() == Cell::Type)
+            return qgraphicsitem_cast<Cell*>(i);
+    }
+    return 0;
+}
+
+void MainWindow::stitchesSelectSameStitch()
+{
+    Cell *c = selectedCell();
+    if(!c)
+        return;
+
+    curCrochetTab()->scene()->selectCellsWithStitch(c->name());
+}
+
+void MainWindow::stitchesSelectSameColor()
+{
+    Cell *c = selectedCell();
+    if(!c)
+        return;
+
+    curCrochetTab()->scene()->selectCellsWithColor(c->color());
 }
 
 void MainWindow::stitchesReplaceStitch()
@@ -1314,7 +1433,7 @@ void MainWindow::stitchesReplaceStitch()
 		}
     }
 
-    StitchReplacerUi *sr = new StitchReplacerUi(curStitch, mPatternStitches.keys(), this);
+    StitchReplacerUi *sr = new StitchReplacerUi(curStitch, mPatternStitches.keys(), tab->scene(), this);
 
     if(sr->exec() == QDialog::Accepted) {
         if(!sr->original.isEmpty())
@@ -1332,7 +1451,7 @@ void MainWindow::stitchesReplaceColor()
     if(mPatternColors.count() <= 0)
         return;
 
-    ColorReplacer *cr = new ColorReplacer(mPatternColors.keys(), this);
+    ColorReplacer *cr = new ColorReplacer(mPatternColors.keys(), tab->scene(), this);
 
     if(cr->exec() == QDialog::Accepted) {
         tab->replaceColor(cr->originalColor, cr->newColor, cr->selection);
@@ -1400,21 +1519,7 @@ void MainWindow::newChart()
     ui->tabWidget->addTab(tab, name);
     ui->tabWidget->setCurrentWidget(tab);
 
-    QString ddValue = ui->rowSpacing->currentText();
-    qreal rowHeight = 96;
-
-    if(ddValue == tr("1 Chain"))
-        rowHeight = 32;
-    else if (ddValue == tr("2 Chains"))
-        rowHeight = 64;
-    else if (ddValue == tr("3 Chains"))
-        rowHeight = 96;
-    else if (ddValue == tr("4 Chains"))
-        rowHeight = 128;
-    else if (ddValue == tr("5 Chains"))
-        rowHeight = 160;
-    else if (ddValue == tr("6 Chains"))
-        rowHeight = 182;
+    qreal rowHeight = newChartRowHeight();
 
     tab->createChart(st, rows, cols, defStitch, QSizeF(32, rowHeight), incBy);
 
@@ -1504,6 +1609,35 @@ void MainWindow::viewShowUndoHistory()
     mUndoDock->setVisible(ui->actionShowUndoHistory->isChecked());
 }
 
+void MainWindow::undoStackChanged(QUndoStack* stack)
+{
+    if(mUndoMemory)
+        mUndoMemory->disconnect(this);
+
+    mUndoMemory = UndoMemory::forStack(stack);
+    if(!mUndoMemory) {
+        updateUndoMemory(0, 0);
+        return;
+    }
+
+    connect(mUndoMemory, SIGNAL(usageChanged(qint64,qint64)), SLOT(updateUndoMemory(qint64,qint64)));
+    updateUndoMemory(mUndoMemory->memoryUsage(), mUndoMemory->spilledSize());
+}
+
+void MainWindow::updateUndoMemory(qint64 memory, qint64 spilled)
+{
+    const qreal mb = 1024.0 * 1024.0;
+    QString text = tr("Undo memory: %1 MB").arg(memory / mb, 0, 'f', 1);
+    if(spilled > 0)
+        text += tr(" (%1 MB on disk)").arg(spilled / mb, 0, 'f', 1);
+    mUndoMemoryLabel->setText(text);
+}
+
+void MainWindow::viewShowMinimap()
+{
+    mMinimapDock->setVisible(ui->actionShowMinimap->isChecked());
+}
+
 void MainWindow::viewMakePropertiesVisible()
 {
 	ui->actionShowProperties->setChecked(true);
@@ -1647,6 +1781,95 @@ void MainWindow::menuChartAboutToShow()
 
 }
 
+void MainWindow::menuColorwaysAboutToShow()
+{
+    foreach(QAction* a, mColorwayGroup->actions())
+        delete a;
+    mColorwaysMenu->clear();
+
+    CrochetTab* tab = curCrochetTab();
+    if(!tab)
+        return;
+
+    ColorPalette* palette = tab->scene()->cellPalette();
+    for(int i = 0; i < palette->colorwayCount(); ++i) {
+        QAction* a = new QAction(palette->colorwayName(i), mColorwayGroup);
+        a->setCheckable(true);
+        a->setChecked(i == palette->currentColorway());
+        a->setData(i);
+        mColorwaysMenu->addAction(a);
+    }
+
+    mColorwaysMenu->addSeparator();
+    mColorwaysMenu->addAction(tr("New Colorway..."), this, SLOT(chartAddColorway()));
+    mColorwaysMenu->addAction(tr("Rename Colorway..."), this, SLOT(chartRenameColorway()));
+    QAction* remove = mColorwaysMenu->addAction(tr("Remove Colorway"), this, SLOT(chartRemoveColorway()));
+    remove->setEnabled(palette->colorwayCount() > 1);
+}
+
+void MainWindow::chartSelectColorway(QAction* action)
+{
+    CrochetTab* tab = curCrochetTab();
+    if(!tab)
+        return;
+
+    tab->scene()->setCurrentColorway(action->data().toInt());
+    documentIsModified(true);
+}
+
+void MainWindow::chartAddColorway()
+{
+    CrochetTab* tab = curCrochetTab();
+    if(!tab)
+        return;
+
+    ColorPalette* palette = tab->scene()->cellPalette();
+    bool ok;
+    QString name = QInputDialog::getText(this, tr("New Colorway"), tr("Colorway name:"),
+                                         QLineEdit::Normal, tr("Colorway %1").arg(palette->colorwayCount() + 1), &ok);
+    if(!ok || name.isEmpty())
+        return;
+
+    //the new colorway starts as a copy of the current one and is switched to so it can be edited.
+    tab->scene()->addColorwayUndoable(name);
+}
+
+void MainWindow::chartRenameColorway()
+{
+    CrochetTab* tab = curCrochetTab();
+    if(!tab)
+        return;
+
+    ColorPalette* palette = tab->scene()->cellPalette();
+    int colorway = palette->currentColorway();
+    QString currentName = palette->colorwayName(colorway);
+    bool ok;
+    QString name = QInputDialog::getText(this, tr("Rename Colorway"), tr("Colorway name:"),
+                                         QLineEdit::Normal, currentName, &ok);
+    if(ok && !name.isEmpty())
+        tab->scene()->setColorwayNameUndoable(colorway, name);
+}
+
+void MainWindow::chartRemoveColorway()
+{
+    CrochetTab* tab = curCrochetTab();
+    if(!tab)
+        return;
+
+    ColorPalette* palette = tab->scene()->cellPalette();
+    if(palette->colorwayCount() <= 1)
+        return;
+
+    QMessageBox msgbox(this);
+    msgbox.setText(tr("Remove the colorway \"%1\"?").arg(palette->colorwayName(palette->currentColorway())));
+    msgbox.setStandardButtons(QMessageBox::Yes | QMessageBox::No);
+    msgbox.setIcon(QMessageBox::Question);
+    if(msgbox.exec() != QMessageBox::Yes)
+        return;
+
+    tab->scene()->removeColorwayUndoable(palette->currentColorway());
+}
+
 void MainWindow::chartsShowChartCenter()
 {
 
@@ -1978,6 +2201,12 @@ void MainWindow::rotate(qreal degrees)
     if(tab) tab->rotate(degrees);
 }
 
+void MainWindow::replicate(int copies, qreal degrees, QPointF step)
+{
+    CrochetTab* tab = curCrochetTab();
+    if(tab) tab->replicate(copies, degrees, step);
+}
+
 void MainWindow::resize(QRectF scenerect)
 {
     CrochetTab* tab = curCrochetTab();
@@ -26,16 +26,19 @@
 #include "filefactory.h"
 #include "updater.h"
 #include "undogroup.h"
+#include "undomemory.h"
 
 #include "resizeui.h"
 #include "aligndock.h"
 #include "rowsdock.h"
 #include "mirrordock.h"
 #include "propertiesdock.h"
+#include "minimapdock.h"
 
 #include <QSortFilterProxyModel>
 
 #include <QModelIndex>
+#include <QPointer>
 
 #include "scene.h"
 
@@ -43,6 +46,7 @@ class CrochetTab;
 class QPrinter;
 class QPainter;
 class QActionGroup;
+class QLabel;
 
 namespace Ui {
     class MainWindow;
@@ -64,6 +68,8 @@ public:
 
     bool hasTab();
     void setupNewTabDialog();
+    //the row height picked in the new chart options.
+    qreal newChartRowHeight() const;
 
 protected:
     void closeEvent(QCloseEvent* event);
@@ -87,6 +93,7 @@ protected slots:
     void tabChanged(int newTab);
     
     void newChartUpdateStyle(QString style);
+    void newChartUpdatePreview();
 
     void propertiesUpdate(QString property, QVariant newValue);
     
@@ -111,6 +118,9 @@ private slots:
     void viewShowPatternStitches();
 	void viewShowLayers();
     void viewShowUndoHistory();
+    void undoStackChanged(QUndoStack* stack);
+    void updateUndoMemory(qint64 memory, qint64 spilled);
+    void viewShowMinimap();
     void viewShowMainToolbar();
     void viewShowEditModeToolbar();
     void viewFullScreen(bool state);
@@ -140,9 +150,17 @@ private slots:
     void chartsShowChartCenter();
     void chartCreateRows(bool state);
 
+    void menuColorwaysAboutToShow();
+    void chartSelectColorway(QAction* action);
+    void chartAddColorway();
+    void chartRenameColorway();
+    void chartRemoveColorway();
+
     void menuStitchesAboutToShow();
     void stitchesReplaceStitch();
     void stitchesReplaceColor();
+    void stitchesSelectSameStitch();
+    void stitchesSelectSameColor();
 
     void menuToolsAboutToShow();
     void toolsOptions();
@@ -243,6 +261,7 @@ private slots:
 	void copy(int direction);
     void mirror(int direction);
     void rotate(qreal degrees);
+    void replicate(int copies, qreal degrees, QPointF step);
 	void resize(QRectF scenerect);
 
     void updateGuidelines(Guidelines guidelines);
@@ -258,6 +277,14 @@ private:
     QActionGroup* mModeGroup;
 	QActionGroup* mSelectGroup;
 	QActionGroup* mGridGroup;
+
+    QMenu* mColorwaysMenu;
+    QActionGroup* mColorwayGroup;
+
+    QAction* mActionSelectSameStitch;
+    QAction* mActionSelectSameColor;
+    //the first cell in the current selection or 0.
+    Cell* selectedCell();
     
     QAction* mActionUndo,
            * mActionRedo;
@@ -266,7 +293,9 @@ private:
     QList<QAction*> mRecentFilesActs;
     
     QDockWidget* mUndoDock;
+    QLabel* mUndoMemoryLabel;
     UndoGroup mUndoGroup;
+    QPointer<UndoMemory> mUndoMemory;
 	
 	ResizeUI* mResizeUI;
     AlignDock* mAlignDock;
@@ -274,6 +303,7 @@ private:
     MirrorDock* mMirrorDock;
 
     PropertiesDock* mPropertiesDock;
+    MinimapDock* mMinimapDock;
     
     int mEditMode;
     QString mStitch;
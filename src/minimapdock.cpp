@@ -0,0 +1,343 @@
+/****************************************************************************\
+ Copyright (c) 2011-2014 Stitch Works Software
+ Brian C. Milco <bcmilco@gmail.com>
+
+ This file is part of Crochet Charts.
+
+ Crochet Charts is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ Crochet Charts is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with Crochet Charts. If not, see <http://www.gnu.org/licenses/>.
+
+ \****************************************************************************/
+#include "minimapdock.h"
+
+#include "crochettab.h"
+#include "chartview.h"
+#include "scene.h"
+
+#include <QPainter>
+#include <QMouseEvent>
+#include <QScrollBar>
+#include <QTimer>
+
+#include <math.h>
+
+//how long to collect changes before drawing them into the overview.
+#define MINIMAP_UPDATE_DELAY 250
+//past this many changed areas it's cheaper to render their bounding rect once.
+#define MINIMAP_MAX_DIRTY_RECTS 32
+
+Minimap::Minimap(QWidget* parent)
+    : QWidget(parent),
+    mDirtyTimer(new QTimer(this))
+{
+    setMinimumSize(100, 100);
+    setCursor(Qt::PointingHandCursor);
+
+    mDirtyTimer->setSingleShot(true);
+    mDirtyTimer->setInterval(MINIMAP_UPDATE_DELAY);
+    connect(mDirtyTimer, SIGNAL(timeout()), SLOT(renderDirty()));
+}
+
+QSize Minimap::sizeHint() const
+{
+    return QSize(200, 200);
+}
+
+void Minimap::setChart(Scene* scene, ChartView* view)
+{
+    if(mScene)
+        mScene->disconnect(this);
+    if(mView) {
+        mView->disconnect(this);
+        mView->horizontalScrollBar()->disconnect(this);
+        mView->verticalScrollBar()->disconnect(this);
+    }
+
+    mScene = scene;
+    mView = view;
+    mDirty.clear();
+
+    if(mScene) {
+        connect(mScene, SIGNAL(changed(QList<QRectF>)), SLOT(sceneChanged(QList<QRectF>)));
+        connect(mScene, SIGNAL(backgroundChanged(QRectF)), SLOT(backgroundChanged(QRectF)));
+        connect(mScene, SIGNAL(sceneRectChanged(QRectF)), SLOT(sceneRectChanged(QRectF)));
+    }
+
+    if(mView) {
+        connect(mView, SIGNAL(zoomLevelChanged(int)), SLOT(viewChanged()));
+        connect(mView->horizontalScrollBar(), SIGNAL(valueChanged(int)), SLOT(viewChanged()));
+        connect(mView->verticalScrollBar(), SIGNAL(valueChanged(int)), SLOT(viewChanged()));
+    }
+
+    rebuild();
+}
+
+QRectF Minimap::targetRect() const
+{
+    if(!mScene || mCacheSceneRect.isEmpty())
+        return QRectF();
+
+    QSizeF size = mCacheSceneRect.size();
+    size.scale(width(), height(), Qt::KeepAspectRatio);
+
+    return QRectF(QPointF((width() - size.width()) / 2, (height() - size.height()) / 2), size);
+}
+
+QPointF Minimap::mapToScene(const QPoint& pos) const
+{
+    QRectF target = targetRect();
+    if(target.isEmpty())
+        return QPointF();
+
+    qreal scale = mCacheSceneRect.width() / target.width();
+    return mCacheSceneRect.topLeft() + (QPointF(pos) - target.topLeft()) * scale;
+}
+
+QRectF Minimap::mapFromScene(const QRectF& rect) const
+{
+    QRectF target = targetRect();
+    if(target.isEmpty())
+        return QRectF();
+
+    qreal scale = target.width() / mCacheSceneRect.width();
+    return QRectF(target.topLeft() + (rect.topLeft() - mCacheSceneRect.topLeft()) * scale,
+                  rect.size() * scale);
+}
+
+void Minimap::rebuild()
+{
+    mDirty.clear();
+    mDirtyTimer->stop();
+
+    if(!mScene) {
+        mCache = QImage();
+        mCacheSceneRect = QRectF();
+        update();
+        return;
+    }
+
+    mCacheSceneRect = mScene->sceneRect();
+
+    //while hidden just remember the cache is out of date.
+    if(!isVisible()) {
+        mCache = QImage();
+        return;
+    }
+
+    QRectF target = targetRect();
+    if(target.isEmpty()) {
+        mCache = QImage();
+        update();
+        return;
+    }
+
+    mCache = QImage(target.size().toSize(), QImage::Format_ARGB32_Premultiplied);
+    mCache.fill(QColor(Qt::white).rgb());
+
+    QPainter p(&mCache);
+    mScene->render(&p, QRectF(QPointF(0, 0), target.size()), mCacheSceneRect);
+    p.end();
+
+    update();
+}
+
+void Minimap::sceneChanged(const QList<QRectF>& region)
+{
+    if(mCache.isNull())
+        return;
+
+    //drop the cache so showEvent() renders everything edited while hidden.
+    if(!isVisible()) {
+        mCache = QImage();
+        mDirty.clear();
+        return;
+    }
+
+    foreach(const QRectF& r, region) {
+        QRectF dirty = r.intersected(mCacheSceneRect);
+        if(!dirty.isEmpty())
+            mDirty.append(dirty);
+    }
+
+    if(!mDirty.isEmpty() && !mDirtyTimer->isActive())
+        mDirtyTimer->start();
+}
+
+void Minimap::backgroundChanged(const QRectF& rect)
+{
+    sceneChanged(QList<QRectF>() << rect);
+}
+
+void Minimap::sceneRectChanged(const QRectF& rect)
+{
+    if(!mScene || mCache.isNull() || !isVisible() || mCacheSceneRect.isEmpty()) {
+        rebuild();
+        return;
+    }
+
+    QImage old = mCache;
+    QRectF oldSceneRect = mCacheSceneRect;
+
+    mCacheSceneRect = rect;
+    QRectF target = targetRect();
+    if(target.isEmpty()) {
+        rebuild();
+        return;
+    }
+
+    mCache = QImage(target.size().toSize(), QImage::Format_ARGB32_Premultiplied);
+    mCache.fill(QColor(Qt::white).rgb());
+    qreal scale = mCache.width() / mCacheSceneRect.width();
+
+    //put what's already rendered where the old scene rect is in the new one.
+    QRectF moved((oldSceneRect.topLeft() - rect.topLeft()) * scale, oldSceneRect.size() * scale);
+    QPainter p(&mCache);
+    p.setRenderHint(QPainter::SmoothPixmapTransform);
+    p.drawImage(moved, old);
+    p.end();
+
+    //render the pixels the old image doesn't cover completely.
+    QRect kept((int)ceil(moved.left()), (int)ceil(moved.top()), 0, 0);
+    kept.setRight((int)floor(moved.right()) - 1);
+    kept.setBottom((int)floor(moved.bottom()) - 1);
+    QRegion exposed = QRegion(mCache.rect()).subtracted(QRegion(kept));
+
+    foreach(const QRect& r, exposed.rects())
+        mDirty.append(QRectF(rect.topLeft() + QPointF(r.topLeft()) / scale, QSizeF(r.size()) / scale));
+
+    mDirtyTimer->stop();
+    renderDirty();
+    update();
+}
+
+void Minimap::renderDirty()
+{
+    if(!mScene || mCache.isNull() || mDirty.isEmpty())
+        return;
+
+    if(mDirty.count() > MINIMAP_MAX_DIRTY_RECTS) {
+        QRectF bounds;
+        foreach(const QRectF& r, mDirty)
+            bounds = bounds.united(r);
+        mDirty.clear();
+        mDirty.append(bounds);
+    }
+
+    qreal scale = mCache.width() / mCacheSceneRect.width();
+
+    QPainter p(&mCache);
+    foreach(const QRectF& r, mDirty) {
+        //grow the area to whole pixels of the overview so nothing is left half drawn.
+        QRectF target = QRectF((r.topLeft() - mCacheSceneRect.topLeft()) * scale, r.size() * scale);
+        target = QRectF(target.toAlignedRect());
+        QRectF source = QRectF(mCacheSceneRect.topLeft() + target.topLeft() / scale, target.size() / scale);
+
+        p.save();
+        p.setClipRect(target);
+        p.fillRect(target, Qt::white);
+        mScene->render(&p, target, source);
+        p.restore();
+    }
+    p.end();
+
+    mDirty.clear();
+    update();
+}
+
+void Minimap::viewChanged()
+{
+    update();
+}
+
+void Minimap::paintEvent(QPaintEvent* event)
+{
+    Q_UNUSED(event);
+
+    QPainter p(this);
+    p.fillRect(rect(), palette().window());
+
+    if(mCache.isNull())
+        return;
+
+    QRectF target = targetRect();
+    p.drawImage(target.topLeft(), mCache);
+
+    if(!mView)
+        return;
+
+    QRectF visible = mView->mapToScene(mView->viewport()->rect()).boundingRect();
+    QRectF marker = mapFromScene(visible).intersected(target);
+
+    p.setPen(QPen(palette().highlight().color(), 2));
+    p.setBrush(Qt::NoBrush);
+    p.drawRect(marker);
+}
+
+void Minimap::resizeEvent(QResizeEvent* event)
+{
+    QWidget::resizeEvent(event);
+    rebuild();
+}
+
+void Minimap::showEvent(QShowEvent* event)
+{
+    QWidget::showEvent(event);
+
+    if(mCache.isNull())
+        rebuild();
+}
+
+void Minimap::centerViewOn(const QPoint& pos)
+{
+    if(!mView || mCache.isNull())
+        return;
+
+    mView->centerOn(mapToScene(pos));
+}
+
+void Minimap::mousePressEvent(QMouseEvent* event)
+{
+    if(event->button() == Qt::LeftButton)
+        centerViewOn(event->pos());
+}
+
+void Minimap::mouseMoveEvent(QMouseEvent* event)
+{
+    if(event->buttons() & Qt::LeftButton)
+        centerViewOn(event->pos());
+}
+
+MinimapDock::MinimapDock(QTabWidget* tabWidget, QWidget* parent)
+    : QDockWidget(parent),
+    mTabWidget(tabWidget),
+    mMinimap(new Minimap(this))
+{
+    setVisible(false);
+    setFloating(true);
+    setObjectName("minimapDock");
+    setWindowTitle(tr("Overview"));
+    setWidget(mMinimap);
+}
+
+MinimapDock::~MinimapDock()
+{
+}
+
+void MinimapDock::updateContent(int index)
+{
+    CrochetTab* tab = qobject_cast<CrochetTab*>(mTabWidget->widget(index));
+    if(tab)
+        mMinimap->setChart(tab->scene(), tab->view());
+    else
+        mMinimap->setChart(0, 0);
+}
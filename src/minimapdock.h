@@ -0,0 +1,115 @@
+/****************************************************************************\
+ Copyright (c) 2011-2014 Stitch Works Software
+ Brian C. Milco <bcmilco@gmail.com>
+
+ This file is part of Crochet Charts.
+
+ Crochet Charts is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ Crochet Charts is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with Crochet Charts. If not, see <http://www.gnu.org/licenses/>.
+
+ \****************************************************************************/
+#ifndef MINIMAPDOCK_H
+#define MINIMAPDOCK_H
+
+#include <QDockWidget>
+#include <QTabWidget>
+#include <QPointer>
+#include <QImage>
+#include <QList>
+#include <QRectF>
+
+class QTimer;
+class Scene;
+class ChartView;
+
+/**
+ * The overview drawn inside the MinimapDock.
+ *
+ * The whole scene is rendered once into a small image. After that only the
+ * parts of the scene that report a change are rendered again into the image,
+ * and a growing scene rect only renders the strips it adds.
+ */
+class Minimap : public QWidget
+{
+    Q_OBJECT
+
+public:
+    explicit Minimap(QWidget* parent = 0);
+
+    void setChart(Scene* scene, ChartView* view);
+
+    QSize sizeHint() const;
+
+public slots:
+    /**
+     * Throw away the cached image and render the whole scene again.
+     */
+    void rebuild();
+
+protected:
+    void paintEvent(QPaintEvent* event);
+    void resizeEvent(QResizeEvent* event);
+    void showEvent(QShowEvent* event);
+    void mousePressEvent(QMouseEvent* event);
+    void mouseMoveEvent(QMouseEvent* event);
+
+private slots:
+    void sceneChanged(const QList<QRectF>& region);
+    void backgroundChanged(const QRectF& rect);
+    /**
+     * Move and scale the cached image into the new scene rect and render what it doesn't cover.
+     */
+    void sceneRectChanged(const QRectF& rect);
+    void renderDirty();
+    void viewChanged();
+
+private:
+    //the area of the widget the scene is drawn in.
+    QRectF targetRect() const;
+    QPointF mapToScene(const QPoint& pos) const;
+    QRectF mapFromScene(const QRectF& rect) const;
+
+    void centerViewOn(const QPoint& pos);
+
+    QPointer<Scene> mScene;
+    QPointer<ChartView> mView;
+
+    QImage mCache;
+    //the scene rect the cache was rendered for.
+    QRectF mCacheSceneRect;
+
+    QList<QRectF> mDirty;
+    QTimer* mDirtyTimer;
+};
+
+/**
+ * Dock showing an overview of the current chart with the visible part of the chart
+ * marked on it. Clicking or dragging on the overview moves the view.
+ */
+class MinimapDock : public QDockWidget
+{
+    Q_OBJECT
+
+public:
+    MinimapDock(QTabWidget* tabWidget, QWidget* parent = 0);
+    ~MinimapDock();
+
+public slots:
+    void updateContent(int index);
+
+private:
+    QTabWidget* mTabWidget;
+    Minimap* mMinimap;
+};
+
+#endif // MINIMAPDOCK_H
@@ -49,6 +49,10 @@ MirrorDock::MirrorDock(QWidget *parent) :
     connect(ui->rotateCustom, SIGNAL(clicked()), SLOT(rotateCustom()));
 
     connect(ui->rotateBttn, SIGNAL(clicked()), SLOT(genRotate()));
+
+    connect(ui->replicateType, SIGNAL(currentIndexChanged(int)), SLOT(updateReplicateUi()));
+    connect(ui->replicateBttn, SIGNAL(clicked()), SLOT(genReplicate()));
+    updateReplicateUi();
 }
 
 MirrorDock::~MirrorDock()
@@ -71,6 +75,25 @@ void MirrorDock::genCopy()
     emit copy(direction);
 }
 
+void MirrorDock::genReplicate()
+{
+    int copies = ui->replicateCopies->value();
+
+    //around the center the copies are spread evenly over a full turn with the original.
+    if(ui->replicateType->currentIndex() == 0)
+        emit replicate(copies, 360.0 / (copies + 1), QPointF(0, 0));
+    else
+        emit replicate(copies, 0, QPointF(ui->replicateX->value(), ui->replicateY->value()));
+}
+
+void MirrorDock::updateReplicateUi()
+{
+    bool linear = (ui->replicateType->currentIndex() == 1);
+    ui->replicateSpacingLbl->setVisible(linear);
+    ui->replicateX->setVisible(linear);
+    ui->replicateY->setVisible(linear);
+}
+
 void MirrorDock::genMirror()
 {
     int direction = 1;
@@ -22,6 +22,7 @@
 #define MIRRORDOCK_H
 
 #include <QDockWidget>
+#include <QPointF>
 
 namespace Ui {
     class MirrorDock;
@@ -39,6 +40,10 @@ signals:
     void mirror(int direction);
     void rotate(qreal degrees);
 	void copy(int direction);
+    /**
+     * Copies turned by degrees around the chart center and moved by step, each one more than the last.
+     */
+    void replicate(int copies, qreal degrees, QPointF step);
 
 private slots:
     void rotateCustom();
@@ -46,6 +51,8 @@ private slots:
     void genRotate();
     void genMirror();
 	void genCopy();
+    void genReplicate();
+    void updateReplicateUi();
 
 private:
     Ui::MirrorDock *ui;
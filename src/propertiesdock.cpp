@@ -208,7 +208,7 @@ PropertiesData PropertiesDock::selectionProperties()
          xPositionMixed = false, yPositionMixed = false, stitchMixed = false,
          colorMixed = false, bgColorMixed = false;
          
-    foreach(QGraphicsItem *i, mScene->selectedItems()) {
+    foreach(QGraphicsItem *i, mScene->selection()) {
         
         Cell *c = 0;
         ItemGroup *g = 0;
@@ -292,7 +292,7 @@ void PropertiesDock::updateDialogUi()
     if(closing)
         return;
 
-    int count = mScene->selectedItems().count();
+    int count = mScene->selectionCount();
 
     if(count == 0) {
 
@@ -300,10 +300,9 @@ void PropertiesDock::updateDialogUi()
         return;
     } else if(count >= 1) {
         bool theSame = true;
-		QList<QGraphicsItem*> selection = mScene->selectedItems();
-        int firstType = selection.first()->type();
-        for(int i = 1; i < count; ++i) {
-            if(firstType != selection.at(i)->type()) {
+        int firstType = (*mScene->selection().constBegin())->type();
+        foreach(QGraphicsItem* item, mScene->selection()) {
+            if(firstType != item->type()) {
                 theSame = false;
                 break;
             }
@@ -402,7 +401,7 @@ void PropertiesDock::showSingleChartImage()
     ui->gen_scaleY->setValue(p.scale.y());
     ui->gen_scaleY->blockSignals(false);
 	
-    ChartImage *i = qgraphicsitem_cast<ChartImage*>(mScene->selectedItems().first());
+    ChartImage *i = qgraphicsitem_cast<ChartImage*>(*mScene->selection().constBegin());
 	
 	ui->ci_path->blockSignals(true);
 	ui->ci_path->setText(i->filename());
@@ -491,7 +490,7 @@ void PropertiesDock::showSingleIndicator()
     ui->gen_scaleY->setValue(p.scale.y());
     ui->gen_scaleY->blockSignals(false);
 
-    Indicator *i = qgraphicsitem_cast<Indicator*>(mScene->selectedItems().first());
+    Indicator *i = qgraphicsitem_cast<Indicator*>(*mScene->selection().constBegin());
     //ui->ind_indicatorTextEdit->setText(i->text());
     ui->ind_indicatorStyle->blockSignals(true);
     ui->ind_indicatorStyle->setCurrentIndex(ui->ind_indicatorStyle->findText(i->style()));
@@ -39,6 +39,9 @@
 #include "appinfo.h"
 #include "crochetchartcommands.h"
 #include "indicatorundo.h"
+#include "undomemory.h"
+#include "clipboarddata.h"
+#include "chartlayout.h"
 #include <QUrl>
 #include <QKeyEvent>
 #include "stitchlibrary.h"
@@ -47,15 +50,70 @@
 #include <QAction>
 #include <QMenu>
 #include <QVector2D>
+#include <QPainter>
+#include <QStyleOptionGraphicsItem>
+#include <QPicture>
+#include <QTimer>
 
 #include "ChartItemTools.h"
 
-#include "guideline.h"
 
 #ifndef M_PI
 	# define M_PI	3.14159265358979323846
 #endif
 
+/**
+ * The chart center marker, an ellipse that also keeps the scene's selection current.
+ */
+class ChartCenterSymbol : public QGraphicsEllipseItem
+{
+public:
+    ChartCenterSymbol(const QRectF& rect) : QGraphicsEllipseItem(rect)
+    {
+        setFlag(QGraphicsItem::ItemSendsGeometryChanges);
+    }
+    ~ChartCenterSymbol() { Scene::trackItemChange(this, QGraphicsItem::ItemSceneChange, QVariant()); }
+
+protected:
+    QVariant itemChange(GraphicsItemChange change, const QVariant& value)
+    {
+        Scene::trackItemChange(this, change, value);
+        return QGraphicsEllipseItem::itemChange(change, value);
+    }
+};
+
+//gestures on at least this many items drag a picture of them instead of the items.
+#define DRAG_PROXY_MIN_ITEMS 32
+//the largest side in pixels of the image the drag proxy is cached in.
+#define DRAG_PROXY_MAX_CACHE 2048
+
+/**
+ * A picture of the items being moved, rotated or scaled.
+ * It follows the mouse in their place until the gesture is finished.
+ */
+class ChartDragProxy : public QGraphicsItem
+{
+public:
+    ChartDragProxy(const QPicture& picture, const QRectF& rect)
+        : QGraphicsItem(), mPicture(picture), mRect(rect)
+    {
+        setZValue(1000000);
+    }
+
+    QRectF boundingRect() const { return mRect; }
+
+    void paint(QPainter* painter, const QStyleOptionGraphicsItem* option, QWidget* widget)
+    {
+        Q_UNUSED(option);
+        Q_UNUSED(widget);
+        painter->drawPicture(0, 0, mPicture);
+    }
+
+private:
+    QPicture mPicture;
+    QRectF mRect;
+};
+
 Guidelines::Guidelines()
     : mType("None"),
       mRows(Settings::inst()->value("rowCount").toInt()),
@@ -159,8 +217,15 @@ Scene::Scene(QObject* parent) :
 	mSelectedLayer(0),
 	mSelectMode(BoxSelect),
 	mSelectionBand(0),
-	mbackgroundIsEnabled(true)
+	mbackgroundIsEnabled(true),
+	mLayerCacheVersion(0),
+	mCellChangesPending(false),
+	mDragProxy(0),
+	mDragAngle(0.0),
+	mDragScale(QPointF(1.0, 1.0))
 {
+    new UndoMemory(&mUndoStack);
+
     mPivotPt = QPointF(mDefaultSize.width()/2, mDefaultSize.height());
 	
 }
@@ -173,6 +238,659 @@ Scene::~Scene()
 	}
 }
 
+void Scene::trackItemChange(QGraphicsItem* item, QGraphicsItem::GraphicsItemChange change, const QVariant& value)
+{
+    Scene* s = qobject_cast<Scene*>(item->scene());
+    if(!s)
+        return;
+
+    switch(change) {
+        case QGraphicsItem::ItemSelectedHasChanged:
+            if(value.toBool())
+                s->mSelection.insert(item);
+            else
+                s->mSelection.remove(item);
+            break;
+        case QGraphicsItem::ItemSceneChange:
+            //the item is leaving this scene.
+            if(item->type() == Cell::Type) {
+                s->mCellIndex.remove(static_cast<Cell*>(item));
+                s->countCell(static_cast<Cell*>(item), -1);
+            }
+            s->mSelection.remove(item);
+            s->mIndexDirty.remove(item);
+            if(s->mIndex.contains(item) && s->isLayerCached(s->mIndex.layer(item)))
+                ++s->mLayerCacheVersion;
+            s->mIndex.remove(item);
+            s->mBelowCells.remove(item);
+            break;
+        case QGraphicsItem::ItemSceneHasChanged:
+            if(item->type() == Cell::Type) {
+                s->mCellIndex.update(static_cast<Cell*>(item));
+                s->countCell(static_cast<Cell*>(item), 1);
+            }
+            if(item->isSelected())
+                s->mSelection.insert(item);
+            s->mIndexDirty.insert(item);
+            break;
+        case QGraphicsItem::ItemParentChange:
+            //the old group loses the item.
+            if(item->parentItem())
+                s->mIndexDirty.insert(item->topLevelItem());
+            break;
+        case QGraphicsItem::ItemParentHasChanged:
+        case QGraphicsItem::ItemPositionHasChanged:
+        case QGraphicsItem::ItemTransformHasChanged:
+        case QGraphicsItem::ItemZValueHasChanged:
+            s->mIndexDirty.insert(item);
+            if(item->parentItem())
+                s->mIndexDirty.insert(item->topLevelItem());
+            break;
+        default:
+            break;
+    }
+}
+
+void Scene::trackGeometryChange(QGraphicsItem* item)
+{
+    Scene* s = qobject_cast<Scene*>(item->scene());
+    if(!s)
+        return;
+
+    s->mIndexDirty.insert(item);
+    if(item->parentItem())
+        s->mIndexDirty.insert(item->topLevelItem());
+}
+
+void Scene::trackLayerChange(QGraphicsItem* item)
+{
+    Scene* s = qobject_cast<Scene*>(item->scene());
+    if(!s)
+        return;
+
+    s->mIndexDirty.insert(item);
+    s->updateSpatialIndex();
+}
+
+static int itemLayer(QGraphicsItem* item)
+{
+    switch(item->type()) {
+        case Cell::Type:
+            return qgraphicsitem_cast<Cell*>(item)->layer();
+        case Indicator::Type:
+            return qgraphicsitem_cast<Indicator*>(item)->layer();
+        case ItemGroup::Type:
+            return qgraphicsitem_cast<ItemGroup*>(item)->layer();
+        case ChartImage::Type:
+            return qgraphicsitem_cast<ChartImage*>(item)->layer();
+        default:
+            return SpatialIndex::NoLayer;
+    }
+}
+
+//the stitch Cell::setStitch(QString) would use for the name.
+static Stitch* findStitchOrDefault(const QString& name)
+{
+    Stitch* stitch = StitchLibrary::inst()->findStitch(name);
+    if(!stitch)
+        stitch = StitchLibrary::inst()->findStitch(Settings::inst()->value("defaultStitch").toString());
+    return stitch;
+}
+
+void Scene::trackPaintChange(QGraphicsItem* item)
+{
+    Scene* s = qobject_cast<Scene*>(item->scene());
+    if(!s)
+        return;
+
+    if(s->isLayerCached(itemLayer(item->topLevelItem())))
+        ++s->mLayerCacheVersion;
+}
+
+void Scene::trackStitchChange(QGraphicsItem* item, const QString& oldStitch, const QString& newStitch)
+{
+    Scene* s = qobject_cast<Scene*>(item->scene());
+    if(!s)
+        return;
+
+    if(!oldStitch.isEmpty())
+        --s->mStitchChanges[oldStitch];
+    ++s->mStitchChanges[newStitch];
+
+    s->queueCellChanges();
+}
+
+void Scene::trackColorChange(QGraphicsItem* item, const QString& oldColor, const QString& newColor)
+{
+    Scene* s = qobject_cast<Scene*>(item->scene());
+    if(!s)
+        return;
+
+    if(!oldColor.isEmpty())
+        --s->mColorChanges[oldColor];
+    if(!newColor.isEmpty())
+        ++s->mColorChanges[newColor];
+
+    s->queueCellChanges();
+}
+
+void Scene::countCell(Cell* cell, int count)
+{
+    //however a cell gets in or out of the chart its stitch and colors are counted.
+    if(cell->stitch())
+        mStitchChanges[cell->stitch()->name()] += count;
+    if(cell->colorIndex() >= 0)
+        mColorChanges[cell->color().name()] += count;
+    QString bg = cell->countedBgColor();
+    if(!bg.isEmpty())
+        mColorChanges[bg] += count;
+
+    queueCellChanges();
+}
+
+void Scene::queueCellChanges()
+{
+    if(!mCellChangesPending) {
+        mCellChangesPending = true;
+        QTimer::singleShot(0, this, SLOT(sendCellChanges()));
+    }
+}
+
+void Scene::trackCellChange(Cell* cell)
+{
+    Scene* s = qobject_cast<Scene*>(cell->scene());
+    if(!s)
+        return;
+
+    s->mCellIndex.update(cell);
+}
+
+QList<Cell*> Scene::cellsWithStitch(const QString& stitch)
+{
+    QList<Cell*> cells;
+    foreach(int id, mCellIndex.stitches()) {
+        Stitch* s = Stitch::fromId(id);
+        if(s && s->name() == stitch)
+            cells.append(mCellIndex.stitchCells(id));
+    }
+    return cells;
+}
+
+QList<Cell*> Scene::cellsWithColor(const QColor& color, bool foreground, bool background)
+{
+    QList<int> entries = mPalette.indexesOf(color.rgba());
+
+    QSet<Cell*> cells;
+    foreach(int index, entries) {
+        if(foreground)
+            cells.unite(mCellIndex.colorCells(index).toSet());
+        if(background)
+            cells.unite(mCellIndex.bgColorCells(index).toSet());
+    }
+
+    //cells without a color of their own are drawn in black.
+    if(foreground && color.rgba() == QColor(Qt::black).rgba())
+        cells.unite(mCellIndex.colorCells(-1).toSet());
+
+    return cells.toList();
+}
+
+void Scene::selectCells(const QList<Cell*>& cells)
+{
+    clearSelection();
+    foreach(Cell* c, cells) {
+        //cells in groups are selected with their group.
+        QGraphicsItem* item = c->topLevelItem();
+        if(item->isVisible() && (item->flags() & QGraphicsItem::ItemIsSelectable))
+            item->setSelected(true);
+    }
+}
+
+void Scene::selectCellsWithStitch(const QString& stitch)
+{
+    selectCells(cellsWithStitch(stitch));
+}
+
+void Scene::selectCellsWithColor(const QColor& color)
+{
+    selectCells(cellsWithColor(color, true, false));
+}
+
+ColorPalette* Scene::colorPalette(QGraphicsScene* scene)
+{
+    Scene* s = qobject_cast<Scene*>(scene);
+    if(!s)
+        return ColorPalette::loose();
+    return &s->mPalette;
+}
+
+void Scene::setPaletteColor(int index, QColor color)
+{
+    setPaletteColor(mPalette.colorwayId(mPalette.currentColorway()), index, color);
+}
+
+void Scene::setPaletteColor(int colorwayId, int index, QColor color)
+{
+    int colorway = mPalette.findColorway(colorwayId);
+    if(colorway == -1) {
+        WARN("No colorway with id " + QString::number(colorwayId));
+        return;
+    }
+
+    QHash<int, QRgb> oldColors;
+    oldColors.insert(index, mPalette.color(index));
+
+    //only an edit of the current colorway shows on the chart.
+    mPalette.setColorwayColor(colorway, index, color.rgba());
+    paletteChanged(oldColors);
+}
+
+void Scene::paletteChanged(const QHash<int, QRgb>& oldColors)
+{
+    QHash<int, QRgb> changed;
+    QHash<int, QRgb>::const_iterator i;
+    for(i = oldColors.constBegin(); i != oldColors.constEnd(); ++i) {
+        if(mPalette.color(i.key()) != i.value())
+            changed.insert(i.key(), i.value());
+    }
+
+    if(changed.isEmpty())
+        return;
+
+    //only the cells using the changed entries have to be drawn again.
+    QHash<int, int> uses;
+    foreach(int index, changed.keys()) {
+        QList<Cell*> fgCells = mCellIndex.colorCells(index);
+        QList<Cell*> bgCells = mCellIndex.bgColorCells(index);
+        if(fgCells.count() + bgCells.count() > 0)
+            uses.insert(index, fgCells.count() + bgCells.count());
+
+        foreach(Cell* c, fgCells + bgCells) {
+            trackPaintChange(c);
+            c->update();
+        }
+    }
+
+    if(uses.isEmpty())
+        return;
+
+    QHash<int, int>::const_iterator u;
+    for(u = uses.constBegin(); u != uses.constEnd(); ++u) {
+        mColorChanges[QColor::fromRgba(changed.value(u.key())).name()] -= u.value();
+        mColorChanges[QColor::fromRgba(mPalette.color(u.key())).name()] += u.value();
+    }
+    queueCellChanges();
+}
+
+static QHash<int, QRgb> paletteColors(const ColorPalette& palette)
+{
+    QHash<int, QRgb> colors;
+    for(int i = 0; i < palette.count(); ++i)
+        colors.insert(i, palette.color(i));
+    return colors;
+}
+
+void Scene::setCurrentColorway(int colorway)
+{
+    if(colorway == mPalette.currentColorway())
+        return;
+
+    QHash<int, QRgb> oldColors = paletteColors(mPalette);
+    mPalette.setCurrentColorway(colorway);
+    paletteChanged(oldColors);
+}
+
+int Scene::addColorway(const QString& name)
+{
+    return mPalette.addColorway(name);
+}
+
+void Scene::removeColorway(int colorway)
+{
+    QHash<int, QRgb> oldColors = paletteColors(mPalette);
+    mPalette.removeColorway(colorway);
+    paletteChanged(oldColors);
+}
+
+void Scene::insertColorway(int colorway, int id, const QString& name, const QVector<QRgb>& colors)
+{
+    //the current colorway stays the same so none of the cells change.
+    mPalette.insertColorway(colorway, id, name, colors);
+}
+
+void Scene::addColorwayUndoable(const QString& name)
+{
+    mUndoStack.push(new AddColorway(this, name));
+}
+
+void Scene::removeColorwayUndoable(int colorway)
+{
+    if(mPalette.colorwayCount() <= 1 || mPalette.colorwayId(colorway) == -1)
+        return;
+    mUndoStack.push(new RemoveColorway(this, colorway));
+}
+
+void Scene::setColorwayNameUndoable(int colorway, const QString& name)
+{
+    if(mPalette.colorwayId(colorway) == -1 || mPalette.colorwayName(colorway) == name)
+        return;
+    mUndoStack.push(new SetColorwayName(this, colorway, name));
+}
+
+//drop the entries that cancelled each other out.
+static QMap<QString, int> takeChanges(QMap<QString, int>& changes)
+{
+    QMap<QString, int> result;
+    QMap<QString, int>::const_iterator i;
+    for(i = changes.constBegin(); i != changes.constEnd(); ++i) {
+        if(i.value() != 0)
+            result.insert(i.key(), i.value());
+    }
+    changes.clear();
+    return result;
+}
+
+void Scene::sendCellChanges()
+{
+    mCellChangesPending = false;
+
+    QMap<QString, int> stitches = takeChanges(mStitchChanges);
+    QMap<QString, int> colors = takeChanges(mColorChanges);
+
+    if(!stitches.isEmpty())
+        emit stitchesChanged(stitches);
+    if(!colors.isEmpty())
+        emit colorsChanged(colors);
+}
+
+/**
+ * Where the layer cache view draws an item: the items below the cells before the
+ * cache, the cells of the other layers from the cache and the rest on top of it.
+ */
+enum LayerCacheBand {
+    BelowCells,
+    CellBand,
+    AboveCells
+};
+
+static LayerCacheBand layerCacheBand(QGraphicsItem* item)
+{
+    //a group stacks everything in it at its own z value.
+    if(item->topLevelItem()->zValue() < 0)
+        return BelowCells;
+    if(item->type() == Indicator::Type || item->type() == ChartImage::Type)
+        return AboveCells;
+    return CellBand;
+}
+
+bool Scene::isDrawnFromLayerCache(QGraphicsItem* item, unsigned int layer, const QWidget* widget)
+{
+    Scene* s = qobject_cast<Scene*>(item->scene());
+    if(!s || !widget || !s->mLayerCacheView || widget != s->mLayerCacheView->viewport())
+        return false;
+
+    switch(layerCacheBand(item)) {
+        case BelowCells:
+            return s->mBelowCells.contains(item->topLevelItem());
+        case CellBand:
+            return s->isLayerCached(layer);
+        default:
+            return false;
+    }
+}
+
+bool Scene::isLayerCached(int layer) const
+{
+    if(!mLayerCacheView || !mSelectedLayer || layer == SpatialIndex::NoLayer)
+        return false;
+    return (unsigned int)layer != mSelectedLayer->uid();
+}
+
+void Scene::setLayerCacheView(QGraphicsView* view)
+{
+    if(mLayerCacheView == view)
+        return;
+
+    mLayerCacheView = view;
+    ++mLayerCacheVersion;
+    update();
+}
+
+quint64 Scene::layerCacheVersion()
+{
+    updateSpatialIndex();
+    return mLayerCacheVersion;
+}
+
+//paint the item and its children the way the scene would.
+static void drawItemTree(QPainter* painter, QGraphicsItem* item, QStyleOptionGraphicsItem* option,
+                         bool showSelection = false, bool cellBandOnly = false)
+{
+    if(!item->isVisible())
+        return;
+
+    if(!(item->flags() & QGraphicsItem::ItemHasNoContents) &&
+            (!cellBandOnly || layerCacheBand(item) == CellBand)) {
+        painter->save();
+        painter->setTransform(item->sceneTransform(), true);
+        painter->setOpacity(item->effectiveOpacity());
+
+        option->state = (showSelection && item->isSelected()) ? QStyle::State_Selected : QStyle::State_None;
+        option->exposedRect = item->boundingRect();
+        option->rect = option->exposedRect.toAlignedRect();
+
+        item->paint(painter, option, 0);
+        painter->restore();
+    }
+
+    foreach(QGraphicsItem* child, item->childItems())
+        drawItemTree(painter, child, option, showSelection, cellBandOnly);
+}
+
+static bool zValueLessThan(QGraphicsItem* a, QGraphicsItem* b)
+{
+    return a->zValue() < b->zValue();
+}
+
+int Scene::drawInactiveLayers(QPainter* painter, const QRectF& rect)
+{
+    QList<QGraphicsItem*> list = spatialIndex().items(rect);
+    QStyleOptionGraphicsItem option;
+    int drawn = 0;
+
+    //the index returns the topmost items first.
+    for(int i = list.count() - 1; i >= 0; --i) {
+        QGraphicsItem* item = list.at(i);
+        if(!isLayerCached(mIndex.layer(item)) || !item->isVisible() || layerCacheBand(item) != CellBand)
+            continue;
+        drawItemTree(painter, item, &option, false, true);
+        ++drawn;
+    }
+
+    return drawn;
+}
+
+int Scene::drawBelowLayerCache(QPainter* painter, const QRectF& rect)
+{
+    updateSpatialIndex();
+
+    QList<QGraphicsItem*> list;
+    foreach(QGraphicsItem* item, mBelowCells) {
+        if(item->isVisible() && item->sceneBoundingRect().intersects(rect))
+            list.append(item);
+    }
+    qStableSort(list.begin(), list.end(), zValueLessThan);
+
+    //these include items of the current layer, draw them as they'd be drawn live.
+    QStyleOptionGraphicsItem option;
+    foreach(QGraphicsItem* item, list)
+        drawItemTree(painter, item, &option, true);
+
+    return list.count();
+}
+
+//the item and everything grouped in it.
+static int itemTreeCount(QGraphicsItem* item)
+{
+    int count = 1;
+    foreach(QGraphicsItem* child, item->childItems())
+        count += itemTreeCount(child);
+    return count;
+}
+
+bool Scene::needsDragProxy(const QList<QGraphicsItem*>& items) const
+{
+    int count = 0;
+    foreach(QGraphicsItem* item, items) {
+        count += itemTreeCount(item);
+        if(count >= DRAG_PROXY_MIN_ITEMS)
+            return true;
+    }
+    return false;
+}
+
+void Scene::beginDragProxy(const QList<QGraphicsItem*>& items)
+{
+    if(mDragProxy || items.isEmpty())
+        return;
+
+    QRectF rect;
+    foreach(QGraphicsItem* item, items)
+        rect |= item->sceneBoundingRect() | item->mapRectToScene(item->childrenBoundingRect());
+    //leave room for pens drawn on the edge of the items.
+    rect.adjust(-2, -2, 2, 2);
+
+    QPicture picture;
+    QPainter painter(&picture);
+    QStyleOptionGraphicsItem option;
+
+    //draw the items in stacking order, the index returns the topmost items first.
+    QSet<QGraphicsItem*> remaining = items.toSet();
+    QList<QGraphicsItem*> list = spatialIndex().items(rect);
+    for(int i = list.count() - 1; i >= 0; --i) {
+        if(remaining.remove(list.at(i)))
+            drawItemTree(&painter, list.at(i), &option, true);
+    }
+    foreach(QGraphicsItem* item, remaining)
+        drawItemTree(&painter, item, &option, true);
+    painter.end();
+
+    //hiding the items would drop them from the selection, make them transparent instead.
+    foreach(QGraphicsItem* item, items) {
+        mDragProxyItems.insert(item, item->opacity());
+        item->setOpacity(0.0);
+        trackPaintChange(item);
+    }
+
+    ChartDragProxy* proxy = new ChartDragProxy(picture, rect);
+
+    //cache the picture at the zoom it's seen at so it stays sharp and is only drawn once.
+    qreal zoom = views().isEmpty() ? 1.0 : qAbs(views().first()->transform().m11());
+    QSizeF cacheSize = rect.size() * zoom;
+    if(cacheSize.width() > DRAG_PROXY_MAX_CACHE || cacheSize.height() > DRAG_PROXY_MAX_CACHE)
+        cacheSize.scale(DRAG_PROXY_MAX_CACHE, DRAG_PROXY_MAX_CACHE, Qt::KeepAspectRatio);
+    proxy->setCacheMode(QGraphicsItem::ItemCoordinateCache, cacheSize.toSize().expandedTo(QSize(1, 1)));
+
+    //the proxy isn't a chart item, it skips the bookkeeping of Scene::addItem().
+    QGraphicsScene::addItem(proxy);
+    mDragProxy = proxy;
+}
+
+void Scene::endDragProxy()
+{
+    if(!mDragProxy)
+        return;
+
+    QGraphicsScene::removeItem(mDragProxy);
+    delete mDragProxy;
+    mDragProxy = 0;
+
+    QHash<QGraphicsItem*, qreal>::const_iterator i;
+    for(i = mDragProxyItems.constBegin(); i != mDragProxyItems.constEnd(); ++i) {
+        i.key()->setOpacity(i.value());
+        trackPaintChange(i.key());
+    }
+    mDragProxyItems.clear();
+}
+
+void Scene::updateSpatialIndex()
+{
+    //applying the layer state below can mark items again.
+    QSet<QGraphicsItem*> dirty = mIndexDirty;
+    mIndexDirty.clear();
+
+    foreach(QGraphicsItem* item, dirty) {
+        //only top level items are indexed, grouped items are found through their group.
+        if(item->scene() != this || item->parentItem()) {
+            if(mIndex.contains(item) && isLayerCached(mIndex.layer(item)))
+                ++mLayerCacheVersion;
+            mIndex.remove(item);
+            mBelowCells.remove(item);
+            continue;
+        }
+
+        int layer = itemLayer(item);
+        bool indexed = mIndex.contains(item);
+        bool joined = !indexed || mIndex.layer(item) != layer;
+
+        if(isLayerCached(layer) || (indexed && isLayerCached(mIndex.layer(item))))
+            ++mLayerCacheVersion;
+
+        mIndex.insert(item, item->sceneBoundingRect(), layer);
+        if(item->zValue() < 0)
+            mBelowCells.insert(item);
+        else
+            mBelowCells.remove(item);
+
+        //items coming into a layer take on its visibility and selectability.
+        if(joined && layer != SpatialIndex::NoLayer) {
+            ChartLayer* l = mLayers.value(layer);
+            if(l)
+                applyLayerState(item, l);
+        }
+    }
+}
+
+void Scene::applyLayerState(QGraphicsItem* item, ChartLayer* layer)
+{
+    item->setVisible(layer->visible());
+
+    //until a layer is selected the items keep the selectability they were created with.
+    if(mSelectedLayer)
+        item->setFlag(QGraphicsItem::ItemIsSelectable, layer->visible()
+            && item->parentItem() == NULL && layer == mSelectedLayer);
+}
+
+QList<QGraphicsItem*> Scene::layerItems(unsigned int uid)
+{
+    updateSpatialIndex();
+    return mIndex.layerItems(uid);
+}
+
+const SpatialIndex& Scene::spatialIndex()
+{
+    updateSpatialIndex();
+    return mIndex;
+}
+
+void Scene::setSelected(const QList<QGraphicsItem*>& items, bool selected)
+{
+    bool wasBlocked = blockSignals(true);
+    bool changed = false;
+
+    foreach(QGraphicsItem* item, items) {
+        if(item->isSelected() == selected)
+            continue;
+        item->setSelected(selected);
+        changed = true;
+    }
+
+    blockSignals(wasBlocked);
+
+    if(changed && !wasBlocked)
+        emit selectionChanged();
+}
+
 QStringList Scene::modes()
 {
     QStringList modes;
@@ -216,12 +934,9 @@ QList<ChartLayer*> Scene::layers()
 
 QGraphicsItem* Scene::selectableItemAt(const QPointF& pos)
 {
-	foreach (QGraphicsItem* item, items()) {
-		if (item->sceneBoundingRect().contains(pos) &&
-				(item->flags() & QGraphicsItem::ItemIsSelectable) == QGraphicsItem::ItemIsSelectable)
-			return item;
-	}
-	return NULL;
+	//only the items on the current layer can be selected.
+	int layer = mSelectedLayer ? (int)mSelectedLayer->uid() : (int)SpatialIndex::AllLayers;
+	return spatialIndex().itemAt(pos, layer, true);
 }
 
 int Scene::maxColumnCount()
@@ -243,9 +958,6 @@ void Scene::addItem(QGraphicsItem* item)
     switch(item->type()) {
         case Cell::Type: {
             QGraphicsScene::addItem(item);
-            Cell* c = qgraphicsitem_cast<Cell*>(item);
-            connect(c, SIGNAL(stitchChanged(QString,QString)), SIGNAL(stitchChanged(QString,QString)));
-            connect(c, SIGNAL(colorChanged(QString,QString)), SIGNAL(colorChanged(QString,QString)));
             break;
         }
         case Indicator::Type: {
@@ -269,7 +981,6 @@ void Scene::addItem(QGraphicsItem* item)
             WARN("Unknown type: " + QString::number(item->type()));
             //fall through
 		case ChartImage::Type:
-        case Guideline::Type:
         case QGraphicsEllipseItem::Type:
         case QGraphicsLineItem::Type: {
             QGraphicsScene::addItem(item);
@@ -307,7 +1018,6 @@ void Scene::removeItem(QGraphicsItem* item)
         default:
             WARN("Unknown type: " + QString::number(item->type()));
 		case ChartImage::Type:
-        case Guideline::Type:
         case QGraphicsEllipseItem::Type:
         case QGraphicsLineItem::Type: {
             QGraphicsScene::removeItem(item);
@@ -317,6 +1027,131 @@ void Scene::removeItem(QGraphicsItem* item)
 
 }
 
+void Scene::removeItems(const QList<QGraphicsItem*>& items, QVector<QPoint>* positions, QList<int>* emptiedRows)
+{
+    QSet<QGraphicsItem*> removing;
+    removing.reserve(items.count());
+    foreach(QGraphicsItem* item, items)
+        removing.insert(item);
+
+    //take the cells out of the grid in one sweep.
+    QHash<Cell*, QPoint> gridPositions;
+    QList< QList<Cell*> > rows;
+    for(int y = 0; y < grid.count(); ++y) {
+        const QList<Cell*>& row = grid.at(y);
+
+        QList<Cell*> kept;
+        for(int x = 0; x < row.count(); ++x) {
+            Cell* c = row.at(x);
+            if(removing.contains(c)) {
+                gridPositions.insert(c, QPoint(x, y));
+                c->setZValue(10);
+            } else {
+                kept.append(c);
+            }
+        }
+
+        if(kept.count() == row.count()) {
+            rows.append(row);
+        } else if(kept.isEmpty()) {
+            if(emptiedRows)
+                emptiedRows->append(y);
+        } else {
+            rows.append(kept);
+        }
+    }
+    grid = rows;
+
+    bool indicators = false;
+    bool groups = false;
+    foreach(QGraphicsItem* item, items) {
+        switch(item->type()) {
+            case Indicator::Type:
+                indicators = true;
+                break;
+            case ItemGroup::Type:
+                groups = true;
+                break;
+            case Cell::Type:
+            case ChartImage::Type:
+            case QGraphicsEllipseItem::Type:
+            case QGraphicsLineItem::Type:
+                break;
+            default:
+                WARN("Unknown type: " + QString::number(item->type()));
+                break;
+        }
+
+        QGraphicsScene::removeItem(item);
+
+        if(positions) {
+            Cell* c = (item->type() == Cell::Type) ? static_cast<Cell*>(item) : 0;
+            positions->append(gridPositions.value(c, QPoint(-1, -1)));
+        }
+    }
+
+    if(indicators) {
+        QList<Indicator*> kept;
+        foreach(Indicator* i, mIndicators) {
+            if(!removing.contains(i))
+                kept.append(i);
+        }
+        mIndicators = kept;
+    }
+
+    if(groups) {
+        QList<ItemGroup*> kept;
+        foreach(ItemGroup* g, mGroups) {
+            if(!removing.contains(g))
+                kept.append(g);
+        }
+        mGroups = kept;
+    }
+}
+
+void Scene::restoreItems(const QList<QGraphicsItem*>& items, const QVector<QPoint>& positions, const QList<int>& emptiedRows)
+{
+    foreach(int y, emptiedRows)
+        grid.insert(qMin(y, grid.count()), QList<Cell*>());
+
+    //the cells of each row sorted by the column they were in.
+    QMap<int, QMap<int, Cell*> > rows;
+    for(int i = 0; i < items.count() && i < positions.count(); ++i) {
+        const QPoint& pos = positions.at(i);
+        if(pos.y() < 0 || items.at(i)->type() != Cell::Type)
+            continue;
+        rows[pos.y()].insert(pos.x(), static_cast<Cell*>(items.at(i)));
+    }
+
+    QMapIterator<int, QMap<int, Cell*> > r(rows);
+    while(r.hasNext()) {
+        r.next();
+        if(r.key() >= grid.count()) {
+            qWarning() << "restoreItems: missing row" << r.key();
+            continue;
+        }
+
+        //going through the columns in order puts each cell back at its old index.
+        const QList<Cell*>& old = grid.at(r.key());
+        QList<Cell*> merged;
+        int next = 0;
+        QMapIterator<int, Cell*> c(r.value());
+        while(c.hasNext()) {
+            c.next();
+            while(merged.count() < c.key() && next < old.count())
+                merged.append(old.at(next++));
+            merged.append(c.value());
+        }
+        while(next < old.count())
+            merged.append(old.at(next++));
+
+        grid[r.key()] = merged;
+    }
+
+    foreach(QGraphicsItem* item, items)
+        addItem(item);
+}
+
 void Scene::removeFromRows(Cell* c)
 {
     for(int y = 0; y < grid.count(); ++y) {
@@ -392,7 +1227,7 @@ void Scene::keyPressEvent(QKeyEvent* keyEvent)
     if(keyEvent->isAccepted())
         return;
 
-    if(selectedItems().count() <= 0)
+    if(selectionCount() <= 0)
         return;
     
     switch(mMode) {
@@ -434,13 +1269,13 @@ void Scene::stitchModeKeyRelease(QKeyEvent* keyEvent)
     if(!keyEvent->isAccepted())
         return;
     
-    undoStack()->beginMacro(tr("adjust item positions"));
-    foreach(QGraphicsItem *i, selectedItems()) {
-        QPointF oldPos = i->pos();
-        i->setPos(i->pos().x() + deltaX, i->pos().y() + deltaY);
-        undoStack()->push(new SetItemCoordinates(i, oldPos));
-    }
-    undoStack()->endMacro();
+    //one command for the whole selection so repeated nudges merge into one undo step.
+    QList<QGraphicsItem*> items = selection().toList();
+    QVector<QPointF> positions;
+    positions.reserve(items.count());
+    foreach(QGraphicsItem *i, items)
+        positions.append(i->pos() + QPointF(deltaX, deltaY));
+    undoStack()->push(new SetItemsCoordinates(items, positions));
     
 }
 
@@ -460,19 +1295,20 @@ void Scene::angleModeKeyRelease(QKeyEvent* keyEvent)
     if(!keyEvent->isAccepted())
         return;
 
-    undoStack()->beginMacro(tr("adjust item rotation"));
-    foreach(QGraphicsItem *i, selectedItems()) {
+    QList<QGraphicsItem*> cells;
+    QVector<qreal> newAngles;
+    foreach(QGraphicsItem *i, selection()) {
         if(i->type() != Cell::Type)
             continue;
-        Cell* c = qgraphicsitem_cast<Cell*>(i);
-        
-        qreal oldAngle = ChartItemTools::getRotation(c);
-		QPointF pvtPt = QPointF(c->boundingRect().width()/2, c->boundingRect().bottom());
-        ChartItemTools::setRotationPivot(c, pvtPt);
-        ChartItemTools::addRotation(c, delta);
-		undoStack()->push(new SetItemRotation(c, oldAngle, pvtPt));
+
+		QPointF pvtPt = QPointF(i->boundingRect().width()/2, i->boundingRect().bottom());
+        ChartItemTools::setRotationPivot(i, pvtPt);
+        cells.append(i);
+        newAngles.append(ChartItemTools::getRotation(i) + delta);
     }
-    undoStack()->endMacro();
+
+    if(!cells.isEmpty())
+        undoStack()->push(new SetItemsRotation(cells, newAngles));
 
 }
 
@@ -509,32 +1345,30 @@ void Scene::scaleModeKeyRelease(QKeyEvent* keyEvent)
             delta.rx() = delta.y();
     }
     
-    undoStack()->beginMacro(tr("adjust item scale"));
-    foreach(QGraphicsItem *i, selectedItems()) {
+    QList<QGraphicsItem*> cells;
+    QVector<QPointF> newScales;
+    foreach(QGraphicsItem *i, selection()) {
         if(i->type() != Cell::Type)
             continue;
-        Cell* c = qgraphicsitem_cast<Cell*>(i);
-
-        QPointF oldScale = ChartItemTools::getScale(c);
-        QPointF newScale = oldScale + delta;
-        ChartItemTools::setScaleX(c, newScale.x());
-        ChartItemTools::setScaleY(c, newScale.y());
-        undoStack()->push(new SetItemScale(c, oldScale, ChartItemTools::getScalePivot(i)));
+        cells.append(i);
+        newScales.append(ChartItemTools::getScale(i) + delta);
     }
-    undoStack()->endMacro();
+
+    if(!cells.isEmpty())
+        undoStack()->push(new SetItemsScale(cells, newScales));
     
 }
 
 void Scene::mousePressEvent(QGraphicsSceneMouseEvent *e)
 {
 
-    if(selectedItems().count() > 0)
+    if(selectionCount() > 0)
         mHasSelection = true;
 
     if(mHasSelection && e->modifiers() == Qt::ControlModifier)
         mSelectionPath = selectionArea();
 	//
-    if(e->buttons() & Qt::LeftButton &&(e->modifiers() != Qt::ShiftModifier || selectedItems().count() >= 1))
+    if(e->buttons() & Qt::LeftButton &&(e->modifiers() != Qt::ShiftModifier || selectionCount() >= 1))
         QGraphicsScene::mousePressEvent(e);
 
 	//FIXME: there has to be a better way to keep the current selection.
@@ -588,12 +1422,6 @@ void Scene::mousePressEvent(QGraphicsSceneMouseEvent *e)
                 //If we've selected the background text pretend we didn't select it.
                 mCurItem = 0;
                 break;
-            }
-            case Guideline::Type: {
-                //We don't want to select the guidelines when we're manipulating the chart or stitches.
-                clearSelection();
-                mCurItem = 0;
-                break;
             }
 			case ChartImage::Type: {
 				//mMoving = true;
@@ -631,7 +1459,7 @@ void Scene::mousePressEvent(QGraphicsSceneMouseEvent *e)
     if(e->buttons() != Qt::LeftButton)
         return;
 
-    if(selectedItems().count() <= 0 || e->modifiers() == Qt::ControlModifier) {
+    if(selectionCount() <= 0 || e->modifiers() == Qt::ControlModifier) {
         ChartView* view = qobject_cast<ChartView*>(parent());
 
         //if(!mRubberBand)
@@ -658,7 +1486,7 @@ void Scene::mousePressEvent(QGraphicsSceneMouseEvent *e)
     } else {
         
     //Track object movement on scene.
-        foreach(QGraphicsItem* item, selectedItems()) {
+        foreach(QGraphicsItem* item, selection()) {
             mOldPositions.insert(item, item->pos());
         }
     }
@@ -705,9 +1533,24 @@ void Scene::mouseMoveEvent(QGraphicsSceneMouseEvent *e)
 				mIsRubberband = true;
             }
         } else if (mMoving) {
-            QGraphicsScene::mouseMoveEvent(e);
-            if(selectedItems().contains(mCenterSymbol)) {
-                updateGuidelines();
+            //large selections drag a picture of themselves and are moved when they're dropped.
+            if(!mDragProxy && !isInSelection(mCenterSymbol)) {
+                QList<QGraphicsItem*> movable;
+                foreach(QGraphicsItem* item, mOldPositions.keys()) {
+                    if(item->flags() & QGraphicsItem::ItemIsMovable)
+                        movable.append(item);
+                }
+                if(needsDragProxy(movable))
+                    beginDragProxy(movable);
+            }
+
+            if(mDragProxy) {
+                mDragProxy->setPos(e->scenePos() - e->buttonDownScenePos(Qt::LeftButton));
+            } else {
+                QGraphicsScene::mouseMoveEvent(e);
+                if(isInSelection(mCenterSymbol)) {
+                    updateGuidelines();
+                }
             }
         }
     }
@@ -750,27 +1593,44 @@ void Scene::mouseReleaseEvent(QGraphicsSceneMouseEvent *e)
         if(mHasSelection && e->modifiers() == Qt::ControlModifier) {
             path.addPath(mSelectionPath);
         }
+		int layer = mSelectedLayer ? (int)mSelectedLayer->uid() : (int)SpatialIndex::AllLayers;
 		blockSignals(true);
-        setSelectionArea(path);
+        clearSelection();
+        setSelected(spatialIndex().items(path, Qt::IntersectsItemShape, layer, true), true);
 		blockSignals(false);
 		emit selectionChanged();
 		mSelectionBand->hide();
     }
 
-    if((selectedItems().count() > 0 && mOldPositions.count() > 0) && mMoving) {
-        undoStack()->beginMacro("move items");
+    if(mDragProxy && mMoving) {
+        QPointF offset = mDragProxy->pos();
+        foreach(QGraphicsItem* item, mOldPositions.keys()) {
+            if(item->flags() & QGraphicsItem::ItemIsMovable)
+                item->setPos(mOldPositions.value(item) + offset);
+        }
+        endDragProxy();
+    }
+
+    if((selectionCount() > 0 && mOldPositions.count() > 0) && mMoving) {
 		//first, snap the items to the grid if we need to
-		foreach(QGraphicsItem* item, selectedItems()) {
-			snapGraphicsItemToGrid(*item);
-		}
+		snapItemsToGrid(selection().toList());
 		
-        foreach(QGraphicsItem* item, selectedItems()) {
-            if(mOldPositions.contains(item)) {
-                QPointF oldPos = mOldPositions.value(item);
-                undoStack()->push(new SetItemCoordinates(item, oldPos));
+        //one command for the whole move, the items are already in place.
+        QList<QGraphicsItem*> items;
+        QVector<QPointF> oldPositions, newPositions;
+        foreach(QGraphicsItem* item, selection()) {
+            if(mOldPositions.contains(item) && mOldPositions.value(item) != item->pos()) {
+                items.append(item);
+                oldPositions.append(mOldPositions.value(item));
+                newPositions.append(item->pos());
             }
         }
-        undoStack()->endMacro();
+
+        if(!items.isEmpty()) {
+            SetItemsCoordinates* move = new SetItemsCoordinates(items, oldPositions, newPositions);
+            move->setText(tr("move items"));
+            undoStack()->push(move);
+        }
         mOldPositions.clear();
     }
 
@@ -795,159 +1655,72 @@ void Scene::mouseReleaseEvent(QGraphicsSceneMouseEvent *e)
         mMoving = false;
     }
 
+    endDragProxy();
+
     mCurItem = 0;
     mHasSelection = false;
 }
 
-void Scene::snapGraphicsItemToGrid(QGraphicsItem& item)
+QPointF Scene::centerPos() const
 {
-	QPointF centerPos = item.sceneBoundingRect().center();
-	item.setPos(snapPositionToGrid(centerPos) - centerPos + item.pos());
-	
-	//if we need to snap the angle and we are in rounds mode
-	if (mSnapAngle && mGuidelines.type() == "Rounds") {
-		//get the angle between the item and the center
-		QPointF center(0, 0);
-		if (mCenterSymbol)
-			center = mCenterSymbol->pos();
-			
-		QPointF newCenterPos = item.sceneBoundingRect().center();
-		qreal angle = std::atan2(newCenterPos.y() - center.y(), newCenterPos.x() - center.x());
-
-		//rotate the object so it looks at the center
-		ChartItemTools::setRotationPivot(&item, item.boundingRect().center());
-		ChartItemTools::setRotation(&item, (angle * 180/M_PI) + 90);
-	}
+    if(mCenterSymbol)
+        return mCenterSymbol->pos();
+    return QPointF(0, 0);
 }
 
-QPointF Scene::snapPositionToGrid(const QPointF& pos) const
+void Scene::snapItemsToGrid(const QList<QGraphicsItem*>& items)
 {
-	if (mGuidelines.type() == "None")
-		return pos;
-	else if (mGuidelines.type() == "Rows")
-		return snapPositionToRows(pos);
-	else if (mGuidelines.type() == "Rounds")
-		return snapPositionToRounds(pos);
-	else if (mGuidelines.type() == "Triangles")
-		return snapPositionToTriangles(pos);
-	else {
-		return pos;
-		WARN("Unknown guideline type.");
-		WARN(mGuidelines.type());
-	}
+    if(items.isEmpty())
+        return;
+
+    if(mSnapEngine.mode() == SnapEngine::None) {
+        if(!Settings::inst()->value("snapToStitches").toBool())
+            return;
+
+        QPointF offset = mSnapEngine.stitchOffset(items, spatialIndex());
+        if(offset.isNull())
+            return;
+        foreach(QGraphicsItem* item, items)
+            item->moveBy(offset.x(), offset.y());
+        return;
+    }
+
+    QVector<QPointF> centers;
+    centers.reserve(items.count());
+    foreach(QGraphicsItem* item, items)
+        centers.append(item->sceneBoundingRect().center());
+
+    QPointF center = centerPos();
+    QVector<QPointF> snapped = centers;
+    mSnapEngine.snap(snapped, center);
+
+    for(int i = 0; i < items.count(); ++i)
+        items.at(i)->setPos(snapped.at(i) - centers.at(i) + items.at(i)->pos());
+
+    //turn the items to face the center of the rounds.
+    if(mSnapAngle && mSnapEngine.mode() == SnapEngine::Rounds) {
+        for(int i = 0; i < items.count(); ++i) {
+            QGraphicsItem* item = items.at(i);
+            qreal angle = std::atan2(snapped.at(i).y() - center.y(), snapped.at(i).x() - center.x());
+            ChartItemTools::setRotationPivot(item, item->boundingRect().center());
+            ChartItemTools::setRotation(item, (angle * 180/M_PI) + 90);
+        }
+    }
 }
 
-QPointF Scene::snapPositionToTriangles(const QPointF& pos) const
+void Scene::snapPositionsToGrid(QVector<QPointF>& positions) const
 {
-	//get the needed variables
-	QPointF center(0, 0);
-	if (mCenterSymbol)
-		center = mCenterSymbol->pos();
-		
-    int triangles = mGuidelines.rows();
-    
-    int spacingW = mGuidelines.cellWidth();
-    int spacingH = mGuidelines.cellHeight();
-	
-	//get the relative position to the triangles
-	QPointF relPos = pos - center;
-	
-	//get the row of the current position
-	int relRow = relPos.y() / spacingH + 0.5;
-	
-	//clamp the row
-	relRow = std::max(0, std::min(triangles, relRow));
-	
-	//get the max offsetX of that row
-	qreal offsetX = (relRow) * spacingW/2;
-	
-	//get the distance from that offset
-	qreal offsetDist = relPos.x() - offsetX;
-	
-	//snap that distance to the grid
-	int relDistColumn = offsetDist / spacingW - 0.5;
-	
-	//clamp the column
-	relDistColumn = std::max(-relRow, std::min(0, relDistColumn));
-	
-	//get the new relative pos
-	QPointF newPos(relDistColumn * spacingW + offsetX, relRow * spacingH);
-	
-	return newPos + center;
+    mSnapEngine.snap(positions, centerPos());
 }
 
-QPointF Scene::snapPositionToRows(const QPointF& pos) const
+void Scene::snapGraphicsItemToGrid(QGraphicsItem& item)
 {
-	//get the needed variables
-	QPointF center(0, 0);
-	if (mCenterSymbol)
-		center = mCenterSymbol->pos();
-		
-    int columns = mGuidelines.columns();
-    int rows = mGuidelines.rows();
-
-    int spacingW = mGuidelines.cellWidth();
-    int spacingH = mGuidelines.cellHeight();
-
-	//get the relative position to the grid
-	QPointF relPos = pos - center;
-	
-	//get the grid pos of the point
-	int relPosGridX = (relPos.x() + spacingW/2) / spacingW;
-	int relPosGridY = (relPos.y() + spacingH/2) / spacingH;
-	
-	//clamp these the the grid size
-	relPosGridX = std::max(0, std::min(columns, relPosGridX));
-	relPosGridY = std::max(0, std::min(rows, relPosGridY));
-	
-	//get the new relative position
-	QPointF snappedRelPos(relPosGridX * spacingW, relPosGridY * spacingH);
-
-	//return it as scene coordinates
-	return snappedRelPos + center;
+    snapItemsToGrid(QList<QGraphicsItem*>() << &item);
 }
 
-QPointF Scene::snapPositionToRounds(const QPointF& pos) const
+QPointF Scene::snapPositionToGrid(const QPointF& pos) const
 {
-	//get the needed variables
-	QPointF center(0, 0);
-	if (mCenterSymbol)
-		center = mCenterSymbol->pos();
-		
-    int columns = mGuidelines.columns();
-    int rounds = mGuidelines.rows();
-	
-    int spacingH = mGuidelines.cellHeight();
-	
-	//get the relative position to the circle
-	QPointF relPos = pos - center;
-	
-	//get the ring of the position
-	qreal distanceToCenter = sqrt(relPos.x()*relPos.x() + relPos.y()*relPos.y()) + spacingH/2;
-	int relPosRing = distanceToCenter / spacingH;
-	relPosRing = std::max(0, std::min(rounds + 1, relPosRing));
-	qreal relPosSnappedDistance = relPosRing*spacingH;
-	
-	//get the quadrant of the position
-	qreal PIPI = M_PI * 2;
-	qreal quadrantAngleSize = PIPI/columns;
-	qreal relPosAngle = atan2(relPos.y(), relPos.x());
-	
-	relPosAngle -= M_PI_2;
-	
-	//we normalize the angle
-	relPosAngle = fmod(relPosAngle,PIPI);
-    if (relPosAngle < 0)
-        relPosAngle += PIPI;
-    
-	int relPosQuadrant = (relPosAngle) / quadrantAngleSize + 0.5;
-	qreal relPosSnappedAngle = relPosQuadrant * quadrantAngleSize + M_PI_2;
-	
-	//convert it to a point on the circle and as scene coordinates
-	return QPointF(
-		cos(relPosSnappedAngle) * relPosSnappedDistance,
-		sin(relPosSnappedAngle) * relPosSnappedDistance
-		) + center;
+    return mSnapEngine.snap(pos, centerPos());
 }
 
 void Scene::mouseDoubleClickEvent(QGraphicsSceneMouseEvent *e)
@@ -989,14 +1762,18 @@ void Scene::colorModeMouseRelease(QGraphicsSceneMouseEvent *e)
         return;
 
     Cell* curCell = static_cast<Cell*>(mCurItem);
-    undoStack()->beginMacro("set cell color");
-    if(curCell->color() != mEditFgColor) {
+    bool fg = curCell->color() != mEditFgColor;
+    bool bg = curCell->bgColor() != mEditBgColor;
+
+    //a single change isn't wrapped in a macro so repeated clicks can merge.
+    if(fg && bg)
+        undoStack()->beginMacro("set cell color");
+    if(fg)
         undoStack()->push(new SetCellColor(curCell, mEditFgColor));
-    }
-    if(curCell->bgColor() != mEditBgColor) {
+    if(bg)
         undoStack()->push(new SetCellBgColor(curCell, mEditBgColor));
-    }
-    undoStack()->endMacro();
+    if(fg && bg)
+        undoStack()->endMacro();
 }
 
 void Scene::indicatorModeMouseMove(QGraphicsSceneMouseEvent *e)
@@ -1065,7 +1842,7 @@ void Scene::angleModeMousePress(QGraphicsSceneMouseEvent *e)
     if (mCurItem->parentItem())
         mCurItem = mCurItem->parentItem();
 	
-	if (selectedItems().count() > 1) {
+	if (selectionCount() > 1) {
 		undoStack()->beginMacro("Rotate multiple items.");
 		GroupItems* g = new GroupItems(this, selectedItems());
 		undoStack()->push(g);
@@ -1093,7 +1870,7 @@ void Scene::angleModeMouseMove(QGraphicsSceneMouseEvent *e)
         return;
 
     //FIXME: don't 'move' stitches if multple are selected. rotate them.
-    if(selectedItems().count() > 1) {
+    if(selectionCount() > 1) {
         mMoving = true;
         return;
     }
@@ -1124,6 +1901,20 @@ void Scene::angleModeMouseMove(QGraphicsSceneMouseEvent *e)
     }
 
     qNormalizeAngle(angle);
+
+    //large groups rotate a picture of their items until the mouse is released.
+    if(!mDragProxy && needsDragProxy(QList<QGraphicsItem*>() << mCurItem))
+        beginDragProxy(QList<QGraphicsItem*>() << mCurItem);
+
+    if(mDragProxy) {
+        mDragAngle = angle;
+        QTransform rotation;
+        rotation.translate(mOrigin.x(), mOrigin.y());
+        rotation.rotate(angle - mOldAngle);
+        rotation.translate(-mOrigin.x(), -mOrigin.y());
+        mDragProxy->setTransform(rotation);
+        return;
+    }
 	
 	SetItemRotation::setRotation(mCurItem, angle, mPivotPt);
 }
@@ -1136,6 +1927,11 @@ void Scene::angleModeMouseRelease(QGraphicsSceneMouseEvent *e)
 
     if(mMoving)
         return;
+
+    if(mDragProxy) {
+        SetItemRotation::setRotation(mCurItem, mDragAngle, mPivotPt);
+        endDragProxy();
+    }
 	
     undoStack()->push(new SetItemRotation(mCurItem, mOldAngle, mPivotPt));
 		
@@ -1162,7 +1958,7 @@ void Scene::scaleModeMousePress(QGraphicsSceneMouseEvent *e)
         mCurItem = mCurItem->parentItem();
 	}
 	
-	if (selectedItems().count() > 1) {
+	if (selectionCount() > 1) {
 		undoStack()->beginMacro("Rotate multiple items.");
 		GroupItems* g = new GroupItems(this, selectedItems());
 		undoStack()->push(g);
@@ -1192,7 +1988,7 @@ void Scene::scaleModeMouseMove(QGraphicsSceneMouseEvent *e)
     if(!mCurItem)
         return;
 
-    if(selectedItems().count() > 1) {
+    if(selectionCount() > 1) {
         mMoving = true;
         return;
     }
@@ -1222,6 +2018,24 @@ void Scene::scaleModeMouseMove(QGraphicsSceneMouseEvent *e)
         else
             neededScale.rx() = neededScale.ry();
     }
+
+    //large groups scale a picture of their items until the mouse is released.
+    if(!mDragProxy && mOldScale.x() != 0 && mOldScale.y() != 0 &&
+       needsDragProxy(QList<QGraphicsItem*>() << mCurItem))
+        beginDragProxy(QList<QGraphicsItem*>() << mCurItem);
+
+    if(mDragProxy) {
+        mDragScale = neededScale;
+        //the new scale is applied in the item's coordinates, before its rotation and position.
+        QTransform scale;
+        scale.translate(mPivotPt.x(), mPivotPt.y());
+        scale.scale(neededScale.x() / mOldScale.x(), neededScale.y() / mOldScale.y());
+        scale.translate(-mPivotPt.x(), -mPivotPt.y());
+        QTransform itemTransform = mCurItem->sceneTransform();
+        mDragProxy->setTransform(itemTransform.inverted() * scale * itemTransform);
+        return;
+    }
+
 	qDebug() << "Setting scale " << neededScale.x() << " " << neededScale.y();
 	SetItemScale::setScale(mCurItem, neededScale, mPivotPt);
 }
@@ -1236,6 +2050,11 @@ void Scene::scaleModeMouseRelease(QGraphicsSceneMouseEvent *e)
     if(!mCurItem)
         return;
 
+    if(mDragProxy) {
+        SetItemScale::setScale(mCurItem, mDragScale, mPivotPt);
+        endDragProxy();
+    }
+
     undoStack()->push(new SetItemScale(mCurItem, mOldScale, mPivotPt));
 
 	if (mMultiEdit) {
@@ -1327,7 +2146,7 @@ void Scene::rowEditMouseRelease(QGraphicsSceneMouseEvent* e)
 {
     Q_UNUSED(e);
 
-    if(selectedItems().count() <= 0)
+    if(selectionCount() <= 0)
         hideRowLines();
     else {
         emit rowEdited(true);
@@ -1415,7 +2234,7 @@ void Scene::stitchModeMouseRelease(QGraphicsSceneMouseEvent* e)
 void Scene::createRow()
 {
     
-    if(selectedItems().count() <= 0)
+    if(selectionCount() <= 0)
         return;
     
     QList<Cell*> r;
@@ -1432,7 +2251,7 @@ void Scene::createRow()
 
 void Scene::updateRow(int row)
 {
-    if(selectedItems().count() <= 0)
+    if(selectionCount() <= 0)
         return;
 
     QList<Cell*> r;
@@ -1469,15 +2288,16 @@ void Scene::highlightRow(int row)
     clearSelection();
     mRowSelection.clear();
 
+    QList<QGraphicsItem*> items;
     for(int i = 0; i < grid[row].count(); ++i) {
         Cell* c = grid[row][i];
         if(c) {
-            c->setSelected(true);
+            items.append(c);
             mRowSelection.append(c);
         }
     }
 
-    emit selectionChanged();
+    setSelected(items, true);
 }
 
 void Scene::moveRowDown(int row)
@@ -1555,6 +2375,15 @@ void Scene::drawBackground(QPainter * painter, const QRectF & rect)
 		//just paint white
 		painter->fillRect(rect, QColor(255,255,255));
 	}
+
+	//the guidelines sit between the background and the chart items.
+	if (!mGuidelinesPath.isEmpty() && rect.intersects(mGuidelinesPath.controlPointRect())) {
+		painter->save();
+		painter->setPen(QPen(Qt::black, 0));
+		painter->setBrush(Qt::NoBrush);
+		painter->drawPath(mGuidelinesPath);
+		painter->restore();
+	}
 }
 
 void Scene::setBackground(bool enabled)
@@ -1607,7 +2436,7 @@ void Scene::hideRowLines()
 //FIXME: simplify the number of foreach loops?
 void Scene::alignSelection(int alignmentStyle)
 {
-    if(selectedItems().count() <= 0)
+    if(selectionCount() <= 0)
         return;
 
     QApplication::setOverrideCursor(Qt::WaitCursor);
@@ -1648,7 +2477,7 @@ void Scene::alignSelection(int alignmentStyle)
 void Scene::distributeSelection(int distributionStyle)
 {
 
-    if(selectedItems().count() <= 0)
+    if(selectionCount() <= 0)
         return;
     
     QApplication::setOverrideCursor(Qt::WaitCursor);
@@ -1696,7 +2525,7 @@ void Scene::align(int vertical, int horizontal)
     qreal top = sceneRect().bottom();
     qreal bottom = sceneRect().top();
     
-    foreach(QGraphicsItem* i, selectedItems()) {
+    foreach(QGraphicsItem* i, selection()) {
         qreal tmpLeft, tmpTop;
 
         tmpLeft = i->sceneBoundingRect().left();
@@ -1743,7 +2572,7 @@ void Scene::align(int vertical, int horizontal)
         baseY = bottom;
     
     undoStack()->beginMacro("align selection");
-    foreach(QGraphicsItem* i, selectedItems()) {
+    foreach(QGraphicsItem* i, selection()) {
         QPointF oldPos = i->pos();
         qreal newX = baseX;
         qreal newY = baseY;
@@ -1784,18 +2613,17 @@ void Scene::updateGuidelines()
     int spacingW = mGuidelines.cellWidth();
     int spacingH = mGuidelines.cellHeight();
 
-    QGraphicsItem *i = 0;
+    mSnapEngine.compile(mGuidelines);
 
-    if(mGuidelinesLines.count() > 0) {
-        foreach(QGraphicsItem *item, mGuidelinesLines) {
-            removeItem(item);
-            mGuidelinesLines.removeOne(item);
-            delete item;
-        }
-    }
+    //repaint the area the old lines covered.
+    QRectF dirty = mGuidelinesPath.controlPointRect();
+    mGuidelinesPath = QPainterPath();
 
-    if(mGuidelines.type() == "None")
+    if(mGuidelines.type() == "None") {
+        invalidate(dirty, QGraphicsScene::BackgroundLayer);
+        emit backgroundChanged(dirty);
         return;
+    }
 	
 	//get the center position, or make it 0 if centerpos does not exist yet
 	QPointF center;
@@ -1813,41 +2641,29 @@ void Scene::updateGuidelines()
 		generateGuidelinesTriangles(spacingW, spacingH, columns, rows, center);
 	}
 
+    dirty = dirty.united(mGuidelinesPath.controlPointRect());
+    invalidate(dirty, QGraphicsScene::BackgroundLayer);
+    emit backgroundChanged(dirty);
     updateSceneRect();
 }
 
 void Scene::generateGuidelinesRows(int spacingW, int spacingH, int columns, int rows, QPointF center)
 {
-    QGraphicsItem *i = 0;
-
 	//generate columns
 	for(int c = 0; c <= columns; c++) {
-		i = addLine(
-			c*spacingW + center.x(),
-			center.y(),
-			c*spacingW + center.x(),
-			spacingH*rows + center.y()
-		);
-		i->setZValue(-1);
-		mGuidelinesLines.append(i);
+		mGuidelinesPath.moveTo(c*spacingW + center.x(), center.y());
+		mGuidelinesPath.lineTo(c*spacingW + center.x(), spacingH*rows + center.y());
     }
 	//generate rows
     for(int r = 0; r <= rows; r++) {
-		 i = addLine(
-			center.x(),
-			center.y() + r*spacingH,
-			center.x() + spacingW*columns,
-			center.y() + r*spacingH
-		);
-		
-		i->setZValue(-1);
-		mGuidelinesLines.append(i);
+		mGuidelinesPath.moveTo(center.x(), center.y() + r*spacingH);
+		mGuidelinesPath.lineTo(center.x() + spacingW*columns, center.y() + r*spacingH);
     }
 }
 
 void Scene::generateGuidelinesRounds(int spacingW, int spacingH, int columns, int rows, QPointF center)
 {
-    QGraphicsItem *i = 0;
+	Q_UNUSED(spacingW);
 
 	//generate dividing lines
 	for(int c = 0; c <= columns; c++) {
@@ -1858,41 +2674,33 @@ void Scene::generateGuidelinesRounds(int spacingW, int spacingH, int columns, in
 		qreal innerX = center.x() + spacingH * sin(radians);
 		qreal innerY = center.y() + spacingH * cos(radians);
 
-		i = addLine(innerX,innerY,outterX,outterY);
-		i->setZValue(-1);
-		mGuidelinesLines.append(i);
+		mGuidelinesPath.moveTo(innerX, innerY);
+		mGuidelinesPath.lineTo(outterX, outterY);
     }
 	
 	//generate circles
     for(int r = 0; r <= rows; r++) {
-	   Guideline *g = new Guideline(
+		mGuidelinesPath.addEllipse(
 			QRectF(
 				center.x() + -(r+1)*spacingH,
 				center.y() + -(r+1)*spacingH,
 				2*(r+1)*spacingH,
 				2*(r+1)*spacingH)
-			,0
-			,this
-		)
-		;
-		g->setZValue(-1);
-		mGuidelinesLines.append(g);
+		);
     }
 }
 
 void Scene::generateGuidelinesTriangles(int spacingW, int spacingH, int columns, int rows, QPointF center)
 {
 	Q_UNUSED(columns);
-    QGraphicsItem *i = 0;
 	
 	//generate the horizontal lines
 	for(int r = 0; r < rows; r++) {
         qreal height = (r+1) * spacingH;
 		qreal offsetX = (r+1) * spacingW/2;
 
-		i = addLine(-offsetX + center.x(),height + center.y(),offsetX + center.x(),height + center.y());
-		i->setZValue(-1);
-		mGuidelinesLines.append(i);
+		mGuidelinesPath.moveTo(-offsetX + center.x(), height + center.y());
+		mGuidelinesPath.lineTo(offsetX + center.x(), height + center.y());
     }
 	
 	//generate the slanted lines
@@ -1905,12 +2713,10 @@ void Scene::generateGuidelinesTriangles(int spacingW, int spacingH, int columns,
 		qreal endX = maxX - ( (rows - c) * (maxX / rows));
 		qreal endY = c * maxY / rows;
         
-		i = addLine(startX + center.x(), startY + center.y(), endX + center.x(), endY + center.y());
-		i->setZValue(-1);
-		mGuidelinesLines.append(i);
-		i = addLine(-startX + center.x(), startY + center.y(), -endX + center.x(), endY + center.y());
-		i->setZValue(-1);
-		mGuidelinesLines.append(i);
+		mGuidelinesPath.moveTo(startX + center.x(), startY + center.y());
+		mGuidelinesPath.lineTo(endX + center.x(), endY + center.y());
+		mGuidelinesPath.moveTo(-startX + center.x(), startY + center.y());
+		mGuidelinesPath.lineTo(-endX + center.x(), endY + center.y());
     }
 }
 
@@ -2211,22 +3017,19 @@ void Scene::arrangeGrid(QSize grd, QSize alignment, QSize spacing, bool useSelec
         //create new cells.
         //TODO: figure out how to deal with spacing.
 
-        for(int x = grd.width(); x > 0; --x) {
+        Stitch* stitch = findStitchOrDefault(mDefaultStitch);
+        ChartLayout layout = ChartLayout::rows(grd.width(), grd.height(), spacing,
+                                               QSizeF(stitch->width(), stitch->height()));
+        QList<QList<Cell*> > rows = createCells(layout, stitch);
 
-            QList<Cell*> r;
-            for(int y = grd.height(); y > 0; --y) {
-                Cell* c = new Cell();
-                //FIXME: use the user selected stitch
-                c->setStitch(mDefaultStitch);
-				c->setLayer(getCurrentLayer()->uid());
+        int layer = getCurrentLayer()->uid();
+        for(int r = 0; r < rows.count(); ++r) {
+            foreach(Cell* c, rows.at(r)) {
+                c->setLayer(layer);
+                c->useAlternateRenderer((grd.width() - 1 - r) % 2);
                 addItem(c);
-                r.append(c);
-                
-                c->useAlternateRenderer(((grd.width() - x) % 2));
-                c->setPos((c->stitch()->width() + spacing.width()) * y, spacing.height() * x);
             }
-
-            grid.insert(0, r);
+            grid.insert(r, rows.at(r));
         }
     }
 }
@@ -2259,100 +3062,122 @@ void Scene::propertiesUpdate(QString property, QVariant newValue)
 
     } else { // all options that require operations on a per stitch level.
 
-        if(selectedItems().count() <= 0)
+        if(selectionCount() <= 0)
             return;
 
-        IndicatorProperties ip;
-        ip = newValue.value<IndicatorProperties>();
-
-        undoStack()->beginMacro(property);
-        foreach(QGraphicsItem *i, selectedItems()) {
-            Cell *c = 0;
-            Indicator *ind = 0;
-            ItemGroup *g = 0;
-			ChartImage* ci = 0;
-
-            if(i->type() == Cell::Type) {
-                c = qgraphicsitem_cast<Cell*>(i);
-            } else if(i->type() == Indicator::Type) {
-                ind = qgraphicsitem_cast<Indicator*>(i);
-
-            } else if(i->type() == ItemGroup::Type) {
-                g = qgraphicsitem_cast<ItemGroup*>(i);
-            } else if (i->type() == ChartImage::Type) {
-				ci = qgraphicsitem_cast<ChartImage*>(i);
-			}
-
-            if(property == "Angle") {
-				qreal rotation = ChartItemTools::getRotation(i);
-				ChartItemTools::setRotation(i, newValue.toReal());
-                undoStack()->push(new SetItemRotation(i, rotation,
-														 ChartItemTools::getRotationPivot(i)));
-
-            } else if(property == "PositionX") {
-                QPointF oldPos = i->pos();
-                i->setPos(newValue.toReal(), i->pos().y());
-                undoStack()->push(new SetItemCoordinates(i, oldPos));
+        //each property is changed with one command for the whole selection.
+        QList<QGraphicsItem*> items = selection().toList();
+        QList<Cell*> cells;
+        foreach(QGraphicsItem *i, items) {
+            if(i->type() == Cell::Type)
+                cells.append(qgraphicsitem_cast<Cell*>(i));
+        }
 
-            } else if(property == "PositionY") {
-                QPointF oldPos = i->pos();
-                i->setPos(i->pos().x(), newValue.toReal());
-                undoStack()->push(new SetItemCoordinates(i, oldPos));
+        if(property == "Angle") {
+            undoStack()->push(new SetItemsRotation(items, newValue.toReal()));
+
+        } else if(property == "PositionX" || property == "PositionY") {
+            QVector<QPointF> positions;
+            positions.reserve(items.count());
+            foreach(QGraphicsItem *i, items) {
+                if(property == "PositionX")
+                    positions.append(QPointF(newValue.toReal(), i->pos().y()));
+                else
+                    positions.append(QPointF(i->pos().x(), newValue.toReal()));
+            }
+            undoStack()->push(new SetItemsCoordinates(items, positions));
+
+        } else if(property == "ScaleX" || property == "ScaleY") {
+            QVector<QPointF> scales;
+            scales.reserve(items.count());
+            foreach(QGraphicsItem *i, items) {
+                QPointF scale = ChartItemTools::getScale(i);
+                if(property == "ScaleX")
+                    scale.setX(newValue.toDouble());
+                else
+                    scale.setY(newValue.toDouble());
+                scales.append(scale);
+            }
+            undoStack()->push(new SetItemsScale(items, scales));
 
-            } else if(property == "ScaleX") {
-				QPointF scale = ChartItemTools::getScale(i);
-                ChartItemTools::setScaleX(i, newValue.toDouble());
-                undoStack()->push(new SetItemScale(i, scale,
-													  ChartItemTools::getScalePivot(i)));
+        } else if(property == "Stitch") {
+            if(!cells.isEmpty())
+                undoStack()->push(new SetCellsStitch(cells, newValue.toString()));
 
-            } else if(property == "ScaleY") {
-                ChartItemTools::setScaleY(i, newValue.toDouble());
-                undoStack()->push(new SetItemScale(i, ChartItemTools::getScale(i),
-													  ChartItemTools::getScalePivot(i)));
+        } else if(property == "Delete") {
+            undoStack()->push(new RemoveItems(this, items));
 
-            } else if(property == "Stitch") {
-                undoStack()->push(new SetCellStitch(c, newValue.toString()));
+        } else if(property == "fgColor") {
+            if(!cells.isEmpty())
+                undoStack()->push(new SetCellsColor(cells, QList<Cell*>(), newValue.value<QColor>()));
 
-            } else if(property == "Delete") {
-                undoStack()->push(new RemoveItem(this, i));
+        } else if(property == "bgColor") {
+            if(!cells.isEmpty())
+                undoStack()->push(new SetCellsColor(QList<Cell*>(), cells, newValue.value<QColor>()));
 
-            } else if(property == "Indicator") {
+        } else if(property == "Indicator") {
+            IndicatorProperties ip = newValue.value<IndicatorProperties>();
+            foreach(QGraphicsItem *i, items) {
+                if(i->type() != Indicator::Type)
+                    continue;
+                Indicator *ind = qgraphicsitem_cast<Indicator*>(i);
                 ind->setStyle(ip.style());
-				QFont font = ip.font();
-				font.setPointSize(ip.size());
-				ind->setFont(font);
-
-            } else if(property == "fgColor") {
-                undoStack()->push(new SetCellColor(c, newValue.value<QColor>()));
-
-            } else if(property == "bgColor") {
-                undoStack()->push(new SetCellBgColor(c, newValue.value<QColor>()));
+                QFont font = ip.font();
+                font.setPointSize(ip.size());
+                ind->setFont(font);
+            }
 
-            } else if(property == "ChartImagePath") {
-                undoStack()->push(new SetChartImagePath(ci, newValue.toString()));
-				
-			} else if (property == "ChartImageZLayer") {
-				undoStack()->push(new SetChartZLayer(ci, newValue.toString()));
-            } else {
-                qWarning() << "Unknown property: " << property;
+        } else if(property == "ChartImagePath" || property == "ChartImageZLayer") {
+            undoStack()->beginMacro(property);
+            foreach(QGraphicsItem *i, items) {
+                if(i->type() != ChartImage::Type)
+                    continue;
+                ChartImage *ci = qgraphicsitem_cast<ChartImage*>(i);
+                if(property == "ChartImagePath")
+                    undoStack()->push(new SetChartImagePath(ci, newValue.toString()));
+                else
+                    undoStack()->push(new SetChartZLayer(ci, newValue.toString()));
             }
+            undoStack()->endMacro();
+
+        } else {
+            qWarning() << "Unknown property: " << property;
         }
-        undoStack()->endMacro();
     }
 
 }
 
 void Scene::updateDefaultStitchColor(QColor originalColor, QColor newColor)
 {
+    QList<int> entries = paletteEntries(originalColor, true, false);
+    if(!entries.isEmpty()) {
+        foreach(int index, entries)
+            setPaletteColor(index, newColor);
+        return;
+    }
 
-    foreach(QGraphicsItem *item, items()) {
-        if(item->type() != Cell::Type)
-            continue;
-
-        Cell *c = qgraphicsitem_cast<Cell*>(item);
-        if(c->color() == originalColor)
+    foreach(Cell *c, cellsWithColor(originalColor, true, false))
         c->setColor(newColor);
+}
+
+QList<int> Scene::paletteEntries(QColor color, bool foreground, bool background)
+{
+    QList<int> entries = mPalette.indexesOf(color.rgba());
+    if(entries.isEmpty())
+        return entries;
+
+    //cells without a color of their own aren't in the palette.
+    if(foreground && color.rgba() == QColor(Qt::black).rgba() && mCellIndex.colorCount(-1) > 0)
+        return QList<int>();
+
+    //an entry can only be changed if no cell uses it for the other color.
+    foreach(int index, entries) {
+        if((!foreground && mCellIndex.colorCount(index) > 0) ||
+           (!background && mCellIndex.bgColorCount(index) > 0))
+            return QList<int>();
     }
+
+    return entries;
 }
 
 QGraphicsItem* Scene::copy_rec(QGraphicsItem* item, QPointF displacement)
@@ -2378,9 +3203,7 @@ QGraphicsItem* Scene::copy_rec(QGraphicsItem* item, QPointF displacement)
 		//and clone it
 		ChartImage* newImage = new ChartImage(image->filename());
 		newImage->setPos(image->pos());
-		newImage->setTransformations(ChartItemTools::cloneGraphicsTransformations(image));
-		foreach (QGraphicsTransform* t, newImage->transformations())
-			t->setParent(newImage->parentObject());
+		ChartItemTools::copyTransformations(image, newImage);
 		newImage->setRotation(image->rotation());
 		newImage->setLayer(getCurrentLayer()->uid());
 		undoStack()->push(new AddItem(this, newImage));
@@ -2404,9 +3227,7 @@ QGraphicsItem* Scene::copy_rec(QGraphicsItem* item, QPointF displacement)
 		
 		newGroup->setTransformOriginPoint(mPivotPt);
 		newGroup->setRotation(0);
-		newGroup->setTransformations(ChartItemTools::cloneGraphicsTransformations(g));
-		foreach (QGraphicsTransform* t, newGroup->transformations())
-			t->setParent(newGroup->parentObject());
+		ChartItemTools::copyTransformations(g, newGroup);
 		
 		foreach(QGraphicsItem* child, childs) {
 			g->removeFromGroup(child);
@@ -2432,44 +3253,39 @@ void Scene::showProperties()
 
 void Scene::copy(int direction)
 {
-    if(selectedItems().count() <= 0)
+    if(selectionCount() <= 0)
         return;
 	
+    if(direction < 1 || direction > 4)
+        return;
+
     QApplication::setOverrideCursor(QCursor(Qt::WaitCursor));
 
     QRectF rect = selectedItemsBoundingRect(selectedItems());
     QList<QGraphicsItem*> list = selectedItems();
 
+    QPointF displacement;
+    if(direction == 1) //left
+        displacement = QPointF(-rect.width(), 0);
+    else if(direction == 2) //right
+        displacement = QPointF(rect.width(), 0);
+    else if(direction == 3) //up
+        displacement = QPointF(0, -rect.height());
+    else //down
+        displacement = QPointF(0, rect.height());
+
 	blockSignals(true);
 
     clearSelection();
-	//TODO setSelected is extremely slow, optimize that
     undoStack()->beginMacro("copy selection");
-    if(direction == 1) { //left
-		foreach(QGraphicsItem* item, list) {
-			QGraphicsItem* ret = copy_rec(item, QPointF(-rect.width(), 0));
-			if (ret != NULL)
-				ret->setSelected(true);
-		}
-	} else if (direction == 2) { //right
-		foreach(QGraphicsItem* item, list) {
-			QGraphicsItem* ret = copy_rec(item, QPointF(rect.width(), 0));
-			if (ret != NULL)
-				ret->setSelected(true);
-		}
-	} else if (direction == 3) { //up
-		foreach(QGraphicsItem* item, list) {
-			QGraphicsItem* ret = copy_rec(item, QPointF(0, -rect.height()));
-			if (ret != NULL)
-				ret->setSelected(true);
-		}
-	} else if (direction == 4) { //down
-		foreach(QGraphicsItem* item, list) {
-			QGraphicsItem* ret = copy_rec(item, QPointF(0, rect.height()));
-			if (ret != NULL)
-				ret->setSelected(true);
-		}
-	}
+
+    QList<QGraphicsItem*> copies;
+    foreach(QGraphicsItem* item, list) {
+        QGraphicsItem* ret = copy_rec(item, displacement);
+        if (ret != NULL)
+            copies.append(ret);
+    }
+    setSelected(copies, true);
 	
 	blockSignals(false);
 	
@@ -2517,7 +3333,7 @@ QGraphicsItem* Scene::mirror_rec(QGraphicsItem* item, QPointF displacement, QRec
 
 void Scene::mirror(int direction)
 {
-    if(selectedItems().count() <= 0)
+    if(selectionCount() <= 0)
         return;
     QApplication::setOverrideCursor(QCursor(Qt::WaitCursor));
 
@@ -2529,198 +3345,259 @@ void Scene::mirror(int direction)
     clearSelection();
 
     undoStack()->beginMacro("mirror selection");
+
+    QPointF displacement;
+    bool flipX = false, flipY = false;
     if(direction == 1) { //left
+        displacement = QPointF(-rect.width(), 0);
+        flipX = true;
+    } else if(direction == 2) { //right
+        displacement = QPointF(rect.width(), 0);
+        flipX = true;
+    } else if(direction == 3) { //up
+        displacement = QPointF(0, -rect.height());
+        flipY = true;
+    } else if(direction == 4) { //down
+        displacement = QPointF(0, rect.height());
+        flipY = true;
+    }
 
+    QList<QGraphicsItem*> mirrored;
+    if(flipX || flipY) {
         foreach(QGraphicsItem *item, list) {
-			QGraphicsItem* mir = mirror_rec(item, QPointF(-rect.width(), 0), rect, true, false);
-			if (mir == NULL)
-				continue;
-			mir->setSelected(true);
+            QGraphicsItem* mir = mirror_rec(item, displacement, rect, flipX, flipY);
+            if (mir != NULL)
+                mirrored.append(mir);
         }
+    }
+    setSelected(mirrored, true);
+	updateSceneRect();
+	
+	blockSignals(false);
+	
+	emit selectionChanged();
+	
+	updateSceneRect();
+    undoStack()->endMacro();
+    QApplication::restoreOverrideCursor();
+}
 
-    } else if(direction == 2) { //right
+void Scene::rotate(qreal degrees)
+{
+    if(selectionCount() <= 0)
+        return;
 
-        foreach(QGraphicsItem *item, list) {
-			QGraphicsItem* mir = mirror_rec(item, QPointF(rect.width(), 0), rect, true, false);
-			if (mir == NULL)
-				continue;
-			mir->setSelected(true);
-        }
+    undoStack()->push(new SetSelectionRotation(this, selectedItems(), degrees));
+}
 
-    } else if(direction == 3) { //up
+void Scene::replicate(int copies, qreal degrees, QPointF step)
+{
+    if(selectionCount() <= 0 || copies <= 0)
+        return;
 
-        foreach(QGraphicsItem *item, list) {
-			QGraphicsItem* mir = mirror_rec(item, QPointF(0, -rect.height()), rect, false, true);
-			if (mir == NULL)
-				continue;
-			mir->setSelected(true);
-        }
+    QList<QGraphicsItem*> selected = selectedItems();
 
-    } else if(direction == 4) { //down
+    QPointF center;
+    if(hasChartCenter())
+        center = mCenterSymbol->sceneBoundingRect().center();
+    else
+        center = selectedItemsBoundingRect(selected).center();
 
-        foreach(QGraphicsItem *item, list) {
-			QGraphicsItem* mir = mirror_rec(item, QPointF(0, rect.height()), rect, false, true);
-			if (mir == NULL)
-				continue;
-			mir->setSelected(true);
+    QList<ClipboardItem> records;
+    copyRecursively(records, selected);
+
+    //create every copy, on the layer of its item, before any of them is in the scene.
+    QList<QGraphicsItem*> items;
+    QVector<int> copyOf;
+    for(int k = 1; k <= copies; ++k) {
+        foreach(const ClipboardItem& record, records) {
+            QGraphicsItem* item = pasteRecursively(record, record.layer);
+            if(item) {
+                items.append(item);
+                copyOf.append(k);
+            }
         }
     }
-	updateSceneRect();
-	
+
+    if(items.isEmpty())
+        return;
+
+    //the turn of each copy is only worked out once.
+    QVector<qreal> cosines(copies + 1);
+    QVector<qreal> sines(copies + 1);
+    for(int k = 0; k <= copies; ++k) {
+        qreal radians = k * degrees * M_PI / 180;
+        cosines[k] = cos(radians);
+        sines[k] = sin(radians);
+    }
+
+    for(int i = 0; i < items.count(); ++i) {
+        QGraphicsItem* item = items.at(i);
+        int k = copyOf.at(i);
+
+        //turning the item around its rotation pivot and then moving the pivot
+        //around the center is the same as turning the whole item around the center.
+        QPointF anchor = item->pos() + ChartItemTools::getRotationPivot(item) - center;
+        QPointF turned(anchor.x() * cosines.at(k) - anchor.y() * sines.at(k),
+                       anchor.x() * sines.at(k) + anchor.y() * cosines.at(k));
+
+        item->setPos(item->pos() + turned - anchor + step * k);
+        if(degrees != 0)
+            ChartItemTools::addRotation(item, k * degrees);
+    }
+
+	blockSignals(true);
+
+    clearSelection();
+    AddItems* add = new AddItems(this, items);
+    add->setText(tr("replicate selection"));
+    undoStack()->push(add);
+    setSelected(items, true);
+
 	blockSignals(false);
-	
-	emit selectionChanged();
-	
-	updateSceneRect();
-    undoStack()->endMacro();
-    QApplication::restoreOverrideCursor();
-}
 
-void Scene::rotate(qreal degrees)
-{
-    if(selectedItems().count() <= 0)
-        return;
+	emit selectionChanged();
 
-    undoStack()->push(new SetSelectionRotation(this, selectedItems(), degrees));
+    updateSceneRect();
 }
 
 void Scene::copy()
 {
-    if(selectedItems().count() <= 0)
+    if(selectionCount() <= 0)
         return;
 
-    QByteArray copyData;
-    QDataStream stream(&copyData, QIODevice::WriteOnly);
-    QMimeData *mimeData = new QMimeData;
-
-    stream << selectedItems().count();
-    copyRecursively(stream, selectedItems());
+    //the items are only written out as a stream if another program asks for them.
+    QList<ClipboardItem> items;
+    copyRecursively(items, selectedItems());
 
-    mimeData->setData("application/crochet-cells", copyData);
-    QApplication::clipboard()->setMimeData(mimeData);
+    QApplication::clipboard()->setMimeData(new ClipboardData(items));
 
 }
 
-void Scene::copyRecursively(QDataStream &stream, QList<QGraphicsItem*> items)
+void Scene::copyRecursively(QList<ClipboardItem>& copied, QList<QGraphicsItem*> items)
 {
     foreach(QGraphicsItem* item, items) {
-        stream << item->type();
+        ClipboardItem copy;
+        copy.type = item->type();
 
         switch(item->type()) {
             case Cell::Type: {
                 Cell* c = qgraphicsitem_cast<Cell*>(item);
-                stream << c->name() << c->color() << c->bgColor()
-                    << ChartItemTools::getRotation(c) << ChartItemTools::getRotationPivot(c)
-                    << ChartItemTools::getScaleX(c) << ChartItemTools::getScaleY(c)
-					<< ChartItemTools::getScalePivot(c) << c->transformOriginPoint() << c->pos();
+                copy.name = c->name();
+                copy.color = c->color().rgba();
+                copy.bgColor = c->bgColor().rgba();
+                copy.transformOrigin = c->transformOriginPoint();
+                copy.pos = c->pos();
                 break;
             }
             case Indicator::Type: {
                 Indicator* i = qgraphicsitem_cast<Indicator*>(item);
-                stream << i->scenePos() << i->text()
-					<< ChartItemTools::getRotation(i) << ChartItemTools::getRotationPivot(i)
-                    << ChartItemTools::getScaleX(i) << ChartItemTools::getScaleY(i)
-					<< ChartItemTools::getScalePivot(i);
+                copy.name = i->text();
+                copy.pos = i->scenePos();
                 break;
             }
             case ItemGroup::Type: {
                 ItemGroup* group = qgraphicsitem_cast<ItemGroup*>(item);
-				ChartItemTools::recalculateTransformations(group);
-                stream << group->pos()
-					<< group->childItems().count()
-					<< ChartItemTools::getRotation(group) << ChartItemTools::getRotationPivot(group)
-                    << ChartItemTools::getScaleX(group) << ChartItemTools::getScaleY(group)
-					<< ChartItemTools::getScalePivot(group);
-				
-				QList<QGraphicsItem*> childs = group->childItems();
-				
-				foreach(QGraphicsItem* child, childs) {
-						group->removeFromGroup(child);
-						ChartItemTools::recalculateTransformations(child);
-				}
-					
-                copyRecursively(stream, childs);
-				
-				foreach(QGraphicsItem* child, childs) {
-						group->addToGroup(child);
-				}
+				if(!group->parentItem())
+					ChartItemTools::recalculateTransformations(group);
+                copy.pos = group->pos();
+                copyRecursively(copy.children, group->childItems());
                 break;
             }
 			case ChartImage::Type: {
 				ChartImage* image = qgraphicsitem_cast<ChartImage*>(item);
-				
-				stream << image->filename() << image->pos()
-					<< ChartItemTools::getRotation(image) << ChartItemTools::getRotationPivot(image)
-                    << ChartItemTools::getScaleX(image) << ChartItemTools::getScaleY(image)
-					<< ChartItemTools::getScalePivot(image);
+				copy.name = image->filename();
+				copy.pos = image->pos();
 				break;
 			}
-            case Guideline::Type:
-                qDebug() << "guideline";
             default:
                 WARN("Unknown data type: " + QString::number(item->type()));
-                break;
+                continue;
+        }
+
+        copy.layer = itemLayer(item);
+
+        if(item->parentItem()) {
+            //the children of a group are copied with their scene transformations,
+            //worked out from the group without taking them out of it.
+            ChartItemTransform t = ChartItemTools::sceneTransformations(item->boundingRect(),
+                                                    item->sceneTransform(), &copy.pos);
+            copy.transformOrigin = QPointF();
+            copy.rotation = t.rotation;
+            copy.rotationPivot = t.rotationPivot;
+            copy.scaleX = t.scaleX;
+            copy.scaleY = t.scaleY;
+            copy.scalePivot = t.scalePivot;
+        } else {
+            copy.rotation = ChartItemTools::getRotation(item);
+            copy.rotationPivot = ChartItemTools::getRotationPivot(item);
+            copy.scaleX = ChartItemTools::getScaleX(item);
+            copy.scaleY = ChartItemTools::getScaleY(item);
+            copy.scalePivot = ChartItemTools::getScalePivot(item);
         }
+        copied.append(copy);
     }
 }
-
 void Scene::paste()
 {
-    const QMimeData *mimeData = QApplication::clipboard()->mimeData();
+    //items copied in this program are used as they are, without going through the stream.
+    QList<ClipboardItem> copied = ClipboardData::items(QApplication::clipboard()->mimeData());
+    if(copied.isEmpty())
+        return;
 
-    QByteArray pasteData = mimeData->data("application/crochet-cells");
-    QDataStream stream(&pasteData, QIODevice::ReadOnly);
+    //create and place every item before any of them is in the scene.
+    unsigned int layer = getCurrentLayer()->uid();
+    QList<QGraphicsItem*> items;
+    items.reserve(copied.count());
+    foreach(const ClipboardItem& copy, copied) {
+        QGraphicsItem* item = pasteRecursively(copy, layer);
+        if(item)
+            items.append(item);
+    }
 
-    clearSelection();
+    if(items.isEmpty())
+        return;
 
-    undoStack()->beginMacro("paste items");
-    int count = 0;
-    stream >> count;
-    
-	//disable signals for performance
-	blockSignals(true);
-	
-    QList<QGraphicsItem*> items;
-    for(int i = 0; i < count; ++i) {
-        pasteRecursively(stream, &items);
+    QPointF offset;
+    QString pasteOS = Settings::inst()->value("pasteOffset").toString();
+    if(pasteOS == tr("Up and Left"))
+        offset = QPointF(-10, -10);
+    else if (pasteOS == tr("Up and Right"))
+        offset = QPointF(10, -10);
+    else if (pasteOS == tr("Down and Left"))
+        offset = QPointF(-10, 10);
+    else if (pasteOS == tr("Down and Right"))
+        offset = QPointF(10, 10);
+    else if (pasteOS == tr("On mouse cursor") && !views().isEmpty()) {
+        //center the items on the cursor.
+        QRectF box;
+        foreach(QGraphicsItem* item, items)
+            box |= item->sceneBoundingRect();
+
+        QGraphicsView* view = views().first();
+        QPointF mousePos = view->mapToScene(view->mapFromGlobal(QCursor::pos()));
+        offset = mousePos - box.center();
     }
 
-    foreach(QGraphicsItem* item, items)
-        item->setSelected(true);
-		
-	//if we need to center around the mouse
-	if (Settings::inst()->value("pasteOffset").toString().compare(tr("On mouse cursor")) == 0) {
-		if (items.count() > 0) {
-			
-			//get the bounding box of all pasted items
-			QRectF box = items.first()->sceneBoundingRect();
-			foreach(QGraphicsItem* item, items) {
-				box = box.unite(item->sceneBoundingRect());
-			}
-			
-			//get the cursor position in the scene
-			QPointF mousePos = views().first()->mapToScene(views().first()->mapFromGlobal(QCursor::pos()));
-			
-			//now calculate the amount we need to move the items
-			QPointF diff =  mousePos - box.center();
-			
-			//and move all objects with that diff
-			foreach(QGraphicsItem* item, items) {
-				item->moveBy(diff.x(), diff.y());
-			}
-		}
-	}
-	
-	//finally, snap each pasted object on the grid
-    foreach(QGraphicsItem* item, items) {
-		snapGraphicsItemToGrid(*item);
-	}
-	
+    if(!offset.isNull()) {
+        foreach(QGraphicsItem* item, items)
+            item->moveBy(offset.x(), offset.y());
+    }
+
+    snapItemsToGrid(items);
+
+    //disable signals for performance
+	blockSignals(true);
+
+    clearSelection();
+    AddItems* add = new AddItems(this, items);
+    add->setText(tr("paste items"));
+    undoStack()->push(add);
+    setSelected(items, true);
+
 	blockSignals(false);
 	
 	emit selectionChanged();
-	
-    undoStack()->endMacro();
 }
 
 void Scene::insertImage(const QString& filename, QPointF pos)
@@ -2733,224 +3610,114 @@ void Scene::insertImage(const QString& filename, QPointF pos)
 
 void Scene::deleteSelection()
 {
-    QList<QGraphicsItem*> items = selectedItems();
-    undoStack()->beginMacro("remove items");
-	//undoStack()->push(new RemoveItems(this, items));
-	blockSignals(true);
-	foreach(QGraphicsItem* item, items) {
+    QList<QGraphicsItem*> items;
+    foreach(QGraphicsItem* item, selectedItems()) {
         switch(item->type()) {
             case ItemGroup::Type:
-            case Cell::Type: {
-                undoStack()->push(new RemoveItem(this, item));
-                break;
-            }
-            case Indicator::Type: {
-                Indicator *i = qgraphicsitem_cast<Indicator*>(item);
-                undoStack()->push(new RemoveIndicator(this, i));
+            case Cell::Type:
+            case Indicator::Type:
+            case ChartImage::Type:
+                items.append(item);
                 break;
-            }
-			case ChartImage::Type: {
-				ChartImage *i = qgraphicsitem_cast<ChartImage*>(item);
-				undoStack()->push(new RemoveItem(this, i));
-				break;
-			}
             default:
-                qWarning() << "keyReleaseEvent - unknown type: " << item->type();
+                qWarning() << "deleteSelection - unknown type: " << item->type();
                 break;
         }
     }
+
+    if(items.isEmpty())
+        return;
+
+	blockSignals(true);
+    undoStack()->push(new RemoveItems(this, items));
 	blockSignals(false);
 	
 	//signals were blocked so we manually emit them
 	emit selectionChanged();
-	
-    undoStack()->endMacro();
 }
 
-void Scene::pasteRecursively(QDataStream &stream, QList<QGraphicsItem*> *group)
+QGraphicsItem* Scene::pasteRecursively(const ClipboardItem& copy, unsigned int layer)
 {
-    QPointF offSet;
-    QString pasteOS = Settings::inst()->value("pasteOffset").toString();
-    if(pasteOS == tr("Up and Left"))
-        offSet = QPointF(-10, -10);
-    else if (pasteOS == tr("Up and Right"))
-        offSet = QPointF(10, -10);
-    else if (pasteOS == tr("Down and Left"))
-        offSet = QPointF(-10, 10);
-    else if (pasteOS == tr("Down and Right"))
-        offSet = QPointF(10, 10);
-    else
-        offSet = QPointF(0,0);
+    QGraphicsItem* item = 0;
 
-    int type;
-    stream >> type;
-    switch(type) {
+    switch(copy.type) {
 
         case Cell::Type: {
-            QString name;
-            QColor color, bgColor;
-            qreal rotation, scaleX, scaleY;
-            QPointF pos, transPoint, pivotRotation, pivotScale;
-		
-            stream >> name >> color >> bgColor >> rotation >> pivotRotation;
-			stream >> scaleX >> scaleY >> pivotScale >> transPoint >> pos;
-
-            pos += offSet;
-
             Cell *c = new Cell();
-            undoStack()->push(new AddItem(this, c));
-            c->setPos(pos);
-            c->setStitch(name);
-            c->setColor(color);
-            c->setBgColor(bgColor);
-			c->setLayer(getCurrentLayer()->uid());
-
-            c->setTransformOriginPoint(transPoint);
-            ChartItemTools::setRotation(c, rotation);
-            ChartItemTools::setScaleX(c, scaleX);
-			ChartItemTools::setScaleY(c, scaleY);
-			ChartItemTools::setScalePivot(c, pivotScale, false);
-			ChartItemTools::setRotationPivot(c, pivotRotation, false);
-
-            c->setSelected(false);
-            group->append(c);
+            c->setStitch(copy.name);
+            c->setColor(QColor::fromRgba(copy.color));
+            c->setBgColor(QColor::fromRgba(copy.bgColor));
+			c->setLayer(layer);
+            c->setTransformOriginPoint(copy.transformOrigin);
+            item = c;
             break;
         }
         case Indicator::Type: {
             Indicator *i = new Indicator();
-            //FIXME: add this indicator to the undo stack.
-            QPointF pos, pivotScale, pivotRotation;
-            QString text;
-            qreal rotation, scaleX, scaleY;
-			
-            stream >> pos >> text >> rotation >> pivotRotation >> scaleX;
-			stream >> scaleY >> pivotScale;
-			
-            pos += offSet;
-            i->setText(text);
-            addItem(i);
-            i->setPos(pos);
-			i->setLayer(getCurrentLayer()->uid());
-
-            i->setSelected(false);
-			
-            ChartItemTools::setRotation(i, rotation);
-            ChartItemTools::setScaleX(i, scaleX);
-			ChartItemTools::setScaleY(i, scaleY);
-			ChartItemTools::setScalePivot(i, pivotScale, false);
-			ChartItemTools::setRotationPivot(i, pivotRotation, false);
-			
-			group->append(i);
+            i->setText(copy.name);
+			i->setLayer(layer);
+            item = i;
 			break;
         }
         case ItemGroup::Type: {
-			
-            QPointF pos, pivotScale, pivotRotation;
-			qreal rotation, scaleX, scaleY;
-			int childCount;
-			
-			stream >> pos >> childCount >> rotation >> pivotRotation >> scaleX;
-			stream >> scaleY >> pivotScale;
-			QList<QGraphicsItem*> items;
-            for(int i = 0; i < childCount; ++i) {
-                pasteRecursively(stream, &items);
+            ItemGroup *g = new ItemGroup();
+
+            QList<QGraphicsItem*> items;
+            foreach(const ClipboardItem& child, copy.children) {
+                QGraphicsItem* i = pasteRecursively(child, layer);
+                if(i)
+                    items.append(i);
             }
-			
-			
-            GroupItems *grpItems = new GroupItems(this, items);
-            undoStack()->push(grpItems);
-            ItemGroup *g = grpItems->group();
-			g->setSelected(false);
-            
-			group->append(g);
-			
-			foreach(QGraphicsItem* child, items) {
-				g->removeFromGroup(child);
-			}
-			
-            g->setPos(pos);
-			ChartItemTools::setRotation(g, rotation);
-			ChartItemTools::setScaleX(g, scaleX);
-			ChartItemTools::setScaleY(g, scaleY);
-			ChartItemTools::setScalePivot(g, pivotScale, false);
-			ChartItemTools::setRotationPivot(g, pivotRotation, false);
-			
-			foreach(QGraphicsItem* child, items) {
-				g->addToGroup(child);
-			}
-			
-			g->setLayer(getCurrentLayer()->uid());
-            break;
+
+            //set up the group before the children are added so they keep their own transformations.
+            g->setPos(copy.pos);
+			ChartItemTools::setRotation(g, copy.rotation);
+			ChartItemTools::setScaleX(g, copy.scaleX);
+			ChartItemTools::setScaleY(g, copy.scaleY);
+			ChartItemTools::setScalePivot(g, copy.scalePivot, false);
+			ChartItemTools::setRotationPivot(g, copy.rotationPivot, false);
+
+            foreach(QGraphicsItem* child, items) {
+                child->setFlag(QGraphicsItem::ItemIsSelectable, false);
+                g->addToGroup(child);
+            }
+
+            g->setFlag(QGraphicsItem::ItemIsMovable);
+            g->setFlag(QGraphicsItem::ItemIsSelectable);
+			g->setLayer(layer);
+            return g;
         }
 		case ChartImage::Type: {
-			qreal rotation, scaleX, scaleY;
-			QPointF pos, pivotScale, pivotRotation;
-			QString filename;
-					
-			stream >> filename >> pos >> rotation >> pivotRotation >> scaleX >> scaleY >> pivotScale;
-			
-			ChartImage* image = new ChartImage(filename);
-			
-            undoStack()->push(new AddItem(this, image));
-			image->setPos(pos);
-			image->setLayer(getCurrentLayer()->uid());
-			
-            ChartItemTools::setRotation(image, rotation);
-            ChartItemTools::setScaleX(image, scaleX);
-			ChartItemTools::setScaleY(image, scaleY);
-			ChartItemTools::setScalePivot(image, pivotScale, false);
-			ChartItemTools::setRotationPivot(image, pivotRotation, false);
-			
-			group->append(image);
-			image->setSelected(false);
+			ChartImage* image = new ChartImage(copy.name);
+			image->setLayer(layer);
+            item = image;
 			break;
 		}
         default: {
-            WARN("Unknown data type: " + QString::number(type));
-            break;
+            WARN("Unknown data type: " + QString::number(copy.type));
+            return 0;
         }
     }
 
+    item->setPos(copy.pos);
+    ChartItemTools::setRotation(item, copy.rotation);
+    ChartItemTools::setScaleX(item, copy.scaleX);
+    ChartItemTools::setScaleY(item, copy.scaleY);
+    ChartItemTools::setScalePivot(item, copy.scalePivot, false);
+    ChartItemTools::setRotationPivot(item, copy.rotationPivot, false);
+    return item;
 }
 
 void Scene::cut()
 {
-    if(selectedItems().count() <= 0)
+    if(selectionCount() <= 0)
         return;
 
     copy();
 
     undoStack()->beginMacro(tr("cut items"));
-    foreach(QGraphicsItem *item, selectedItems()) {
-
-        switch(item->type()) {
-            case Cell::Type: {
-                Cell *c = qgraphicsitem_cast<Cell*>(item);
-                undoStack()->push(new RemoveItem(this, c));
-                break;
-            }
-            case Indicator::Type: {
-                Indicator *i = qgraphicsitem_cast<Indicator*>(item);
-                undoStack()->push(new RemoveIndicator(this, i));
-                break;
-            }
-            case ItemGroup::Type: {
-                ItemGroup *g = qgraphicsitem_cast<ItemGroup*>(item);
-                undoStack()->push(new RemoveItem(this, g));
-                break;
-            }
-            case ChartImage::Type: {
-                ChartImage *g = qgraphicsitem_cast<ChartImage*>(item);
-                undoStack()->push(new RemoveItem(this, g));
-                break;
-            }
-            default:
-                WARN("Unknown data type: " + QString::number(item->type()));
-                break;
-        }
-    }
+    deleteSelection();
     undoStack()->endMacro();
-
 }
 
 QRectF Scene::selectedItemsBoundingRect(QList<QGraphicsItem*> items)
@@ -2983,7 +3750,7 @@ QRectF Scene::selectedItemsBoundingRect(QList<QGraphicsItem*> items)
 
 void Scene::group()
 {
-    if(selectedItems().count() <= 1)
+    if(selectionCount() <= 1)
         return;
 
     undoStack()->push(new GroupItems(this, selectedItems()));
@@ -3020,10 +3787,10 @@ ItemGroup* Scene::group(QList<QGraphicsItem*> items, ItemGroup* g)
 
 void Scene::ungroup()
 {
-    if(selectedItems().count() <= 0)
+    if(selectionCount() <= 0)
         return;
 
-    foreach(QGraphicsItem* item, selectedItems()) {
+    foreach(QGraphicsItem* item, selection()) {
         if(item->type() == ItemGroup::Type) {
             ItemGroup* group = qgraphicsitem_cast<ItemGroup*>(item);
             undoStack()->push(new UngroupItems(this, group));
@@ -3083,9 +3850,12 @@ void Scene::editorGotFocus(Indicator* item)
 
 QRectF Scene::itemsBoundingRect()
 {
-    QList<QGraphicsItem*> itemList = items();
+    //the index keeps the bounds of the chart items up to date as they change.
+    QRectF rect = spatialIndex().bounds();
 
-    QRectF rect = selectedItemsBoundingRect(itemList);
+    //the guidelines aren't items anymore but the chart should still grow to fit them.
+    if(!mGuidelinesPath.isEmpty())
+        rect = rect.united(mGuidelinesPath.controlPointRect());
 
     rect.setTop(rect.top() - 10);
     rect.setBottom(rect.bottom() + 10);
@@ -3180,40 +3950,7 @@ void Scene::removeLayerUndoable(unsigned int uid)
 	ChartLayer* layer = mLayers[uid];
 	
 	//first, remove all items in the layer
-	QList<QGraphicsItem*> toRemove;
-	QList<QGraphicsItem*> itemslist = items();
-	
-	foreach(QGraphicsItem *item, itemslist) {
-		switch(item->type()) {
-			case Cell::Type: {
-				Cell *c = qgraphicsitem_cast<Cell*>(item);
-				if (c->layer() == layer->uid() && c->parentItem() == NULL)
-					toRemove.append(c);
-				break;
-			}
-			case Indicator::Type: {
-				Indicator*c = qgraphicsitem_cast<Indicator*>(item);
-				if (c->layer() == layer->uid() && c->parentItem() == NULL)
-					toRemove.append(c);
-				break;
-			}
-			case ItemGroup::Type: {
-				ItemGroup *c = qgraphicsitem_cast<ItemGroup*>(item);
-				if (c->layer() == layer->uid() && c->parentItem() == NULL)
-					toRemove.append(c);
-				break;
-			}
-			case ChartImage::Type: {
-				ChartImage *c = qgraphicsitem_cast<ChartImage*>(item);
-				if (c->layer() == layer->uid() && c->parentItem() == NULL)
-					toRemove.append(c);
-				break;
-			}
-			default:
-				WARN("Unknown data type: " + QString::number(item->type()));
-				break;
-		}
-	}
+	QList<QGraphicsItem*> toRemove = layerItems(layer->uid());
 	
 	mUndoStack.push(new RemoveItems(this, toRemove));
 	mUndoStack.push(new RemoveLayer(this, layer));
@@ -3234,39 +3971,9 @@ void Scene::mergeLayer(unsigned int from, unsigned int to)
 	if (mSelectedLayer != NULL)
 	{
 		mUndoStack.beginMacro("merge layers");
-		QList<QGraphicsItem*> itemslist = items();
 		//move all items in the from layer to the to layer
-		foreach(QGraphicsItem *item, itemslist) {
-			switch(item->type()) {
-				case Cell::Type: {
-					Cell *c = qgraphicsitem_cast<Cell*>(item);
-					if (c->layer() == from)
-						mUndoStack.push(new SetLayerStitch(this, c, to));
-					break;
-				}
-				case Indicator::Type: {
-					Indicator*c = qgraphicsitem_cast<Indicator*>(item);
-					if (c->layer() == from)
-						mUndoStack.push(new SetLayerIndicator(this, c, to));
-					break;
-				}
-				case ItemGroup::Type: {
-					ItemGroup *c = qgraphicsitem_cast<ItemGroup*>(item);
-					if (c->layer() == from)
-						mUndoStack.push(new SetLayerGroup(this, c, to));
-					break;
-				}
-				case ChartImage::Type: {
-					ChartImage *c = qgraphicsitem_cast<ChartImage*>(item);
-					if (c->layer() == from)
-						mUndoStack.push(new SetLayerImage(this, c, to));
-					break;
-				}
-				default:
-					WARN("Unknown data type: " + QString::number(item->type()));
-					break;
-			}
-		}
+		foreach(QGraphicsItem *item, layerItems(from))
+			setItemLayerUndoable(item, to);
 		
 		//and now we remove from
 		mUndoStack.push(new RemoveLayer(this, mLayers[from]));
@@ -3277,46 +3984,55 @@ void Scene::mergeLayer(unsigned int from, unsigned int to)
 	}
 }
 
+void Scene::setItemLayerUndoable(QGraphicsItem* item, unsigned int layer)
+{
+	switch(item->type()) {
+		case Cell::Type:
+			mUndoStack.push(new SetLayerStitch(this, qgraphicsitem_cast<Cell*>(item), layer));
+			break;
+		case Indicator::Type:
+			mUndoStack.push(new SetLayerIndicator(this, qgraphicsitem_cast<Indicator*>(item), layer));
+			break;
+		case ItemGroup::Type:
+			mUndoStack.push(new SetLayerGroup(this, qgraphicsitem_cast<ItemGroup*>(item), layer));
+			//the grouped items move with their group.
+			foreach(QGraphicsItem* child, item->childItems())
+				setItemLayerUndoable(child, layer);
+			break;
+		case ChartImage::Type:
+			mUndoStack.push(new SetLayerImage(this, qgraphicsitem_cast<ChartImage*>(item), layer));
+			break;
+		default:
+			WARN("Unknown data type: " + QString::number(item->type()));
+			break;
+	}
+}
+
 void Scene::selectLayer(unsigned int uid)
 {
 	clearSelection();
 	
-	ChartLayer* layer = mLayers[uid];
-	if (layer != NULL) {
-		mSelectedLayer = layer;
+	ChartLayer* layer = mLayers.value(uid);
+	if (layer == NULL)
+		return;
+	
+	ChartLayer* previous = mSelectedLayer;
+	mSelectedLayer = layer;
+	
+	//the first time a layer is selected every item has to be set up,
+	//after that only the items of the old and new layer change.
+	if (previous == NULL) {
+		refreshLayers();
+		return;
 	}
 	
-    foreach(QGraphicsItem *item, items()) {
-        switch(item->type()) {
-            case Cell::Type: {
-			Cell *c = qgraphicsitem_cast<Cell*>(item);
-			c->setFlag(QGraphicsItem::ItemIsSelectable, c->layer() == layer->uid() && c->parentItem() == NULL);
-			c->setSelected(false);
-                break;
-            }
-            case Indicator::Type: {
-			Indicator*c = qgraphicsitem_cast<Indicator*>(item);
-			c->setFlag(QGraphicsItem::ItemIsSelectable, c->layer() == layer->uid() && c->parentItem() == NULL);
-			c->setSelected(false);
-                break;
-            }
-            case ItemGroup::Type: {
-			ItemGroup *c = qgraphicsitem_cast<ItemGroup*>(item);
-			c->setFlag(QGraphicsItem::ItemIsSelectable, c->layer() == layer->uid() && c->parentItem() == NULL);
-			c->setSelected(false);
-                break;
-            }
-            case ChartImage::Type: {
-			ChartImage *c = qgraphicsitem_cast<ChartImage*>(item);
-			c->setFlag(QGraphicsItem::ItemIsSelectable, c->layer() == layer->uid() && c->parentItem() == NULL);
-			c->setSelected(false);
-                break;
-            }
-            default:
-                WARN("Unknown data type: " + QString::number(item->type()));
-                break;
-        }
-    }
+	if (previous != layer && mLayers.contains(previous->uid()))
+		editedLayer(previous);
+	editedLayer(layer);
+	
+	//the cached layers changed, draw everything again.
+	if (previous != layer && mLayerCacheView)
+		update();
 }
 
 void Scene::editedLayer(ChartLayer* layer)
@@ -3324,49 +4040,10 @@ void Scene::editedLayer(ChartLayer* layer)
 	if (layer == NULL || mSelectedLayer == NULL)
 		return;
 	
-    foreach(QGraphicsItem *item, items()) {
-        switch(item->type()) {
-            case Cell::Type: {
-                Cell *c = qgraphicsitem_cast<Cell*>(item);
-                if (c->layer() == layer->uid()) {
-                c->setVisible(layer->visible());
-                c->setFlag(QGraphicsItem::ItemIsSelectable, layer->visible()
-                    && c->parentItem() == NULL && layer->uid() == mSelectedLayer->uid());
-                } 
-				break;
-            }
-            case Indicator::Type: {
-                Indicator*c = qgraphicsitem_cast<Indicator*>(item);
-                if (c->layer() == layer->uid()) {
-                c->setVisible(layer->visible());
-                c->setFlag(QGraphicsItem::ItemIsSelectable, layer->visible()
-                    && c->parentItem() == NULL && layer->uid() == mSelectedLayer->uid());
-                }
-                break;
-            }
-            case ItemGroup::Type: {
-                ItemGroup *c = qgraphicsitem_cast<ItemGroup*>(item);
-                if (c->layer() == layer->uid()) {
-                c->setVisible(layer->visible());
-                c->setFlag(QGraphicsItem::ItemIsSelectable, layer->visible()
-                    && c->parentItem() == NULL && layer->uid() == mSelectedLayer->uid());
-                }
-				break;
-            } case ChartImage::Type: {
-                ChartImage *c = qgraphicsitem_cast<ChartImage*>(item);
-                if (c->layer() == layer->uid()) {
-                c->setVisible(layer->visible());
-                c->setFlag(QGraphicsItem::ItemIsSelectable, layer->visible()
-                    && c->parentItem() == NULL && layer->uid() == mSelectedLayer->uid());
-                }
-				break;
-				
-			}
-            default:
-                WARN("Unknown data type: " + QString::number(item->type()));
-                break;
-        }
-    }
+	foreach(QGraphicsItem *item, layerItems(layer->uid()))
+		applyLayerState(item, layer);
+	
+	++mLayerCacheVersion;
 }
 
 ChartLayer* Scene::getCurrentLayer()
@@ -3441,7 +4118,10 @@ void Scene::setShowChartCenter(bool state)
                 rect = QRectF(topLeft, bottomRight);
             }
 
-            mCenterSymbol = addEllipse(rect.center().x()-radius, rect.center().y()-radius, radius * 2, radius * 2, pen);
+            ChartCenterSymbol* symbol = new ChartCenterSymbol(QRectF(rect.center().x()-radius, rect.center().y()-radius, radius * 2, radius * 2));
+            symbol->setPen(pen);
+            addItem(symbol);
+            mCenterSymbol = symbol;
             mCenterSymbol->setFlag(QGraphicsItem::ItemIsMovable);
             mCenterSymbol->setFlag(QGraphicsItem::ItemIsSelectable);
 
@@ -3464,11 +4144,18 @@ void Scene::createRoundsChart(int rows, int cols, QString stitch, QSizeF rowSize
 
     mDefaultSize = rowSize;
 
-    for(int i = 0; i < rows; ++i) {
-        //FIXME: this padding should be dependant on the height of the sts.
-        int pad = i * increaseBy;
+    //every stitch is the same so one cell gives the size of all of them.
+    Stitch* s = findStitchOrDefault(stitch);
+    Cell sizer;
+    sizer.setStitch(s);
 
-        createRow(i, cols + pad, stitch);
+    ChartLayout layout = ChartLayout::rounds(rows, cols, increaseBy, rowSize.height(), sizer.boundingRect().size());
+    QList<QList<Cell*> > rounds = createCells(layout, s);
+
+    for(int r = 0; r < rounds.count(); ++r) {
+        foreach(Cell* c, rounds.at(r))
+            addItem(c);
+        grid.insert(r, rounds.at(r));
     }
 
     setShowChartCenter(Settings::inst()->value("showChartCenter").toBool());
@@ -3477,51 +4164,29 @@ void Scene::createRoundsChart(int rows, int cols, QString stitch, QSizeF rowSize
     
 }
 
-void Scene::setCellPosition(int row, int column, Cell* c, int columns)
-{
-
-    double widthInDegrees = 360.0 / columns;
-
-    double radius = defaultSize().height() * (row + 1) + (32);
-
-    double degrees = widthInDegrees * column;
-
-    QPointF pivotPt = QPointF(c->boundingRect().width()/2, c->boundingRect().height());
-    c->setTransformOriginPoint(pivotPt);
-    c->setRotation(degrees + 90);
-
-    QPointF finish = calcPoint(radius, degrees, QPointF(0,0));
-    finish.rx() -= c->boundingRect().width()/2;
-    finish.ry() -= c->boundingRect().height()/2;
-
-    c->setPos(finish.x(), finish.y());
-
-}
-
-QPointF Scene::calcPoint(double radius, double angleInDegrees, QPointF origin)
-{
-    // Convert from degrees to radians via multiplication by PI/180
-    qreal x = (radius * cos(angleInDegrees * M_PI / 180)) + origin.x();
-    qreal y = (radius * sin(angleInDegrees * M_PI / 180)) + origin.y();
-    return QPointF(x, y);
-}
-
-void Scene::createRow(int row, int columns, QString stitch)
+QList<QList<Cell*> > Scene::createCells(const ChartLayout& layout, Stitch* stitch)
 {
+    QList<QList<Cell*> > rows;
+    QPointF origin(layout.stitchSize().width()/2, layout.stitchSize().height());
 
-    Cell* c = 0;
+    for(int r = 0; r < layout.rowCount(); ++r) {
+        int start = layout.rowStart(r);
+        int end = start + layout.rowLength(r);
 
-    QList<Cell*> modelRow;
-    for(int i = 0; i < columns; ++i) {
-        c = new Cell();
-        c->setStitch(stitch);
-        addItem(c);
-        
-        modelRow.append(c);
-        setCellPosition(row, i, c, columns);
+        QList<Cell*> row;
+        row.reserve(end - start);
+        for(int i = start; i < end; ++i) {
+            Cell* c = new Cell();
+            c->setStitch(stitch);
+            c->setTransformOriginPoint(origin);
+            c->setPos(layout.pos(i));
+            c->setRotation(layout.angle(i));
+            row.append(c);
+        }
+        rows.append(row);
     }
-    grid.insert(row, modelRow);
 
+    return rows;
 }
 
 void Scene::setEditMode(EditMode mode)
@@ -3575,53 +4240,36 @@ void Scene::setGuidelinesType(QString guides)
 
 void Scene::replaceStitches(QString original, QString replacement)
 {
+    QList<Cell*> cells = cellsWithStitch(original);
+    if(cells.isEmpty())
+        return;
 
-    undoStack()->beginMacro(tr("replace stitches"));
-    foreach(QGraphicsItem *i, items()) {
-        if(!i)
-            continue;
-        if(i->type() != Cell::Type)
-            continue;
-
-        Cell *c = qgraphicsitem_cast<Cell*>(i);
-        if(!c)
-            continue;
-
-        if(c->stitch()->name() == original) {
-            undoStack()->push(new SetCellStitch(c, replacement));
-        }
-
-    }
-    undoStack()->endMacro();
-
+    undoStack()->push(new SetCellsStitch(cells, replacement));
 }
 
 void Scene::replaceColor(QColor original, QColor replacement, int selection)
 {
-    undoStack()->beginMacro(tr("replace color"));
-    foreach(QGraphicsItem *i, items()) {
-        if(!i)
-            continue;
-        if(i->type() != Cell::Type)
-            continue;
+    bool foreground = (selection == 1 || selection == 3);
+    bool background = (selection == 2 || selection == 3);
 
-        Cell *c = qgraphicsitem_cast<Cell*>(i);
-		
-		if(!c)
-            continue;
+    QList<int> entries = paletteEntries(original, foreground, background);
+    if(!entries.isEmpty()) {
+        undoStack()->beginMacro(tr("replace color"));
+        foreach(int index, entries)
+            undoStack()->push(new SetPaletteColor(this, index, replacement));
+        undoStack()->endMacro();
+        return;
+    }
 
-        if(selection == 1 || selection == 3) {
-            if(c->color().name() == original.name()) {
-                undoStack()->push(new SetCellColor(c, replacement));
-            }
-        }
+    QList<Cell*> fgCells;
+    QList<Cell*> bgCells;
+    if(foreground)
+        fgCells = cellsWithColor(original, true, false);
+    if(background)
+        bgCells = cellsWithColor(original, false, true);
 
-        if(selection == 2 || selection == 3) {
-            if(c->bgColor().name() == original.name()) {
-                undoStack()->push(new SetCellBgColor(c, replacement));
-            }
-        }
+    if(fgCells.isEmpty() && bgCells.isEmpty())
+        return;
 
-    }
-    undoStack()->endMacro();
+    undoStack()->push(new SetCellsColor(fgCells, bgCells, replacement));
 }
\ No newline at end of file
@@ -22,11 +22,14 @@
 #define SCENE_H
 
 #include <QGraphicsScene>
+#include <QGraphicsView>
+#include <QPointer>
 
 #include "cell.h"
 #include "ChartImage.h"
 
 #include <QHash>
+#include <QSet>
 #include <QUndoStack>
 #include <QRubberBand>
 #include <functional>
@@ -35,6 +38,11 @@
 #include "indicator.h"
 #include "itemgroup.h"
 #include "selectionband.h"
+#include "spatialindex.h"
+#include "colorpalette.h"
+#include "cellindex.h"
+#include "clipboarddata.h"
+#include "snapengine.h"
 
 #define SCENE_CLAMP_BORDER_SIZE 50
 
@@ -103,6 +111,7 @@ QDebug operator<<(QDebug d, IndicatorProperties & properties);
 Q_DECLARE_METATYPE(IndicatorProperties)
 
 class QKeyEvent;
+class ChartLayout;
 
 class Scene : public QGraphicsScene
 {
@@ -159,6 +168,135 @@ public:
 	//returns the first selectable item that intersects with the given position
 	QGraphicsItem* selectableItemAt(const QPointF& pos);
 
+    /**
+     * The selected items kept up to date as items are (de)selected,
+     * unlike selectedItems() which builds a new list on every call.
+     */
+    const QSet<QGraphicsItem*>& selection() const { return mSelection; }
+    int selectionCount() const { return mSelection.count(); }
+    bool isInSelection(QGraphicsItem* item) const { return mSelection.contains(item); }
+
+    /**
+     * (De)select all the items and emit selectionChanged() once when done.
+     */
+    void setSelected(const QList<QGraphicsItem*>& items, bool selected);
+
+    /**
+     * Called from the items' itemChange() to keep the selection and the spatial index
+     * of the scene they're in current.
+     */
+    static void trackItemChange(QGraphicsItem* item, QGraphicsItem::GraphicsItemChange change, const QVariant& value);
+
+    /**
+     * Tell the scene the item changed size, transformation or layer in a way
+     * itemChange() doesn't report.
+     */
+    static void trackGeometryChange(QGraphicsItem* item);
+
+    /**
+     * Move the item to its new layer right away so it shows and hides with it.
+     */
+    static void trackLayerChange(QGraphicsItem* item);
+
+    /**
+     * The top level chart items indexed by layer and position.
+     */
+    const SpatialIndex& spatialIndex();
+
+    /**
+     * Tell the scene a cell changed from one stitch or color to another, old is empty
+     * if it didn't have one yet. The changes are counted up and sent out together
+     * with stitchesChanged() and colorsChanged() once control returns to the event loop.
+     */
+    static void trackStitchChange(QGraphicsItem* item, const QString& oldStitch, const QString& newStitch);
+    static void trackColorChange(QGraphicsItem* item, const QString& oldColor, const QString& newColor);
+
+    /**
+     * The palette the cell colors are kept in, or ColorPalette::loose() if
+     * scene isn't a Scene.
+     */
+    static ColorPalette* colorPalette(QGraphicsScene* scene);
+
+    /**
+     * Tell the scene the cell's stitch or colors changed so it's filed under the new ones.
+     */
+    static void trackCellChange(Cell* cell);
+
+    /**
+     * The cells with the stitch or color, found without scanning the scene.
+     * A cell that matches on both its foreground and background is only listed once.
+     */
+    QList<Cell*> cellsWithStitch(const QString& stitch);
+    QList<Cell*> cellsWithColor(const QColor& color, bool foreground, bool background);
+
+    /**
+     * Select every selectable cell with the stitch or foreground color, replacing the current selection.
+     */
+    void selectCellsWithStitch(const QString& stitch);
+    void selectCellsWithColor(const QColor& color);
+
+    ColorPalette* cellPalette() { return &mPalette; }
+
+    /**
+     * Change the color of a palette entry, every cell using the entry changes with it.
+     * The colorway is given by its id, see ColorPalette::colorwayId().
+     */
+    void setPaletteColor(int index, QColor color);
+    void setPaletteColor(int colorwayId, int index, QColor color);
+
+    /**
+     * Switch, add and remove the colorways of the palette. Only the palette
+     * changes, the cells using the entries that changed color are drawn again.
+     */
+    void setCurrentColorway(int colorway);
+    int addColorway(const QString& name);
+    void removeColorway(int colorway);
+    void insertColorway(int colorway, int id, const QString& name, const QVector<QRgb>& colors);
+
+    /**
+     * Add, remove and rename colorways with undo commands, a new colorway is made the current one.
+     */
+    void addColorwayUndoable(const QString& name);
+    void removeColorwayUndoable(int colorway);
+    void setColorwayNameUndoable(int colorway, const QString& name);
+
+    /**
+     * Tell the scene something about the item's appearance changed, so the cached
+     * drawing of its layer is out of date if the layer isn't the current one.
+     */
+    static void trackPaintChange(QGraphicsItem* item);
+
+    /**
+     * Returns true when the view painting onto widget draws the item itself, from the
+     * cache of its layer or beneath it, so the item shouldn't paint itself there.
+     */
+    static bool isDrawnFromLayerCache(QGraphicsItem* item, unsigned int layer, const QWidget* widget);
+
+    /**
+     * The view that draws the items of the layers other than the current one from a
+     * cached image instead of item by item, 0 for none. Every other view, exports and
+     * the cache itself draw all the items.
+     */
+    void setLayerCacheView(QGraphicsView* view);
+    QGraphicsView* layerCacheView() const { return mLayerCacheView; }
+    bool layerCacheEnabled() const { return !mLayerCacheView.isNull(); }
+
+    /**
+     * Changes every time something in the cached layers changes.
+     */
+    quint64 layerCacheVersion();
+
+    /**
+     * Draw the visible items of the layers other than the current one that are in rect.
+     * Returns the number of items drawn.
+     */
+    int drawInactiveLayers(QPainter* painter, const QRectF& rect);
+    /**
+     * Draw the visible items of every layer that are in rect and stacked below the cells,
+     * the layer cache view draws these before the cache. Returns the number of items drawn.
+     */
+    int drawBelowLayerCache(QPainter* painter, const QRectF& rect);
+
     void setEditMode(EditMode mode);
     EditMode editMode() { return mMode; }
 
@@ -170,6 +308,9 @@ public:
     void setEditFgColor(QColor color) { mEditFgColor = color; }
     void setEditBgColor(QColor color) { mEditBgColor = color; }
 
+    /**
+     * The undo stack keeps its commands within the undoMemoryLimit, see UndoMemory::forStack().
+     */
     QUndoStack* undoStack() { return &mUndoStack; }
     
     QStringList modes();
@@ -192,6 +333,13 @@ public:
     void mirror(int direction);
 	void copy(int direction);
     void rotate(qreal degrees);
+    /**
+     * Make copies of the selection, each one turned by degrees around the chart
+     * center and moved by step more than the one before it. Without a chart
+     * center the copies turn around the middle of the selection.
+     * All the copies are added with one undo command.
+     */
+    void replicate(int copies, qreal degrees, QPointF step);
 	void resizeScene(QRectF sceneRect);
 
     void group();
@@ -203,11 +351,28 @@ public:
     void addItem(QGraphicsItem *item);
     void removeItem(QGraphicsItem *item);
 
+    /**
+     * Remove many items in one pass over the grid and the item lists.
+     * The grid position (column, row) of each item, or (-1, -1), is put in positions
+     * and the rows that were dropped because they were left empty in emptiedRows.
+     */
+    void removeItems(const QList<QGraphicsItem*>& items, QVector<QPoint>* positions = 0, QList<int>* emptiedRows = 0);
+
+    /**
+     * Add back items taken out by removeItems() at the same grid positions.
+     */
+    void restoreItems(const QList<QGraphicsItem*>& items, const QVector<QPoint>& positions, const QList<int>& emptiedRows);
+
 	//returns the current layer and creates a new layer if no layer is currently selected
 	ChartLayer* getCurrentLayer();
 	//returns the layer with the given id or creates a new one with that id if none exists yet
 	ChartLayer* getLayer(int uid);
 
+	/**
+	 * The top level items in the layer.
+	 */
+	QList<QGraphicsItem*> layerItems(unsigned int uid);
+
     /**
      * Add a row of stitches to the grid.
      * If append == false, use the rowPos to insert the row into the grid.
@@ -231,13 +396,20 @@ public:
 	 * Snap to grid functions
 	 */
 	QPointF snapPositionToGrid(const QPointF& pos) const;
-	QPointF snapPositionToRows(const QPointF& pos) const;
-	QPointF snapPositionToRounds(const QPointF& pos) const;
-	QPointF snapPositionToTriangles(const QPointF& pos) const;
 	void snapGraphicsItemToGrid(QGraphicsItem& item);
+	/**
+	 * Snap all the positions or items in one pass.
+	 * Without guidelines stitches are lined up with the stitches around them.
+	 */
+	void snapPositionsToGrid(QVector<QPointF>& positions) const;
+	void snapItemsToGrid(const QList<QGraphicsItem*>& items);
 	
 public slots:    
 	void showProperties();
+    /**
+     * Send out the stitch and color changes collected so far.
+     */
+    void sendCellChanges();
     void copy();
     void cut();
     void paste();
@@ -245,8 +417,11 @@ public slots:
     void deleteSelection();
     
 protected:
-    void copyRecursively(QDataStream &stream, QList<QGraphicsItem*> items);
-    void pasteRecursively(QDataStream &stream, QList<QGraphicsItem*> *group);
+    void copyRecursively(QList<ClipboardItem> &copied, QList<QGraphicsItem*> items);
+    /**
+     * Create the copied item and its children without adding them to the scene.
+     */
+    QGraphicsItem* pasteRecursively(const ClipboardItem &copy, unsigned int layer);
 
     /**
      * This function removes a cell from the 'grid'. if the row is empty it removes the row too.
@@ -301,8 +476,11 @@ public slots:
     
 signals:
 	void showPropertiesSignal();
-    void stitchChanged(QString oldSt, QString newSt);
-    void colorChanged(QString oldColor, QString newColor);
+    /**
+     * How many more or fewer cells use each stitch or color than when the signal was last sent.
+     */
+    void stitchesChanged(QMap<QString, int> changes);
+    void colorsChanged(QMap<QString, int> changes);
 	void layersChanged(QList<ChartLayer*>& layers, ChartLayer* selected);
 
     void rowSelected();
@@ -311,6 +489,10 @@ signals:
     void rowEdited(bool state);
 
     void guidelinesUpdated(Guidelines guidelines);
+    /**
+     * The background of rect has to be drawn again, changed() doesn't report invalidate().
+     */
+    void backgroundChanged(const QRectF& rect);
     
 protected:
 //    virtual void    helpEvent ( QGraphicsSceneHelpEvent * helpEvent )
@@ -471,6 +653,54 @@ private:
     bool mMoving;
     bool mIsRubberband;
     bool mHasSelection;
+
+    QSet<QGraphicsItem*> mSelection;
+
+    //the stitch and color changes waiting for sendCellChanges().
+    QMap<QString, int> mStitchChanges;
+    QMap<QString, int> mColorChanges;
+    bool mCellChangesPending;
+    void queueCellChanges();
+    //count the stitch and colors of a cell joining (1) or leaving (-1) the scene.
+    void countCell(Cell* cell, int count);
+
+    ColorPalette mPalette;
+    CellIndex mCellIndex;
+    void selectCells(const QList<Cell*>& cells);
+    //redraw and recount the cells using the entries whose color isn't the old one anymore.
+    void paletteChanged(const QHash<int, QRgb>& oldColors);
+
+    SpatialIndex mIndex;
+    //items whose entry in the index has to be updated before the next query.
+    QSet<QGraphicsItem*> mIndexDirty;
+    void updateSpatialIndex();
+
+    //set the visibility and selectability of a top level item from its layer.
+    void applyLayerState(QGraphicsItem* item, ChartLayer* layer);
+    //push the commands moving the item, and the items grouped in it, to the layer.
+    void setItemLayerUndoable(QGraphicsItem* item, unsigned int layer);
+
+    //true if the items in the layer are drawn from the layer cache.
+    bool isLayerCached(int layer) const;
+
+    QPointer<QGraphicsView> mLayerCacheView;
+    quint64 mLayerCacheVersion;
+    //the indexed items stacked below the cells, see drawBelowLayerCache().
+    QSet<QGraphicsItem*> mBelowCells;
+
+    //true if a gesture on the items is big enough to drag a picture of them instead.
+    bool needsDragProxy(const QList<QGraphicsItem*>& items) const;
+    //hide the items behind a single picture of them that the gesture can transform.
+    void beginDragProxy(const QList<QGraphicsItem*>& items);
+    //remove the picture and show the items again.
+    void endDragProxy();
+
+    QGraphicsItem* mDragProxy;
+    //the items hidden by the drag proxy and the opacity to give back to them.
+    QHash<QGraphicsItem*, qreal> mDragProxyItems;
+    //what the gesture sets on the items once the mouse is released.
+    qreal mDragAngle;
+    QPointF mDragScale;
     bool mSnapTo;
 	//true if multiple items are being edited at the same time 
 	bool mMultiEdit;
@@ -545,7 +775,6 @@ public:
     bool showChartCenter();
 
     void createRoundsChart(int rows, int cols, QString stitch, QSizeF rowSize, int increaseBy);
-    void createRow(int row, int columns, QString stitch);
 
     /**
      * Does the chart have a symbol at all?
@@ -558,11 +787,11 @@ public slots:
 	void setSnapAngle(bool state);
 public:
 	bool snapAngle() const { return mSnapAngle; };
-protected:
-    void setCellPosition(int row, int column, Cell *c, int columns);
-    
 private:
-    QPointF calcPoint(double radius, double angleInDegrees, QPointF origin);
+    /**
+     * The cells of the layout, one list per row, set up but not in the scene yet.
+     */
+    QList<QList<Cell*> > createCells(const ChartLayout& layout, Stitch* stitch);
 
     QGraphicsItem *mCenterSymbol;
     bool mShowChartCenter;
@@ -583,6 +812,13 @@ public:
      */
     void replaceColor(QColor original, QColor replacement, int selection);
 
+private:
+    /**
+     * The palette entries with the color, or none if a cell uses one of them
+     * for a color that isn't being changed (foreground or background).
+     */
+    QList<int> paletteEntries(QColor color, bool foreground, bool background);
+
 protected slots:
     /**
      * @brief updateGuidelines - draw the guidelines
@@ -595,14 +831,23 @@ private:
 	void generateGuidelinesTriangles(int spacingW, int spacingH, int columns, int rows, QPointF center);
 
     /**
-     * @brief mGuidelinesLines - Hold all the lines that make up the grid
+     * @brief mGuidelinesPath - All the lines that make up the grid, drawn by drawBackground.
+     * It's only rebuilt when the guidelines or the chart center change.
      */
-    QList<QGraphicsItem*> mGuidelinesLines;
+    QPainterPath mGuidelinesPath;
 
     /**
      * @brief mGuidelines - Hold the settings that are used to generate a grid background
      */
     Guidelines mGuidelines;
+
+    /**
+     * @brief mSnapEngine - The guidelines ready for snapping, compiled by updateGuidelines.
+     */
+    SnapEngine mSnapEngine;
+
+    //where the center symbol is, the origin when there isn't one.
+    QPointF centerPos() const;
 };
 
 #endif //SCENE_H
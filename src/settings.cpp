@@ -95,6 +95,7 @@ void Settings::setupValueList() {
 
     mValueList["maxRecentFiles"] = QVariant(5);
     mValueList["recentFiles"] = QVariant(QStringList());
+    mValueList["undoMemoryLimit"] = QVariant(64); //MB per document, 0 for no limit.
     
     mValueList["geometry"] = QVariant("");
     mValueList["windowState"] = QVariant(" "); //use a space because it works for the comparison when saving variables.
@@ -124,6 +125,7 @@ void Settings::setupValueList() {
 	//tools options
 	mValueList["replaceStitchWithPress"] = QVariant(true);
     mValueList["centerNewStitchOnMouse"] = QVariant(true);
+    mValueList["snapToStitches"] = QVariant(true); //line stitches up with their neighbors on charts without guidelines.
     mValueList["pasteOnMouseLocation"] = QVariant(true);
 	mValueList["rotateAroundCenter"] = QVariant(true);
 	mValueList["scaleAroundCenter"] = QVariant(true);
@@ -0,0 +1,218 @@
+/****************************************************************************\
+ Copyright (c) 2011-2014 Stitch Works Software
+ Brian C. Milco <bcmilco@gmail.com>
+
+ This file is part of Crochet Charts.
+
+ Crochet Charts is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ Crochet Charts is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with Crochet Charts. If not, see <http://www.gnu.org/licenses/>.
+
+ \****************************************************************************/
+#include "snapengine.h"
+
+#include "scene.h"
+#include "cell.h"
+#include "spatialindex.h"
+
+#include <QSet>
+#include <QRectF>
+#include <QtAlgorithms>
+#include <QDebug>
+#include <math.h>
+
+SnapEngine::SnapEngine()
+    : mMode(None),
+      mRows(0),
+      mColumns(0),
+      mCellWidth(0),
+      mCellHeight(0),
+      mColumnAngle(0),
+      mStitchDistance(8)
+{
+}
+
+void SnapEngine::compile(const Guidelines& guidelines)
+{
+    mRows = guidelines.rows();
+    mColumns = guidelines.columns();
+    mCellWidth = guidelines.cellWidth();
+    mCellHeight = guidelines.cellHeight();
+    mRingStarts.clear();
+    mDirections.clear();
+    mColumnAngle = 0;
+
+    QString type = guidelines.type();
+    if(type == "Rows")
+        mMode = Rows;
+    else if(type == "Rounds")
+        mMode = Rounds;
+    else if(type == "Triangles")
+        mMode = Triangles;
+    else
+        mMode = None;
+
+    if(mMode == None)
+        return;
+
+    if(mCellWidth <= 0 || mCellHeight <= 0 || (mMode == Rounds && mColumns <= 0)) {
+        qWarning() << "SnapEngine: can't snap to guidelines" << type << mColumns << mCellWidth << mCellHeight;
+        mMode = None;
+        return;
+    }
+
+    if(mMode != Rounds)
+        return;
+
+    //a position is in ring k once it's half a ring short of k rings from the center.
+    for(int ring = 1; ring <= mRows + 1; ++ring) {
+        qreal start = ring * mCellHeight - mCellHeight/2;
+        mRingStarts.append(start * start);
+    }
+
+    //columns are counted from straight below the center.
+    mColumnAngle = M_PI * 2 / mColumns;
+    for(int c = 0; c <= mColumns; ++c) {
+        qreal angle = c * mColumnAngle + M_PI_2;
+        mDirections.append(QPointF(cos(angle), sin(angle)));
+    }
+}
+
+QPointF SnapEngine::snap(const QPointF& pos, const QPointF& center) const
+{
+    switch(mMode) {
+        case Rows:
+            return snapToRows(pos - center) + center;
+        case Rounds:
+            return snapToRounds(pos - center) + center;
+        case Triangles:
+            return snapToTriangles(pos - center) + center;
+        default:
+            return pos;
+    }
+}
+
+void SnapEngine::snap(QVector<QPointF>& positions, const QPointF& center) const
+{
+    QPointF* p = positions.data();
+    QPointF* end = p + positions.count();
+
+    switch(mMode) {
+        case Rows:
+            for(; p != end; ++p)
+                *p = snapToRows(*p - center) + center;
+            break;
+        case Rounds:
+            for(; p != end; ++p)
+                *p = snapToRounds(*p - center) + center;
+            break;
+        case Triangles:
+            for(; p != end; ++p)
+                *p = snapToTriangles(*p - center) + center;
+            break;
+        default:
+            break;
+    }
+}
+
+QPointF SnapEngine::snapToRows(const QPointF& relPos) const
+{
+    int x = (relPos.x() + mCellWidth/2) / mCellWidth;
+    int y = (relPos.y() + mCellHeight/2) / mCellHeight;
+
+    x = qMax(0, qMin(mColumns, x));
+    y = qMax(0, qMin(mRows, y));
+
+    return QPointF(x * mCellWidth, y * mCellHeight);
+}
+
+QPointF SnapEngine::snapToRounds(const QPointF& relPos) const
+{
+    //find the ring from the squared distance so there's no square root.
+    qreal distance = relPos.x()*relPos.x() + relPos.y()*relPos.y();
+    int ring = qUpperBound(mRingStarts.constBegin(), mRingStarts.constEnd(), distance) - mRingStarts.constBegin();
+    qreal radius = ring * mCellHeight;
+
+    //atan2 gives -PI to PI, turned a quarter that's always within one turn of 0.
+    qreal angle = atan2(relPos.y(), relPos.x()) - M_PI_2;
+    if(angle < 0)
+        angle += M_PI * 2;
+
+    int column = angle / mColumnAngle + 0.5;
+    column = qMax(0, qMin(mColumns, column));
+
+    return mDirections.at(column) * radius;
+}
+
+QPointF SnapEngine::snapToTriangles(const QPointF& relPos) const
+{
+    int row = relPos.y() / mCellHeight + 0.5;
+    row = qMax(0, qMin(mRows, row));
+
+    //the left most position of the row.
+    qreal offsetX = row * mCellWidth/2;
+
+    int column = (relPos.x() - offsetX) / mCellWidth - 0.5;
+    column = qMax(-row, qMin(0, column));
+
+    return QPointF(column * mCellWidth + offsetX, row * mCellHeight);
+}
+
+QPointF SnapEngine::stitchOffset(const QList<QGraphicsItem*>& items, const SpatialIndex& index) const
+{
+    if(mStitchDistance <= 0 || items.isEmpty())
+        return QPointF();
+
+    QSet<QGraphicsItem*> moving;
+    QRectF bounds;
+    foreach(QGraphicsItem* item, items) {
+        moving.insert(item);
+        bounds = bounds.united(item->sceneBoundingRect());
+    }
+
+    qreal bestX = mStitchDistance;
+    qreal bestY = mStitchDistance;
+    QPointF offset;
+
+    foreach(QGraphicsItem* item, items) {
+        if(item->type() != Cell::Type)
+            continue;
+
+        //look one stitch out on every side.
+        QRectF rect = item->sceneBoundingRect();
+        QRectF area = rect.adjusted(-rect.width(), -rect.height(), rect.width(), rect.height());
+
+        //only stitches on the outside of the list have other stitches around them.
+        if(bounds.contains(area))
+            continue;
+
+        Cell* c = qgraphicsitem_cast<Cell*>(item);
+        QPointF center = rect.center();
+
+        foreach(QGraphicsItem* other, index.items(area, c->layer())) {
+            if(other->type() != Cell::Type || moving.contains(other))
+                continue;
+
+            QPointF diff = index.rect(other).center() - center;
+            if(qAbs(diff.x()) <= bestX) {
+                bestX = qAbs(diff.x());
+                offset.setX(diff.x());
+            }
+            if(qAbs(diff.y()) <= bestY) {
+                bestY = qAbs(diff.y());
+                offset.setY(diff.y());
+            }
+        }
+    }
+
+    return offset;
+}
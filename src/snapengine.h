@@ -0,0 +1,91 @@
+/****************************************************************************\
+ Copyright (c) 2011-2014 Stitch Works Software
+ Brian C. Milco <bcmilco@gmail.com>
+
+ This file is part of Crochet Charts.
+
+ Crochet Charts is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ Crochet Charts is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with Crochet Charts. If not, see <http://www.gnu.org/licenses/>.
+
+ \****************************************************************************/
+#ifndef SNAPENGINE_H
+#define SNAPENGINE_H
+
+#include <QPointF>
+#include <QVector>
+#include <QList>
+
+class Guidelines;
+class SpatialIndex;
+class QGraphicsItem;
+
+/**
+ * Snaps positions to the guidelines of a chart.
+ *
+ * Everything the snapping needs is worked out by compile() when the guidelines
+ * change, so snapping a point is only a little arithmetic. Rounds keep a table of
+ * the ring radii and of the direction of every column around the center.
+ *
+ * Charts without guidelines can snap stitches to the stitches around them instead.
+ */
+class SnapEngine
+{
+public:
+    enum Mode { None, Rows, Rounds, Triangles };
+
+    SnapEngine();
+
+    void compile(const Guidelines& guidelines);
+
+    Mode mode() const { return mMode; }
+
+    /**
+     * Positions are in scene coordinates, center is the center of the chart.
+     */
+    QPointF snap(const QPointF& pos, const QPointF& center) const;
+    void snap(QVector<QPointF>& positions, const QPointF& center) const;
+
+    /**
+     * How far stitches are moved to line up with the stitches next to them, 0 to turn it off.
+     */
+    qreal stitchDistance() const { return mStitchDistance; }
+    void setStitchDistance(qreal distance) { mStitchDistance = distance; }
+
+    /**
+     * The move that lines the stitches up with the closest stitches around them
+     * that aren't in the list. The whole list is moved together so it keeps its shape.
+     */
+    QPointF stitchOffset(const QList<QGraphicsItem*>& items, const SpatialIndex& index) const;
+
+private:
+    QPointF snapToRows(const QPointF& relPos) const;
+    QPointF snapToRounds(const QPointF& relPos) const;
+    QPointF snapToTriangles(const QPointF& relPos) const;
+
+    Mode mMode;
+
+    int mRows;
+    int mColumns;
+    int mCellWidth;
+    int mCellHeight;
+
+    //the squared distance from the center each ring starts at, ring 1 first.
+    QVector<qreal> mRingStarts;
+    qreal mColumnAngle;
+    //the snapped direction of each column, the last one is the same as the first.
+    QVector<QPointF> mDirections;
+
+    qreal mStitchDistance;
+};
+
+#endif // SNAPENGINE_H
@@ -0,0 +1,495 @@
+/****************************************************************************\
+ Copyright (c) 2011-2014 Stitch Works Software
+ Brian C. Milco <bcmilco@gmail.com>
+
+ This file is part of Crochet Charts.
+
+ Crochet Charts is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ Crochet Charts is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with Crochet Charts. If not, see <http://www.gnu.org/licenses/>.
+
+ \****************************************************************************/
+#include "spatialindex.h"
+
+#include <QGraphicsItem>
+#include <QRect>
+#include <QtAlgorithms>
+
+#include <math.h>
+
+//items covering more grid squares than this are kept in the layer's large list.
+#define SPATIALINDEX_MAX_ITEM_CELLS 256
+
+static qreal distanceToRect(const QPointF& pos, const QRectF& rect)
+{
+    qreal dx = 0, dy = 0;
+    if(pos.x() < rect.left())
+        dx = rect.left() - pos.x();
+    else if(pos.x() > rect.right())
+        dx = pos.x() - rect.right();
+
+    if(pos.y() < rect.top())
+        dy = rect.top() - pos.y();
+    else if(pos.y() > rect.bottom())
+        dy = pos.y() - rect.bottom();
+
+    return sqrt(dx * dx + dy * dy);
+}
+
+SpatialIndex::SpatialIndex(qreal cellSize)
+    : mCellSize(cellSize),
+    mBoundsDirty(false),
+    mNextOrder(0),
+    mQuery(0)
+{
+    if(mCellSize <= 0)
+        mCellSize = 64;
+}
+
+SpatialIndex::~SpatialIndex()
+{
+    clear();
+}
+
+quint64 SpatialIndex::key(int x, int y)
+{
+    return (quint64(quint32(x)) << 32) | quint32(y);
+}
+
+QRect SpatialIndex::cellRange(const QRectF& rect) const
+{
+    QRectF r = rect.normalized();
+    int left = (int)floor(r.left() / mCellSize);
+    int top = (int)floor(r.top() / mCellSize);
+    int right = (int)floor(r.right() / mCellSize);
+    int bottom = (int)floor(r.bottom() / mCellSize);
+
+    return QRect(QPoint(left, top), QPoint(right, bottom));
+}
+
+void SpatialIndex::insert(QGraphicsItem* item, const QRectF& rect, int layer)
+{
+    if(!item)
+        return;
+
+    Entry* e = mEntries.value(item);
+    if(e) {
+        if(e->rect == rect && e->layer == layer)
+            return;
+        removeFromGrid(e);
+        if(touchesBounds(e->rect))
+            mBoundsDirty = true;
+    } else {
+        e = new Entry;
+        e->item = item;
+        e->order = mNextOrder++;
+        e->visited = 0;
+        mEntries.insert(item, e);
+    }
+
+    e->rect = rect;
+    e->layer = layer;
+    addToGrid(e);
+    growBounds(rect);
+}
+
+void SpatialIndex::remove(QGraphicsItem* item)
+{
+    Entry* e = mEntries.take(item);
+    if(!e)
+        return;
+
+    removeFromGrid(e);
+    if(touchesBounds(e->rect))
+        mBoundsDirty = true;
+    delete e;
+}
+
+void SpatialIndex::clear()
+{
+    qDeleteAll(mEntries);
+    mEntries.clear();
+    mGrids.clear();
+    mBounds = QRectF();
+    mBoundsDirty = false;
+}
+
+bool SpatialIndex::touchesBounds(const QRectF& rect) const
+{
+    return rect.left() <= mBounds.left() || rect.right() >= mBounds.right() ||
+           rect.top() <= mBounds.top() || rect.bottom() >= mBounds.bottom();
+}
+
+void SpatialIndex::growBounds(const QRectF& rect)
+{
+    //a dirty rect is worked out from scratch anyway.
+    if(mBoundsDirty)
+        return;
+
+    if(mEntries.count() == 1)
+        mBounds = rect;
+    else
+        mBounds = mBounds.united(rect);
+}
+
+QRectF SpatialIndex::bounds() const
+{
+    if(mBoundsDirty) {
+        mBounds = QRectF();
+        bool first = true;
+        foreach(Entry* e, mEntries) {
+            mBounds = first ? e->rect : mBounds.united(e->rect);
+            first = false;
+        }
+        mBoundsDirty = false;
+    }
+
+    return mBounds;
+}
+
+QRectF SpatialIndex::rect(QGraphicsItem* item) const
+{
+    Entry* e = mEntries.value(item);
+    if(!e)
+        return QRectF();
+    return e->rect;
+}
+
+int SpatialIndex::layer(QGraphicsItem* item) const
+{
+    Entry* e = mEntries.value(item);
+    if(!e)
+        return NoLayer;
+    return e->layer;
+}
+
+QList<QGraphicsItem*> SpatialIndex::layerItems(int layer) const
+{
+    QList<QGraphicsItem*> list;
+
+    QHash<int, Grid>::const_iterator g = mGrids.find(layer);
+    if(g == mGrids.constEnd())
+        return list;
+
+    list.reserve(g.value().members.count());
+    foreach(Entry* e, g.value().members)
+        list.append(e->item);
+    return list;
+}
+
+void SpatialIndex::addToGrid(Entry* e)
+{
+    Grid& grid = mGrids[e->layer];
+    grid.members.insert(e);
+    QRect range = cellRange(e->rect);
+
+    e->large = (qint64)range.width() * range.height() > SPATIALINDEX_MAX_ITEM_CELLS;
+    if(e->large) {
+        grid.large.append(e);
+        return;
+    }
+
+    if(grid.maxX < grid.minX) {
+        grid.minX = range.left();
+        grid.minY = range.top();
+        grid.maxX = range.right();
+        grid.maxY = range.bottom();
+    } else {
+        grid.minX = qMin(grid.minX, range.left());
+        grid.minY = qMin(grid.minY, range.top());
+        grid.maxX = qMax(grid.maxX, range.right());
+        grid.maxY = qMax(grid.maxY, range.bottom());
+    }
+
+    for(int y = range.top(); y <= range.bottom(); ++y) {
+        for(int x = range.left(); x <= range.right(); ++x)
+            grid.cells[key(x, y)].append(e);
+    }
+}
+
+void SpatialIndex::removeFromGrid(Entry* e)
+{
+    QHash<int, Grid>::iterator g = mGrids.find(e->layer);
+    if(g == mGrids.end())
+        return;
+
+    Grid& grid = g.value();
+    grid.members.remove(e);
+    if(e->large) {
+        grid.large.removeOne(e);
+        return;
+    }
+
+    QRect range = cellRange(e->rect);
+    for(int y = range.top(); y <= range.bottom(); ++y) {
+        for(int x = range.left(); x <= range.right(); ++x) {
+            QHash<quint64, QList<Entry*> >::iterator c = grid.cells.find(key(x, y));
+            if(c == grid.cells.end())
+                continue;
+            c.value().removeOne(e);
+            if(c.value().isEmpty())
+                grid.cells.erase(c);
+        }
+    }
+}
+
+QList<const SpatialIndex::Grid*> SpatialIndex::grids(int layer) const
+{
+    QList<const Grid*> list;
+
+    if(layer == AllLayers) {
+        for(QHash<int, Grid>::const_iterator i = mGrids.constBegin(); i != mGrids.constEnd(); ++i)
+            list.append(&i.value());
+        return list;
+    }
+
+    QHash<int, Grid>::const_iterator i = mGrids.find(layer);
+    if(i != mGrids.constEnd())
+        list.append(&i.value());
+
+    if(layer != NoLayer) {
+        i = mGrids.find(NoLayer);
+        if(i != mGrids.constEnd())
+            list.append(&i.value());
+    }
+
+    return list;
+}
+
+bool SpatialIndex::isSelectable(const Entry* e)
+{
+    return (e->item->flags() & QGraphicsItem::ItemIsSelectable) == QGraphicsItem::ItemIsSelectable;
+}
+
+QList<SpatialIndex::Entry*> SpatialIndex::candidates(const QRectF& rect, int layer, bool selectableOnly) const
+{
+    QList<Entry*> found;
+    quint32 query = ++mQuery;
+
+    QRect range = cellRange(rect);
+
+    foreach(const Grid* grid, grids(layer)) {
+        foreach(Entry* e, grid->large) {
+            if(selectableOnly && !isSelectable(e))
+                continue;
+            found.append(e);
+        }
+
+        //only look at the squares that can have something in them.
+        QRect r = range.intersected(QRect(QPoint(grid->minX, grid->minY), QPoint(grid->maxX, grid->maxY)));
+        if(r.isEmpty())
+            continue;
+
+        //when the area is bigger than the number of used squares walk the used squares instead.
+        if((qint64)r.width() * r.height() > grid->cells.count()) {
+            for(QHash<quint64, QList<Entry*> >::const_iterator c = grid->cells.constBegin();
+                    c != grid->cells.constEnd(); ++c) {
+                int x = (int)(quint32)(c.key() >> 32);
+                int y = (int)(quint32)(c.key() & 0xffffffff);
+                if(!r.contains(x, y))
+                    continue;
+                foreach(Entry* e, c.value()) {
+                    if(e->visited == query)
+                        continue;
+                    e->visited = query;
+                    if(selectableOnly && !isSelectable(e))
+                        continue;
+                    found.append(e);
+                }
+            }
+            continue;
+        }
+
+        for(int y = r.top(); y <= r.bottom(); ++y) {
+            for(int x = r.left(); x <= r.right(); ++x) {
+                QHash<quint64, QList<Entry*> >::const_iterator c = grid->cells.find(key(x, y));
+                if(c == grid->cells.constEnd())
+                    continue;
+                foreach(Entry* e, c.value()) {
+                    if(e->visited == query)
+                        continue;
+                    e->visited = query;
+                    if(selectableOnly && !isSelectable(e))
+                        continue;
+                    found.append(e);
+                }
+            }
+        }
+    }
+
+    return found;
+}
+
+bool SpatialIndex::isAbove(const Entry* a, const Entry* b)
+{
+    qreal za = a->item->zValue();
+    qreal zb = b->item->zValue();
+    if(za != zb)
+        return za > zb;
+    //like the scene, items added later are drawn on top of earlier ones.
+    return a->order > b->order;
+}
+
+void SpatialIndex::sortTopmostFirst(QList<Entry*>& entries)
+{
+    qSort(entries.begin(), entries.end(), isAbove);
+}
+
+QList<QGraphicsItem*> SpatialIndex::toItems(const QList<Entry*>& entries)
+{
+    QList<QGraphicsItem*> list;
+    list.reserve(entries.count());
+    foreach(Entry* e, entries)
+        list.append(e->item);
+    return list;
+}
+
+QList<QGraphicsItem*> SpatialIndex::items(const QPointF& pos, int layer, bool selectableOnly) const
+{
+    QList<Entry*> found;
+    foreach(Entry* e, candidates(QRectF(pos, QSizeF(0, 0)), layer, selectableOnly)) {
+        if(e->rect.contains(pos))
+            found.append(e);
+    }
+
+    sortTopmostFirst(found);
+    return toItems(found);
+}
+
+QList<QGraphicsItem*> SpatialIndex::items(const QRectF& rect, int layer, bool selectableOnly) const
+{
+    QList<Entry*> found;
+    foreach(Entry* e, candidates(rect, layer, selectableOnly)) {
+        if(e->rect.intersects(rect))
+            found.append(e);
+    }
+
+    sortTopmostFirst(found);
+    return toItems(found);
+}
+
+QList<QGraphicsItem*> SpatialIndex::items(const QPainterPath& path, Qt::ItemSelectionMode mode,
+                                          int layer, bool selectableOnly) const
+{
+    QRectF bounds = path.controlPointRect();
+
+    QList<Entry*> found;
+    foreach(Entry* e, candidates(bounds, layer, selectableOnly)) {
+        if(!e->rect.intersects(bounds))
+            continue;
+
+        //the items are top level so scene and parent coordinates are the same.
+        if(e->item->collidesWithPath(e->item->mapFromScene(path), mode))
+            found.append(e);
+    }
+
+    sortTopmostFirst(found);
+    return toItems(found);
+}
+
+QGraphicsItem* SpatialIndex::itemAt(const QPointF& pos, int layer, bool selectableOnly) const
+{
+    Entry* top = 0;
+    foreach(Entry* e, candidates(QRectF(pos, QSizeF(0, 0)), layer, selectableOnly)) {
+        if(!e->rect.contains(pos))
+            continue;
+        //only the stacking of items that are under pos themselves matters, not just their rect.
+        if(top && !isAbove(e, top))
+            continue;
+        if(!e->item->shape().contains(e->item->mapFromScene(pos)))
+            continue;
+        top = e;
+    }
+
+    return top ? top->item : 0;
+}
+
+QList<QGraphicsItem*> SpatialIndex::nearest(const QPointF& pos, int k, int layer, bool selectableOnly) const
+{
+    QList<QGraphicsItem*> list;
+    if(k <= 0)
+        return list;
+
+    QList<const Grid*> searched = grids(layer);
+    if(searched.isEmpty())
+        return list;
+
+    quint32 query = ++mQuery;
+    QList<QPair<qreal, Entry*> > found;
+
+    //how far the search can go before it's past every used square.
+    int minX = 0, minY = 0, maxX = -1, maxY = -1;
+    foreach(const Grid* grid, searched) {
+        foreach(Entry* e, grid->large) {
+            if(selectableOnly && !isSelectable(e))
+                continue;
+            found.append(qMakePair(distanceToRect(pos, e->rect), e));
+        }
+
+        if(grid->maxX < grid->minX)
+            continue;
+        if(maxX < minX) {
+            minX = grid->minX; minY = grid->minY;
+            maxX = grid->maxX; maxY = grid->maxY;
+        } else {
+            minX = qMin(minX, grid->minX); minY = qMin(minY, grid->minY);
+            maxX = qMax(maxX, grid->maxX); maxY = qMax(maxY, grid->maxY);
+        }
+    }
+
+    int cx = (int)floor(pos.x() / mCellSize);
+    int cy = (int)floor(pos.y() / mCellSize);
+
+    int maxRing = 0;
+    if(maxX >= minX)
+        maxRing = qMax(qMax(qAbs(cx - minX), qAbs(maxX - cx)), qMax(qAbs(cy - minY), qAbs(maxY - cy)));
+
+    for(int ring = 0; maxX >= minX && ring <= maxRing; ++ring) {
+        for(int y = cy - ring; y <= cy + ring; ++y) {
+            bool edgeRow = (y == cy - ring || y == cy + ring);
+            //only walk the outline of the ring, the inside has already been searched.
+            int step = edgeRow ? 1 : qMax(1, ring * 2);
+            for(int x = cx - ring; x <= cx + ring; x += step) {
+                foreach(const Grid* grid, searched) {
+                    QHash<quint64, QList<Entry*> >::const_iterator c = grid->cells.find(key(x, y));
+                    if(c == grid->cells.constEnd())
+                        continue;
+                    foreach(Entry* e, c.value()) {
+                        if(e->visited == query)
+                            continue;
+                        e->visited = query;
+                        if(selectableOnly && !isSelectable(e))
+                            continue;
+                        found.append(qMakePair(distanceToRect(pos, e->rect), e));
+                    }
+                }
+            }
+        }
+
+        if(found.count() < k)
+            continue;
+
+        //anything not found yet is outside the searched squares.
+        qreal reach = qMin(qMin(pos.x() - (cx - ring) * mCellSize, (cx + ring + 1) * mCellSize - pos.x()),
+                           qMin(pos.y() - (cy - ring) * mCellSize, (cy + ring + 1) * mCellSize - pos.y()));
+
+        qSort(found);
+        if(found.at(k - 1).first <= reach)
+            break;
+    }
+
+    qSort(found);
+    for(int i = 0; i < found.count() && i < k; ++i)
+        list.append(found.at(i).second->item);
+
+    return list;
+}
@@ -0,0 +1,158 @@
+/****************************************************************************\
+ Copyright (c) 2011-2014 Stitch Works Software
+ Brian C. Milco <bcmilco@gmail.com>
+
+ This file is part of Crochet Charts.
+
+ Crochet Charts is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ Crochet Charts is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with Crochet Charts. If not, see <http://www.gnu.org/licenses/>.
+
+ \****************************************************************************/
+#ifndef SPATIALINDEX_H
+#define SPATIALINDEX_H
+
+#include <QHash>
+#include <QSet>
+#include <QList>
+#include <QRectF>
+#include <QPainterPath>
+
+class QGraphicsItem;
+
+/**
+ * A uniform grid over the top level chart items, with one grid per chart layer.
+ *
+ * Each item is kept in every grid square its scene bounding rect touches, so a
+ * query only looks at the items near the area asked for instead of every item
+ * in the scene. Items that cover a lot of squares (ie: large images) are kept
+ * in a separate list per layer that every query checks.
+ *
+ * The index doesn't watch the items, the owner has to insert() them again
+ * when their geometry or layer changes and remove() them when they leave.
+ */
+class SpatialIndex
+{
+public:
+    enum {
+        AllLayers = -1, //query every layer.
+        NoLayer = -2    //items that aren't part of a layer, found by every query.
+    };
+
+    explicit SpatialIndex(qreal cellSize = 64);
+    ~SpatialIndex();
+
+    /**
+     * Add the item or move it to its new rect and layer if it's already indexed.
+     */
+    void insert(QGraphicsItem* item, const QRectF& rect, int layer);
+    void remove(QGraphicsItem* item);
+    void clear();
+
+    bool contains(QGraphicsItem* item) const { return mEntries.contains(item); }
+    int count() const { return mEntries.count(); }
+
+    /**
+     * The rect the item was last inserted with.
+     */
+    QRectF rect(QGraphicsItem* item) const;
+
+    /**
+     * The layer the item was last inserted with or NoLayer if it isn't indexed.
+     */
+    int layer(QGraphicsItem* item) const;
+
+    /**
+     * Every item in the layer, in no particular order.
+     */
+    QList<QGraphicsItem*> layerItems(int layer) const;
+
+    /**
+     * The rect around every indexed item.
+     * It grows as items are added and is only worked out again from all the
+     * items when an item on its edge moves in or is removed.
+     */
+    QRectF bounds() const;
+
+    /**
+     * The queries return the items sorted topmost first.
+     * When selectableOnly is true items without the ItemIsSelectable flag are skipped.
+     */
+    QList<QGraphicsItem*> items(const QPointF& pos, int layer = AllLayers, bool selectableOnly = false) const;
+    QList<QGraphicsItem*> items(const QRectF& rect, int layer = AllLayers, bool selectableOnly = false) const;
+    QList<QGraphicsItem*> items(const QPainterPath& path, Qt::ItemSelectionMode mode,
+                                int layer = AllLayers, bool selectableOnly = false) const;
+
+    /**
+     * Returns the topmost item whose shape contains pos or 0.
+     */
+    QGraphicsItem* itemAt(const QPointF& pos, int layer = AllLayers, bool selectableOnly = false) const;
+
+    /**
+     * The k items closest to pos ordered by the distance to their rects, closest first.
+     */
+    QList<QGraphicsItem*> nearest(const QPointF& pos, int k, int layer = AllLayers, bool selectableOnly = false) const;
+
+private:
+    struct Entry {
+        QGraphicsItem* item;
+        QRectF rect;
+        int layer;
+        //the order items were added in, used to break ties in the stacking order.
+        quint64 order;
+        bool large;
+        //the last query that looked at this entry so items in several squares are only returned once.
+        mutable quint32 visited;
+    };
+
+    struct Grid {
+        Grid() : minX(0), minY(0), maxX(-1), maxY(-1) {}
+        QHash<quint64, QList<Entry*> > cells;
+        QList<Entry*> large;
+        QSet<Entry*> members;
+        //the squares that have ever been used, limits how far nearest() searches.
+        int minX, minY, maxX, maxY;
+    };
+
+    static quint64 key(int x, int y);
+    QRect cellRange(const QRectF& rect) const;
+
+    void addToGrid(Entry* e);
+    void removeFromGrid(Entry* e);
+
+    //the grids a query for the given layer has to look at.
+    QList<const Grid*> grids(int layer) const;
+
+    //every entry in the squares covering rect that passes the filters.
+    QList<Entry*> candidates(const QRectF& rect, int layer, bool selectableOnly) const;
+
+    static bool isSelectable(const Entry* e);
+    static bool isAbove(const Entry* a, const Entry* b);
+    static void sortTopmostFirst(QList<Entry*>& entries);
+    static QList<QGraphicsItem*> toItems(const QList<Entry*>& entries);
+
+    qreal mCellSize;
+    QHash<QGraphicsItem*, Entry*> mEntries;
+    QHash<int, Grid> mGrids;
+
+    //true if an item could've been on the edge of mBounds when it moved or was removed.
+    bool touchesBounds(const QRectF& rect) const;
+    void growBounds(const QRectF& rect);
+
+    mutable QRectF mBounds;
+    mutable bool mBoundsDirty;
+
+    quint64 mNextOrder;
+    mutable quint32 mQuery;
+};
+
+#endif // SPATIALINDEX_H
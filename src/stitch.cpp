@@ -28,20 +28,40 @@
 #include <QFile>
 
 #include "settings.h"
+#include "stitchglyph.h"
+#include "builtinglyphs.h"
+
+#include <QVector>
+
+//every stitch ever created indexed by id, deleted stitches leave a 0 behind.
+//never freed so stitches deleted during shutdown can still clear their entry.
+static QVector<Stitch*>& stitchIds()
+{
+    static QVector<Stitch*>* ids = new QVector<Stitch*>();
+    return *ids;
+}
 
 Stitch::Stitch(QObject *parent) :
     QObject(parent),
     isBuiltIn(false),
     mIsSvg(false),
+    mGlyph(0),
     mPixmap(0)
 {
+    mId = stitchIds().count();
+    stitchIds().append(this);
 }
 
 Stitch::~Stitch()
 {
+    stitchIds()[mId] = 0;
+
     foreach(QString key, mRenderers.keys())
         mRenderers.value(key)->deleteLater();
 
+    delete mGlyph;
+    mGlyph = 0;
+
     delete mPixmap;
     mPixmap = 0;
 }
@@ -54,7 +74,13 @@ void Stitch::setFile ( QString f )
         delete mPixmap;
         mPixmap = 0;
 
-        setupSvgFiles();
+        delete mGlyph;
+        mGlyph = 0;
+
+        //built in stitches are drawn from the compiled glyphs, their
+        //renderers are only created when something asks for one.
+        if(!loadBuiltInGlyph())
+            setupSvgFiles();
 
         if(!isSvg()) {
             mPixmap = new QPixmap(mFile);
@@ -62,8 +88,29 @@ void Stitch::setFile ( QString f )
     }
 }
 
+bool Stitch::loadBuiltInGlyph()
+{
+    const BuiltInGlyph *builtIn = findBuiltInGlyph(mFile);
+    if(!builtIn)
+        return false;
+
+    mGlyph = new StitchGlyph();
+    if(!mGlyph->load(*builtIn)) {
+        delete mGlyph;
+        mGlyph = 0;
+        return false;
+    }
+
+    mIsSvg = true;
+    return true;
+}
+
 bool Stitch::setupSvgFiles()
 {
+    //the glyph is rebuilt from the new file the next time it's needed.
+    delete mGlyph;
+    mGlyph = 0;
+
     QFile file(mFile);
     if(!file.open(QIODevice::ReadOnly)) {
         WARN("cannot open file for svg setup");
@@ -151,6 +198,13 @@ QPixmap* Stitch::renderPixmap()
     return mPixmap;
 }
 
+Stitch* Stitch::fromId(int id)
+{
+    if(id < 0 || id >= stitchIds().count())
+        return 0;
+    return stitchIds().at(id);
+}
+
 QSvgRenderer* Stitch::renderSvg(QColor color)
 {
 
@@ -168,15 +222,42 @@ QSvgRenderer* Stitch::renderSvg(QColor color)
 
 }
 
+StitchGlyph* Stitch::glyph()
+{
+    if(!isSvg())
+        return 0;
+
+    if(!mGlyph) {
+        mGlyph = new StitchGlyph();
+
+        QFile file(mFile);
+        if(!file.open(QIODevice::ReadOnly)) {
+            WARN("cannot open file for stitch glyph");
+            return 0;
+        }
+
+        mGlyph->load(file.readAll());
+    }
+
+    return mGlyph->isValid() ? mGlyph : 0;
+}
+
 void Stitch::reloadIcon()
 {
+    //compiled glyphs take their color when drawn and
+    //renderers are made for each color as needed.
+    if(findBuiltInGlyph(mFile))
+        return;
+
     setupSvgFiles();
 }
 
 qreal Stitch::width()
 {
     qreal w = 32.0;
-    if(isSvg()) {
+    if(mGlyph && mGlyph->isValid()) {
+        w = mGlyph->boundingRect().width();
+    } else if(isSvg()) {
         QSvgRenderer *r = mRenderers.value("#000000");
         if(!r)
             return w;
@@ -193,7 +274,9 @@ qreal Stitch::width()
 qreal Stitch::height()
 {
     qreal h = 32.0;
-    if(isSvg()) {
+    if(mGlyph && mGlyph->isValid()) {
+        h = mGlyph->boundingRect().height();
+    } else if(isSvg()) {
         QSvgRenderer* r = mRenderers.value("#000000");
         if(!r)
             return h;
@@ -29,6 +29,7 @@
 
 class QSvgRenderer;
 class QPixmap;
+class StitchGlyph;
 
 class Stitch : public QObject
 {
@@ -53,6 +54,17 @@ public:
     QString category() const { return mCategory; }
     QString wrongSide() const { return mWrongSide; }
 
+    /**
+     * A number that stays with the stitch for as long as it exists and isn't reused after.
+     * Items can keep it in place of a pointer to the stitch.
+     */
+    int id() const { return mId; }
+
+    /**
+     * The stitch with the id or 0 if it has been deleted.
+     */
+    static Stitch* fromId(int id);
+
     qreal width();
     qreal height();
 
@@ -61,6 +73,12 @@ public:
     QPixmap* renderPixmap();
     QSvgRenderer* renderSvg(QColor color = QColor(Qt::black));
 
+    /**
+     * The svg flattened into painter paths, built on first use.
+     * Returns 0 if the stitch isn't an svg or can't be drawn as paths.
+     */
+    StitchGlyph* glyph();
+
     //reload the svg with new colors.
     void reloadIcon();
 
@@ -79,6 +97,7 @@ protected:
     void addStitchColor(QString color);
 
 private:
+    bool loadBuiltInGlyph();
     bool setupSvgFiles();
 
     QString mName;
@@ -87,9 +106,12 @@ private:
     QString mCategory;
     QString mWrongSide;
     bool mIsSvg;
+    int mId;
 
     QMap<QString, QSvgRenderer*> mRenderers;
 
+    StitchGlyph* mGlyph;
+
     QPixmap* mPixmap;
 };
 
@@ -0,0 +1,334 @@
+/****************************************************************************\
+ Copyright (c) 2011-2014 Stitch Works Software
+ Brian C. Milco <bcmilco@gmail.com>
+
+ This file is part of Crochet Charts.
+
+ Crochet Charts is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ Crochet Charts is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with Crochet Charts. If not, see <http://www.gnu.org/licenses/>.
+
+ \****************************************************************************/
+#include "stitchglyph.h"
+
+#include <QPainter>
+#include <QPaintEngine>
+#include <QPaintDevice>
+#include <QPainterPathStroker>
+#include <QtSvg/QSvgRenderer>
+
+#include "builtinglyphs.h"
+#include "debug.h"
+
+/**
+ * Paint engine that records everything drawn on it into a StitchGlyph
+ * instead of rasterizing it.
+ */
+class GlyphPaintEngine : public QPaintEngine
+{
+public:
+    GlyphPaintEngine(StitchGlyph *glyph)
+        : QPaintEngine(QPaintEngine::AllFeatures),
+        mGlyph(glyph),
+        mOpacity(1.0),
+        mIsComplete(true)
+    {
+    }
+
+    bool begin(QPaintDevice *) { return true; }
+    bool end() { return true; }
+    Type type() const { return QPaintEngine::User; }
+
+    void updateState(const QPaintEngineState &state)
+    {
+        QPaintEngine::DirtyFlags flags = state.state();
+
+        if(flags & QPaintEngine::DirtyPen)
+            mPen = state.pen();
+        if(flags & QPaintEngine::DirtyBrush)
+            mBrush = state.brush();
+        if(flags & QPaintEngine::DirtyTransform)
+            mTransform = state.transform();
+        if(flags & QPaintEngine::DirtyOpacity)
+            mOpacity = state.opacity();
+
+        //clipped content can't be replayed from plain paths.
+        if((flags & QPaintEngine::DirtyClipPath) || (flags & QPaintEngine::DirtyClipRegion)) {
+            if(state.clipOperation() != Qt::NoClip)
+                mIsComplete = false;
+        }
+    }
+
+    void drawPath(const QPainterPath &path)
+    {
+        mGlyph->addElement(path, mPen, mBrush, mTransform, mOpacity);
+    }
+
+    void drawPolygon(const QPointF *points, int pointCount, PolygonDrawMode mode)
+    {
+        if(pointCount <= 0)
+            return;
+
+        QPainterPath path(points[0]);
+        for(int i = 1; i < pointCount; ++i)
+            path.lineTo(points[i]);
+
+        if(mode == QPaintEngine::PolylineMode) {
+            mGlyph->addElement(path, mPen, QBrush(Qt::NoBrush), mTransform, mOpacity);
+            return;
+        }
+
+        path.closeSubpath();
+        path.setFillRule(mode == QPaintEngine::WindingMode ? Qt::WindingFill : Qt::OddEvenFill);
+        mGlyph->addElement(path, mPen, mBrush, mTransform, mOpacity);
+    }
+
+    void drawPixmap(const QRectF &, const QPixmap &, const QRectF &)
+    {
+        mIsComplete = false;
+    }
+
+    bool isComplete() const { return mIsComplete; }
+
+private:
+    StitchGlyph *mGlyph;
+
+    QPen mPen;
+    QBrush mBrush;
+    QTransform mTransform;
+    qreal mOpacity;
+
+    bool mIsComplete;
+};
+
+class GlyphPaintDevice : public QPaintDevice
+{
+public:
+    GlyphPaintDevice(GlyphPaintEngine *engine, const QSize &size)
+        : mEngine(engine),
+        mSize(size)
+    {
+    }
+
+    QPaintEngine* paintEngine() const { return mEngine; }
+
+protected:
+    int metric(PaintDeviceMetric metric) const
+    {
+        switch(metric) {
+            case QPaintDevice::PdmWidth:
+                return mSize.width();
+            case QPaintDevice::PdmHeight:
+                return mSize.height();
+            case QPaintDevice::PdmWidthMM:
+                return qRound(mSize.width() * 25.4 / 72);
+            case QPaintDevice::PdmHeightMM:
+                return qRound(mSize.height() * 25.4 / 72);
+            case QPaintDevice::PdmNumColors:
+                return 0xffffffff;
+            case QPaintDevice::PdmDepth:
+                return 32;
+            case QPaintDevice::PdmDpiX:
+            case QPaintDevice::PdmDpiY:
+            case QPaintDevice::PdmPhysicalDpiX:
+            case QPaintDevice::PdmPhysicalDpiY:
+                return 72;
+            default:
+                return 0;
+        }
+    }
+
+private:
+    GlyphPaintEngine *mEngine;
+    QSize mSize;
+};
+
+StitchGlyph::StitchGlyph()
+    : mIsValid(false)
+{
+}
+
+StitchGlyph::~StitchGlyph()
+{
+}
+
+bool StitchGlyph::load(const QByteArray &svgData)
+{
+    mElements.clear();
+    mOutline = QPainterPath();
+    mIsValid = false;
+
+    QSvgRenderer renderer;
+    if(!renderer.load(svgData)) {
+        WARN("cannot parse svg for glyph");
+        return false;
+    }
+
+    QSize size = renderer.defaultSize();
+    mBoundingRect = QRectF(QPointF(0, 0), size);
+
+    GlyphPaintEngine engine(this);
+    GlyphPaintDevice device(&engine, size);
+
+    QPainter p;
+    if(!p.begin(&device))
+        return false;
+    renderer.render(&p, mBoundingRect);
+    p.end();
+
+    if(!engine.isComplete()) {
+        mElements.clear();
+        return false;
+    }
+
+    mIsValid = true;
+    return true;
+}
+
+bool StitchGlyph::load(const BuiltInGlyph &builtIn)
+{
+    mElements.clear();
+    mOutline = QPainterPath();
+    mBoundingRect = QRectF(0, 0, builtIn.width, builtIn.height);
+
+    for(int i = 0; i < builtIn.elementCount; ++i) {
+        const BuiltInGlyph::Element &be = builtIn.elements[i];
+
+        QPainterPath path;
+        path.setFillRule((Qt::FillRule)be.fillRule);
+        for(int j = 0; j < be.pathCount; ++j) {
+            const BuiltInGlyph::PathElement &pe = be.path[j];
+            switch(pe.type) {
+                case QPainterPath::MoveToElement:
+                    path.moveTo(pe.x, pe.y);
+                    break;
+                case QPainterPath::LineToElement:
+                    path.lineTo(pe.x, pe.y);
+                    break;
+                case QPainterPath::CurveToElement:
+                    //a curve is always followed by its two data points.
+                    if(j + 2 < be.pathCount) {
+                        path.cubicTo(pe.x, pe.y, be.path[j+1].x, be.path[j+1].y,
+                                     be.path[j+2].x, be.path[j+2].y);
+                        j += 2;
+                    }
+                    break;
+                default:
+                    break;
+            }
+        }
+
+        QPen pen(QBrush(QColor::fromRgba(be.penColor)), be.penWidth, (Qt::PenStyle)be.penStyle,
+                 (Qt::PenCapStyle)be.penCapStyle, (Qt::PenJoinStyle)be.penJoinStyle);
+        pen.setMiterLimit(be.penMiterLimit);
+
+        QBrush brush = QBrush(QColor::fromRgba(be.brushColor), (Qt::BrushStyle)be.brushStyle);
+
+        const qreal *m = be.transform;
+        QTransform transform(m[0], m[1], m[2], m[3], m[4], m[5], m[6], m[7], m[8]);
+
+        addElement(path, pen, brush, transform, be.opacity);
+    }
+
+    mIsValid = true;
+    return true;
+}
+
+void StitchGlyph::addElement(const QPainterPath &path, const QPen &pen, const QBrush &brush,
+                             const QTransform &transform, qreal opacity)
+{
+    if(path.isEmpty())
+        return;
+
+    Element e;
+    e.path = path;
+    e.pen = pen;
+    e.brush = brush;
+    e.transform = transform;
+    e.opacity = opacity;
+
+    //black is the color that gets replaced by the stitch color.
+    e.tintPen = (pen.style() != Qt::NoPen && pen.brush().style() == Qt::SolidPattern
+                    && pen.color().rgb() == QColor(Qt::black).rgb());
+    e.tintBrush = (brush.style() == Qt::SolidPattern && brush.color().rgb() == QColor(Qt::black).rgb());
+
+    mElements.append(e);
+}
+
+QPainterPath StitchGlyph::outline() const
+{
+    if(mOutline.isEmpty())
+        buildOutline();
+
+    return mOutline;
+}
+
+void StitchGlyph::buildOutline() const
+{
+    QPainterPath outline;
+    outline.setFillRule(Qt::WindingFill);
+
+    QPainterPathStroker stroker;
+    foreach(const Element &e, mElements) {
+        QPainterPath p;
+        if(e.brush.style() != Qt::NoBrush)
+            p.addPath(e.path);
+
+        if(e.pen.style() != Qt::NoPen) {
+            stroker.setWidth(qMax(e.pen.widthF(), qreal(1.0)));
+            stroker.setCapStyle(e.pen.capStyle());
+            stroker.setJoinStyle(e.pen.joinStyle());
+            stroker.setMiterLimit(e.pen.miterLimit());
+            p.addPath(stroker.createStroke(e.path));
+        }
+
+        outline.addPath(e.transform.map(p));
+    }
+
+    mOutline = outline.simplified();
+
+    //a glyph with nothing to hit shouldn't become unselectable.
+    if(mOutline.isEmpty())
+        mOutline.addRect(mBoundingRect);
+}
+
+void StitchGlyph::draw(QPainter *painter, const QColor &color) const
+{
+    QColor tint = color.isValid() ? color : QColor(Qt::black);
+
+    QTransform base = painter->worldTransform();
+    qreal baseOpacity = painter->opacity();
+
+    painter->save();
+    foreach(const Element &e, mElements) {
+        QPen pen = e.pen;
+        if(e.tintPen) {
+            QColor c = tint;
+            c.setAlpha(pen.color().alpha());
+            pen.setColor(c);
+        }
+
+        QBrush brush = e.brush;
+        if(e.tintBrush) {
+            QColor c = tint;
+            c.setAlpha(brush.color().alpha());
+            brush.setColor(c);
+        }
+
+        painter->setWorldTransform(e.transform * base);
+        painter->setOpacity(baseOpacity * e.opacity);
+        painter->setPen(pen);
+        painter->setBrush(brush);
+        painter->drawPath(e.path);
+    }
+    painter->restore();
+}
@@ -0,0 +1,95 @@
+/****************************************************************************\
+ Copyright (c) 2011-2014 Stitch Works Software
+ Brian C. Milco <bcmilco@gmail.com>
+
+ This file is part of Crochet Charts.
+
+ Crochet Charts is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ Crochet Charts is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with Crochet Charts. If not, see <http://www.gnu.org/licenses/>.
+
+ \****************************************************************************/
+#ifndef STITCHGLYPH_H
+#define STITCHGLYPH_H
+
+#include <QPainterPath>
+#include <QPen>
+#include <QBrush>
+#include <QTransform>
+#include <QList>
+#include <QRectF>
+
+class QPainter;
+class QByteArray;
+struct BuiltInGlyph;
+
+/**
+ * A stitch svg flattened into painter paths.
+ *
+ * The svg is walked once and every shape it draws is kept with its pen,
+ * brush and transform. Black pens and brushes are drawn in the color
+ * passed to draw(), so one glyph serves every color a stitch is used in.
+ */
+class StitchGlyph
+{
+public:
+    struct Element {
+        QPainterPath path;
+        QPen pen;
+        QBrush brush;
+        QTransform transform;
+        qreal opacity;
+        bool tintPen;
+        bool tintBrush;
+    };
+
+    StitchGlyph();
+    ~StitchGlyph();
+
+    /**
+     * Parse the svg data and record its shapes.
+     * Returns false if the svg can't be represented as paths (ie: it embeds images).
+     */
+    bool load(const QByteArray &svgData);
+
+    /**
+     * Rebuild the glyph from the tables compiled in at build time.
+     */
+    bool load(const BuiltInGlyph &builtIn);
+
+    bool isValid() const { return mIsValid; }
+
+    QRectF boundingRect() const { return mBoundingRect; }
+
+    /**
+     * The filled and stroked area of the glyph, used for hit testing.
+     * It's built the first time it's asked for.
+     */
+    QPainterPath outline() const;
+
+    const QList<Element>& elements() const { return mElements; }
+
+    void draw(QPainter *painter, const QColor &color) const;
+
+    void addElement(const QPainterPath &path, const QPen &pen, const QBrush &brush,
+                    const QTransform &transform, qreal opacity);
+
+private:
+    void buildOutline() const;
+
+    QList<Element> mElements;
+    QRectF mBoundingRect;
+    mutable QPainterPath mOutline;
+    bool mIsValid;
+};
+
+#endif // STITCHGLYPH_H
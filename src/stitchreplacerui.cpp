@@ -24,13 +24,16 @@
 #include "stitch.h"
 #include <QPushButton>
 #include "stitchlibrary.h"
+#include "scene.h"
 
-StitchReplacerUi::StitchReplacerUi(QString stitch, QList< QString > patternStitches, QWidget* parent) :
+StitchReplacerUi::StitchReplacerUi(QString stitch, QList< QString > patternStitches, Scene* scene, QWidget* parent) :
     QDialog(parent),
     mOriginalStitchList(patternStitches),
-    ui(new Ui::StitchReplacerUi)
+    ui(new Ui::StitchReplacerUi),
+    mScene(scene)
 {
     ui->setupUi(this);
+    ui->matchCount->setVisible(mScene != 0);
 
     if(mOriginalStitchList.isEmpty()) {
         QPushButton *ok = ui->buttonBox->button(QDialogButtonBox::Ok);
@@ -59,6 +62,7 @@ void StitchReplacerUi::updateStitches(QString newStitch)
 {
     if(sender() == ui->originalStitch) {
         original = newStitch;
+        updateMatchCount();
     } else { //replacement stitch
         replacement = newStitch;
     }
@@ -79,3 +83,12 @@ void StitchReplacerUi::populateStitchLists()
         ui->replacementStitch->addItem(QIcon(s->file()), stitch);
     }
 }
+
+void StitchReplacerUi::updateMatchCount()
+{
+    if(!mScene)
+        return;
+
+    int count = mScene->cellsWithStitch(original).count();
+    ui->matchCount->setText(tr("%n stitch(es) will be replaced.", "", count));
+}
@@ -34,7 +34,10 @@ class StitchReplacerUi : public QDialog
     Q_OBJECT
 
 public:
-    explicit StitchReplacerUi(QString stitch, QList<QString> patternStitches, QWidget *parent = 0);
+    /**
+     * When a scene is given the dialog shows how many of its cells will be replaced.
+     */
+    explicit StitchReplacerUi(QString stitch, QList<QString> patternStitches, Scene *scene = 0, QWidget *parent = 0);
     ~StitchReplacerUi();
 
     QString original;
@@ -47,6 +50,9 @@ private:
     //Hold the list of stitches used in this pattern.
     QList<QString> mOriginalStitchList;
     Ui::StitchReplacerUi *ui;
+    Scene *mScene;
+
+    void updateMatchCount();
 
     void populateStitchLists();
 
@@ -59,8 +59,8 @@ public slots:
     virtual void zoomIn() = 0;
     virtual void zoomOut() = 0;
 
-    virtual void stitchChanged(QString oldSt, QString newSt) = 0;
-    virtual void colorChanged(QString oldColor, QString newColor) = 0;
+    virtual void stitchesChanged(QMap<QString, int> changes) = 0;
+    virtual void colorsChanged(QMap<QString, int> changes) = 0;
 
     virtual QUndoStack* undoStack() = 0;
 
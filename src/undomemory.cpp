@@ -0,0 +1,200 @@
+/****************************************************************************\
+ Copyright (c) 2011-2014 Stitch Works Software
+ Brian C. Milco <bcmilco@gmail.com>
+
+ This file is part of Crochet Charts.
+
+ Crochet Charts is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ Crochet Charts is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with Crochet Charts. If not, see <http://www.gnu.org/licenses/>.
+
+ \****************************************************************************/
+#include "undomemory.h"
+
+#include "settings.h"
+
+#include <QUndoStack>
+#include <QTemporaryFile>
+#include <QDir>
+#include <QtAlgorithms>
+#include <QDebug>
+
+SpillableCommand::SpillableCommand(QUndoCommand *parent)
+    : QUndoCommand(parent),
+    mMemory(0),
+    mOffset(-1),
+    mSize(0),
+    mGeneration(0),
+    mSpilled(false)
+{
+}
+
+void SpillableCommand::restore()
+{
+    if(!mSpilled)
+        return;
+
+    mSpilled = false;
+
+    QByteArray data = mMemory->read(mOffset, mSize);
+    if(data.isEmpty()) {
+        qWarning() << "SpillableCommand: couldn't read back" << text();
+        return;
+    }
+
+    QDataStream in(data);
+    loadValues(in);
+}
+
+UndoMemory::UndoMemory(QUndoStack *stack)
+    : QObject(stack),
+    mStack(stack),
+    mFile(0),
+    mGeneration(0),
+    mBudget(-1),
+    mMemoryUsage(0),
+    mSpilledSize(0)
+{
+    connect(stack, SIGNAL(indexChanged(int)), SLOT(checkBudget()));
+}
+
+UndoMemory::~UndoMemory()
+{
+    //the spill file is a child and removes itself.
+}
+
+UndoMemory* UndoMemory::forStack(QUndoStack *stack)
+{
+    if(!stack)
+        return 0;
+    return stack->findChild<UndoMemory*>();
+}
+
+qint64 UndoMemory::budget() const
+{
+    if(mBudget >= 0)
+        return mBudget;
+
+    return qint64(Settings::inst()->value("undoMemoryLimit").toInt()) * 1024 * 1024;
+}
+
+void UndoMemory::collect(const QUndoCommand *cmd, int distance, QList<Candidate> &candidates)
+{
+    const SpillableCommand *sc = dynamic_cast<const SpillableCommand*>(cmd);
+    if(sc) {
+        mMemoryUsage += sc->byteSize();
+        if(sc->isSpilled())
+            mSpilledSize += sc->mSize;
+        else
+            candidates.append(Candidate(distance, const_cast<SpillableCommand*>(sc)));
+    } else {
+        mMemoryUsage += sizeof(QUndoCommand) + 64;
+    }
+
+    mMemoryUsage += cmd->text().size() * sizeof(QChar);
+
+    for(int i = 0; i < cmd->childCount(); ++i)
+        collect(cmd->child(i), distance, candidates);
+}
+
+void UndoMemory::checkBudget()
+{
+    mMemoryUsage = 0;
+    mSpilledSize = 0;
+
+    QList<Candidate> candidates;
+
+    int index = mStack->index();
+    for(int i = 0; i < mStack->count(); ++i) {
+        //how many steps away from being undone or redone the command is.
+        int distance = (i < index) ? index - 1 - i : i - index;
+        collect(mStack->command(i), distance, candidates);
+    }
+
+    qint64 limit = budget();
+    if(limit > 0 && mMemoryUsage > limit) {
+        qSort(candidates);
+
+        //spill the commands furthest away first and always keep the next undo and redo.
+        while(mMemoryUsage > limit && !candidates.isEmpty()) {
+            Candidate c = candidates.takeLast();
+            if(c.first < 1)
+                break;
+
+            qint64 before = c.second->byteSize();
+            if(!spill(c.second))
+                break;
+
+            mMemoryUsage -= before - c.second->byteSize();
+            mSpilledSize += c.second->mSize;
+        }
+    }
+
+    //nothing refers to the file any more, start it over.
+    if(mSpilledSize == 0 && mFile && mFile->size() > 0) {
+        mFile->resize(0);
+        ++mGeneration;
+    }
+
+    emit usageChanged(mMemoryUsage, mSpilledSize);
+}
+
+bool UndoMemory::spill(SpillableCommand *cmd)
+{
+    //a copy written earlier can be used again until the values change.
+    if(cmd->mMemory == this && cmd->mOffset >= 0 && cmd->mGeneration == mGeneration) {
+        cmd->dropValues();
+        cmd->mSpilled = true;
+        return true;
+    }
+
+    if(!mFile) {
+        mFile = new QTemporaryFile(QDir::tempPath() + "/crochetcharts-undo-XXXXXX", this);
+        if(!mFile->open()) {
+            qWarning() << "UndoMemory: couldn't open the spill file" << mFile->errorString();
+            delete mFile;
+            mFile = 0;
+            return false;
+        }
+    }
+
+    QByteArray data;
+    QDataStream out(&data, QIODevice::WriteOnly);
+    cmd->saveValues(out);
+    data = qCompress(data);
+
+    qint64 offset = mFile->size();
+    if(!mFile->seek(offset) || mFile->write(data) != data.size()) {
+        qWarning() << "UndoMemory: couldn't write to the spill file" << mFile->errorString();
+        return false;
+    }
+
+    cmd->mMemory = this;
+    cmd->mOffset = offset;
+    cmd->mSize = data.size();
+    cmd->mGeneration = mGeneration;
+    cmd->dropValues();
+    cmd->mSpilled = true;
+    return true;
+}
+
+QByteArray UndoMemory::read(qint64 offset, qint64 size)
+{
+    if(!mFile || !mFile->seek(offset))
+        return QByteArray();
+
+    QByteArray data = mFile->read(size);
+    if(data.size() != size)
+        return QByteArray();
+
+    return qUncompress(data);
+}
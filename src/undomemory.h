@@ -0,0 +1,156 @@
+/****************************************************************************\
+ Copyright (c) 2011-2014 Stitch Works Software
+ Brian C. Milco <bcmilco@gmail.com>
+
+ This file is part of Crochet Charts.
+
+ Crochet Charts is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ Crochet Charts is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with Crochet Charts. If not, see <http://www.gnu.org/licenses/>.
+
+ \****************************************************************************/
+#ifndef UNDOMEMORY_H
+#define UNDOMEMORY_H
+
+#include <QObject>
+#include <QUndoCommand>
+#include <QDataStream>
+#include <QVector>
+#include <QList>
+#include <QPair>
+
+class QUndoStack;
+class QTemporaryFile;
+class UndoMemory;
+
+/**
+ * An undo command whose values can be written out to the spill file of the
+ * undo stack when the stack uses more memory than it is allowed to.
+ *
+ * Commands call restore() before using their values in undo() and redo(),
+ * values that were spilled are read back from the file then.
+ */
+class SpillableCommand : public QUndoCommand
+{
+public:
+    SpillableCommand(QUndoCommand *parent = 0);
+
+    /**
+     * The approximate number of bytes the command keeps in memory.
+     */
+    virtual qint64 byteSize() const = 0;
+
+    bool isSpilled() const { return mSpilled; }
+
+protected:
+    void restore();
+    /**
+     * Call after changing the values so they're written out again the next time.
+     */
+    void valuesChanged() { mOffset = -1; }
+
+    virtual void saveValues(QDataStream &out) const = 0;
+    virtual void loadValues(QDataStream &in) = 0;
+    /**
+     * Free the values after they've been saved.
+     */
+    virtual void dropValues() = 0;
+
+    //items are only ever spilled while they're alive so they're kept as plain addresses.
+    template<class T>
+    static void savePointers(QDataStream &out, const QVector<T*> &items)
+    {
+        out << quint32(items.count());
+        foreach(T *i, items)
+            out << quint64(quintptr(i));
+    }
+
+    template<class T>
+    static void loadPointers(QDataStream &in, QVector<T*> &items)
+    {
+        quint32 count = 0;
+        in >> count;
+        items.reserve(count);
+        for(quint32 i = 0; i < count; ++i) {
+            quint64 p = 0;
+            in >> p;
+            items.append(reinterpret_cast<T*>(quintptr(p)));
+        }
+    }
+
+private:
+    friend class UndoMemory;
+
+    UndoMemory *mMemory;
+    qint64 mOffset;
+    qint64 mSize;
+    int mGeneration;
+    bool mSpilled;
+};
+
+/**
+ * Keeps the commands of an undo stack within a memory budget.
+ *
+ * Each time the stack changes the commands are measured, and while the stack
+ * uses more than the budget the SpillableCommands furthest from the current
+ * index are written to a temporary file. They're read back in when they are
+ * undone or redone again.
+ *
+ * The UndoMemory is a child of the stack it watches.
+ */
+class UndoMemory : public QObject
+{
+    Q_OBJECT
+public:
+    explicit UndoMemory(QUndoStack *stack);
+    ~UndoMemory();
+
+    static UndoMemory* forStack(QUndoStack *stack);
+
+    /**
+     * The bytes the stack may keep in memory, 0 means there is no limit.
+     * Unless it's set the budget comes from the undoMemoryLimit setting (in MB).
+     */
+    qint64 budget() const;
+    void setBudget(qint64 bytes) { mBudget = bytes; }
+
+    qint64 memoryUsage() const { return mMemoryUsage; }
+    qint64 spilledSize() const { return mSpilledSize; }
+
+public slots:
+    void checkBudget();
+
+signals:
+    void usageChanged(qint64 memory, qint64 spilled);
+
+private:
+    friend class SpillableCommand;
+
+    typedef QPair<int, SpillableCommand*> Candidate;
+
+    //measure cmd and its children and list the ones that can be spilled.
+    void collect(const QUndoCommand *cmd, int distance, QList<Candidate> &candidates);
+
+    bool spill(SpillableCommand *cmd);
+    QByteArray read(qint64 offset, qint64 size);
+
+    QUndoStack *mStack;
+    QTemporaryFile *mFile;
+    //bumped when the file is emptied so old offsets aren't reused.
+    int mGeneration;
+
+    qint64 mBudget;
+    qint64 mMemoryUsage;
+    qint64 mSpilledSize;
+};
+
+#endif // UNDOMEMORY_H
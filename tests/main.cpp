@@ -24,6 +24,12 @@
 #include "testcell.h"
 #include "testtextview.h"
 #include "teststitchlibrary.h"
+#include "testspatialindex.h"
+#include "testcolorpalette.h"
+#include "testundomemory.h"
+#include "testclipboarddata.h"
+#include "testsnapengine.h"
+#include "testchartlayout.h"
 
 int main(int argc, char** argv) 
 {
@@ -64,6 +70,36 @@ int main(int argc, char** argv)
     retval +=QTest::qExec(test, argc, argv);
     delete test;
     test = 0;
+
+    test = new TestSpatialIndex();
+    retval +=QTest::qExec(test, argc, argv);
+    delete test;
+    test = 0;
+
+    test = new TestColorPalette();
+    retval +=QTest::qExec(test, argc, argv);
+    delete test;
+    test = 0;
+
+    test = new TestUndoMemory();
+    retval +=QTest::qExec(test, argc, argv);
+    delete test;
+    test = 0;
+
+    test = new TestClipboardData();
+    retval +=QTest::qExec(test, argc, argv);
+    delete test;
+    test = 0;
+
+    test = new TestSnapEngine();
+    retval +=QTest::qExec(test, argc, argv);
+    delete test;
+    test = 0;
+
+    test = new TestChartLayout();
+    retval +=QTest::qExec(test, argc, argv);
+    delete test;
+    test = 0;
     
     return (retval ? 1 : 0);
 }
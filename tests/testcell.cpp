@@ -20,15 +20,26 @@
  \****************************************************************************/
 #include "testcell.h"
 #include "../src/stitchlibrary.h"
+#include "../src/ChartItemTools.h"
+#include "../src/scene.h"
+#include "../src/crochetchartcommands.h"
+#include "../src/indicator.h"
+#include "../src/settings.h"
 
 #include <QPainter>
 #include <QFile>
 #include <QCryptographicHash>
 #include <QSvgGenerator>
+#include <QGraphicsRotation>
+#include <QGraphicsScale>
+#include <QMatrix4x4>
+#include <QPointer>
+#include <QSignalSpy>
 
 void TestCell::initTestCase()
 {
     i = 0;
+    qRegisterMetaType<CellCounts>("QMap<QString,int>");
 
     StitchLibrary::inst()->loadStitchSets();
 }
@@ -163,6 +174,468 @@ void TestCell::setScale_data()
     QTest::newRow("dc")    << "dc" << 32.0 << 80.0 << 2.5 << 2.5 << "bdb70eea2145b79c7cb4e50a6148f5ec4d09f708";
 }
 
+void TestCell::chartTransform()
+{
+    QFETCH(qreal, angle);
+    QFETCH(QPointF, rotationPivot);
+    QFETCH(QPointF, scale);
+    QFETCH(QPointF, scalePivot);
+
+    ChartItemTransform t;
+    t.rotation = angle;
+    t.rotationPivot = rotationPivot;
+    t.scaleX = scale.x();
+    t.scaleY = scale.y();
+    t.scalePivot = scalePivot;
+
+    //the transform has to match the QGraphicsTransforms it replaces.
+    QGraphicsRotation r;
+    r.setAngle(angle);
+    r.setOrigin(QVector3D(rotationPivot));
+    QGraphicsScale s;
+    s.setXScale(scale.x());
+    s.setYScale(scale.y());
+    s.setOrigin(QVector3D(scalePivot));
+
+    QMatrix4x4 m;
+    r.applyTo(&m);
+    s.applyTo(&m);
+
+    Cell* c = new Cell();
+    c->setStitch("dc");
+    ChartItemTools::setScalePivot(c, scalePivot, false);
+    ChartItemTools::setScale(c, scale);
+    ChartItemTools::setRotationPivot(c, rotationPivot, false);
+    ChartItemTools::setRotation(c, angle);
+
+    QList<QPointF> points;
+    points << QPointF(0, 0) << QPointF(32, 0) << QPointF(0, 80) << QPointF(13, 57);
+    foreach(QPointF p, points) {
+        QPointF expected = m.map(p);
+        QPointF actual = t.toTransform().map(p);
+        QVERIFY(qAbs(expected.x() - actual.x()) < 0.0001);
+        QVERIFY(qAbs(expected.y() - actual.y()) < 0.0001);
+
+        actual = c->mapToScene(p);
+        QVERIFY(qAbs(expected.x() - actual.x()) < 0.0001);
+        QVERIFY(qAbs(expected.y() - actual.y()) < 0.0001);
+    }
+
+    QCOMPARE(ChartItemTools::getRotation(c), angle);
+    QCOMPARE(ChartItemTools::getScale(c), scale);
+
+    delete c;
+    c = 0;
+}
+
+void TestCell::chartTransform_data()
+{
+    QTest::addColumn<qreal>("angle");
+    QTest::addColumn<QPointF>("rotationPivot");
+    QTest::addColumn<QPointF>("scale");
+    QTest::addColumn<QPointF>("scalePivot");
+
+    QTest::newRow("identity") << 0.0 << QPointF(0, 0) << QPointF(1, 1) << QPointF(0, 0);
+    QTest::newRow("rotate")   << 45.0 << QPointF(16, 80) << QPointF(1, 1) << QPointF(0, 0);
+    QTest::newRow("scale")    << 0.0 << QPointF(0, 0) << QPointF(2, 0.5) << QPointF(16, 40);
+    QTest::newRow("both")     << 120.0 << QPointF(16, 40) << QPointF(1.5, 3) << QPointF(16, 80);
+    QTest::newRow("mirror")   << -30.0 << QPointF(16, 40) << QPointF(-1, 1) << QPointF(16, 40);
+}
+
+void TestCell::init()
+{
+    mScene = new Scene();
+}
+
+void TestCell::cleanup()
+{
+    delete mScene;
+    mScene = 0;
+}
+
+Cell* TestCell::addCell(const QString& stitch, const QPointF& pos)
+{
+    Cell* c = new Cell();
+    c->setStitch(stitch);
+    mScene->addItem(c);
+    c->setPos(pos);
+    return c;
+}
+
+void TestCell::cellColorIndex()
+{
+    QFETCH(bool, fg);
+    QFETCH(bool, bg);
+    QFETCH(int, count);
+
+    Cell* a = addCell("dc");
+    Cell* b = addCell("ch");
+    a->setColor(QColor(Qt::red));
+    b->setColor(QColor(Qt::blue));
+    b->setBgColor(QColor(Qt::red));
+
+    QCOMPARE(mScene->cellsWithColor(QColor(Qt::red), fg, bg).count(), count);
+}
+
+void TestCell::cellColorIndex_data()
+{
+    QTest::addColumn<bool>("fg");
+    QTest::addColumn<bool>("bg");
+    QTest::addColumn<int>("count");
+
+    QTest::newRow("fg")    << true << false << 1;
+    QTest::newRow("bg")    << false << true << 1;
+    QTest::newRow("both")  << true << true << 2;
+}
+
+void TestCell::cellStitchIndex()
+{
+    Cell* a = addCell("dc");
+    Cell* b = addCell("ch");
+    QCOMPARE(mScene->cellsWithStitch("dc").count(), 1);
+
+    //changes are filed under the new stitch.
+    b->setStitch("dc");
+    QCOMPARE(mScene->cellsWithStitch("dc").count(), 2);
+    QCOMPARE(mScene->cellsWithStitch("ch").count(), 0);
+
+    mScene->replaceStitches("dc", "hdc");
+    QCOMPARE(mScene->cellsWithStitch("hdc").count(), 2);
+    mScene->undoStack()->undo();
+    QCOMPARE(mScene->cellsWithStitch("dc").count(), 2);
+
+    //cells leave the index with the scene.
+    mScene->removeItem(a);
+    QCOMPARE(mScene->cellsWithStitch("dc").count(), 1);
+    delete a;
+}
+
+void TestCell::alternateColor()
+{
+    QColor primary(Settings::inst()->value("stitchPrimaryColor").toString());
+    QColor secondary(Settings::inst()->value("stitchAlternateColor").toString());
+
+    Cell* c = addCell("dc");
+    c->setColor(primary);
+    QCoreApplication::processEvents();
+
+    QSignalSpy colors(mScene, SIGNAL(colorsChanged(QMap<QString,int>)));
+    c->useAlternateRenderer(true);
+    QCoreApplication::processEvents();
+
+    //the alternate color is a color change like any other.
+    QCOMPARE(c->color(), secondary);
+    QCOMPARE(mScene->cellsWithColor(secondary, true, false).count(), 1);
+    QCOMPARE(colors.count(), 1);
+    CellCounts counts = colors.last().first().value<CellCounts>();
+    QCOMPARE(counts.value(primary.name()), -1);
+    QCOMPARE(counts.value(secondary.name()), 1);
+}
+
+static qreal itemProperty(QGraphicsItem* item, const QString& property)
+{
+    if(property == "Angle")
+        return ChartItemTools::getRotation(item);
+    else if(property == "PositionX")
+        return item->pos().x();
+    else if(property == "ScaleX")
+        return ChartItemTools::getScaleX(item);
+    else if(property == "ScaleY")
+        return ChartItemTools::getScaleY(item);
+
+    qWarning() << "Unknown property" << property;
+    return 0;
+}
+
+void TestCell::bulkProperties()
+{
+    QFETCH(QString, property);
+    QFETCH(qreal, value);
+    QFETCH(qreal, before);
+
+    QList<Cell*> cells;
+    for(int i = 0; i < 3; ++i) {
+        cells.append(addCell());
+        cells.last()->setSelected(true);
+    }
+
+    //the whole selection is changed by a single command.
+    mScene->propertiesUpdate(property, value);
+    QCOMPARE(mScene->undoStack()->count(), 1);
+    foreach(Cell* c, cells)
+        QCOMPARE(itemProperty(c, property), value);
+
+    mScene->undoStack()->undo();
+    foreach(Cell* c, cells)
+        QCOMPARE(itemProperty(c, property), before);
+}
+
+void TestCell::bulkProperties_data()
+{
+    QTest::addColumn<QString>("property");
+    QTest::addColumn<qreal>("value");
+    QTest::addColumn<qreal>("before");
+
+    QTest::newRow("ScaleX")     << "ScaleX" << 0.5 << 1.0;
+    QTest::newRow("ScaleY")     << "ScaleY" << 2.0 << 1.0;
+    QTest::newRow("Angle")      << "Angle" << 30.0 << 0.0;
+    QTest::newRow("PositionX")  << "PositionX" << 10.0 << 0.0;
+}
+
+void TestCell::bulkStitch()
+{
+    for(int i = 0; i < 3; ++i)
+        addCell()->setSelected(true);
+
+    mScene->propertiesUpdate("Stitch", QString("dc"));
+    QCOMPARE(mScene->undoStack()->count(), 1);
+    QCOMPARE(mScene->cellsWithStitch("dc").count(), 3);
+
+    mScene->undoStack()->undo();
+    QCOMPARE(mScene->cellsWithStitch("ch").count(), 3);
+}
+
+void TestCell::bulkDelete()
+{
+    QList<Cell*> cells;
+    for(int i = 0; i < 3; ++i) {
+        cells.append(addCell());
+        cells.last()->setSelected(true);
+    }
+
+    mScene->deleteSelection();
+    QCOMPARE(mScene->undoStack()->count(), 1);
+    foreach(Cell* c, cells)
+        QVERIFY(!c->scene());
+
+    mScene->undoStack()->undo();
+    foreach(Cell* c, cells)
+        QVERIFY(c->scene() == mScene);
+}
+
+void TestCell::mergeEdits()
+{
+    Cell* a = addCell();
+    Cell* b = addCell();
+    a->setSelected(true);
+
+    //scrubbing a value is one undo step.
+    for(int x = 1; x <= 5; ++x)
+        mScene->propertiesUpdate("PositionX", qreal(x));
+    QCOMPARE(mScene->undoStack()->count(), 1);
+    QCOMPARE(a->pos().x(), 5.0);
+
+    //edits of another selection aren't merged.
+    b->setSelected(true);
+    mScene->propertiesUpdate("PositionX", 8.0);
+    QCOMPARE(mScene->undoStack()->count(), 2);
+
+    mScene->undoStack()->undo();
+    mScene->undoStack()->undo();
+    QCOMPARE(a->pos().x(), 0.0);
+    QCOMPARE(b->pos().x(), 0.0);
+}
+
+void TestCell::removeRows()
+{
+    QList<Cell*> cells;
+    for(int y = 0; y < 3; ++y) {
+        QList<Cell*> row;
+        for(int x = 0; x < 3; ++x)
+            row.append(addCell());
+        mScene->gridAddRow(row);
+        cells.append(row);
+    }
+
+    //the middle of the first row and all of the second row.
+    cells[1]->setSelected(true);
+    for(int x = 3; x < 6; ++x)
+        cells[x]->setSelected(true);
+
+    mScene->deleteSelection();
+    QCOMPARE(mScene->undoStack()->count(), 1);
+    QCOMPARE(mScene->rowCount(), 2);
+    QCOMPARE(mScene->columnCount(0), 2);
+    QCOMPARE(mScene->indexOf(cells[2]), QPoint(1, 0));
+    QCOMPARE(mScene->indexOf(cells[6]), QPoint(0, 1));
+
+    //undo puts every cell back where it was.
+    mScene->undoStack()->undo();
+    QCOMPARE(mScene->rowCount(), 3);
+    for(int i = 0; i < cells.count(); ++i)
+        QCOMPARE(mScene->indexOf(cells[i]), QPoint(i % 3, i / 3));
+}
+
+void TestCell::paste()
+{
+    Cell* c = addCell("dc", QPointF(20, 40));
+    Indicator* i = new Indicator();
+    mScene->addItem(i);
+    i->setText("1");
+    i->setPos(100, 40);
+
+    c->setSelected(true);
+    i->setSelected(true);
+    mScene->copy();
+    mScene->paste();
+
+    //the copies are added as one step, all moved by the same paste offset.
+    QCOMPARE(mScene->undoStack()->count(), 1);
+    QList<QGraphicsItem*> pasted = mScene->selectedItems();
+    QCOMPARE(pasted.count(), 2);
+
+    QGraphicsItem* cell = 0;
+    QPointer<Indicator> indicator;
+    foreach(QGraphicsItem* item, pasted) {
+        QVERIFY(item != c && item != i);
+        QVERIFY(item->scene() == mScene);
+        if(item->type() == Cell::Type)
+            cell = item;
+        else
+            indicator = qgraphicsitem_cast<Indicator*>(item);
+    }
+    QVERIFY(cell);
+    QVERIFY(indicator);
+    QPointF offset = cell->pos() - c->pos();
+    QCOMPARE(indicator->scenePos() - i->scenePos(), offset);
+
+    mScene->undoStack()->undo();
+    foreach(QGraphicsItem* item, pasted)
+        QVERIFY(!item->scene());
+
+    mScene->undoStack()->redo();
+    foreach(QGraphicsItem* item, pasted)
+        QVERIFY(item->scene() == mScene);
+    QCOMPARE(cell->pos(), c->pos() + offset);
+
+    //the items of an undone paste are deleted with the command.
+    mScene->undoStack()->undo();
+    mScene->undoStack()->clear();
+    QVERIFY(indicator.isNull());
+}
+
+void TestCell::pasteCounts()
+{
+    Cell* c = addCell("dc");
+    c->setColor(QColor(Qt::red));
+    c->setBgColor(QColor(Qt::blue));
+    QCoreApplication::processEvents();
+
+    QSignalSpy stitches(mScene, SIGNAL(stitchesChanged(QMap<QString,int>)));
+    QSignalSpy colors(mScene, SIGNAL(colorsChanged(QMap<QString,int>)));
+    c->setSelected(true);
+    mScene->copy();
+    mScene->paste();
+    QCoreApplication::processEvents();
+
+    //pasted cells are counted like any other cell put in the chart.
+    CellCounts stitchCounts, colorCounts;
+    stitchCounts.insert("dc", 1);
+    colorCounts.insert(QColor(Qt::red).name(), 1);
+    colorCounts.insert(QColor(Qt::blue).name(), 1);
+    QCOMPARE(stitches.count(), 1);
+    QCOMPARE(stitches.last().first().value<CellCounts>(), stitchCounts);
+    QCOMPARE(colors.count(), 1);
+    QCOMPARE(colors.last().first().value<CellCounts>(), colorCounts);
+
+    //and counted out again when the paste is undone.
+    mScene->undoStack()->undo();
+    QCoreApplication::processEvents();
+    stitchCounts["dc"] = -1;
+    QCOMPARE(stitches.count(), 2);
+    QCOMPARE(stitches.last().first().value<CellCounts>(), stitchCounts);
+}
+
+void TestCell::replicateLine()
+{
+    Cell* a = addCell("ch");
+    addCell("ch", QPointF(100, 0));
+
+    //in a line, each copy one step further along.
+    a->setSelected(true);
+    mScene->replicate(3, 0, QPointF(50, 10));
+    QCOMPARE(mScene->undoStack()->count(), 1);
+    QCOMPARE(mScene->selectedItems().count(), 3);
+    QList<QGraphicsItem*> copies = mScene->selectedItems();
+    QList<QPointF> positions;
+    foreach(QGraphicsItem* item, copies)
+        positions.append(item->pos());
+    QVERIFY(positions.contains(QPointF(50, 10)));
+    QVERIFY(positions.contains(QPointF(150, 30)));
+
+    mScene->undoStack()->undo();
+    foreach(QGraphicsItem* item, copies)
+        QVERIFY(!item->scene());
+}
+
+void TestCell::replicateTurn()
+{
+    Cell* a = addCell("ch");
+    Cell* b = addCell("ch", QPointF(100, 0));
+
+    //without a chart center a half turn swaps the places of the two stitches.
+    a->setSelected(true);
+    b->setSelected(true);
+    mScene->replicate(1, 180, QPointF(0, 0));
+    QCOMPARE(mScene->selectedItems().count(), 2);
+    foreach(QGraphicsItem* item, mScene->selectedItems()) {
+        QCOMPARE(ChartItemTools::getRotation(item), 180.0);
+        QPoint center = item->sceneBoundingRect().center().toPoint();
+        QVERIFY(center == a->sceneBoundingRect().center().toPoint()
+                || center == b->sceneBoundingRect().center().toPoint());
+    }
+}
+
+void TestCell::replicateLayer()
+{
+    Cell* a = addCell("ch");
+    mScene->addLayer("Motif", 1000);
+    a->setLayer(1000);
+    QVERIFY(mScene->getCurrentLayer()->uid() != 1000);
+
+    //the copies stay on the layer of the item they're copied from.
+    a->setSelected(true);
+    mScene->replicate(2, 0, QPointF(0, 20));
+    QCOMPARE(mScene->selectedItems().count(), 2);
+    foreach(QGraphicsItem* item, mScene->selectedItems())
+        QCOMPARE(qgraphicsitem_cast<Cell*>(item)->layer(), 1000u);
+}
+
+void TestCell::layerCacheBands()
+{
+    QGraphicsView view(mScene);
+    QGraphicsView preview(mScene);
+    mScene->setLayerCacheView(&view);
+    unsigned int current = mScene->getCurrentLayer()->uid();
+
+    mScene->addLayer("Motif", 1000);
+    Cell* cached = addCell("ch");
+    cached->setLayer(1000);
+    Cell* live = addCell("ch");
+    Cell* below = addCell("ch");
+    below->setZValue(-2);
+    Indicator* indicator = new Indicator();
+    mScene->addItem(indicator);
+    indicator->setLayer(1000);
+    mScene->spatialIndex();
+
+    //only the view keeping the cache leaves the cached cells out, other views and exports draw them.
+    QVERIFY(Scene::isDrawnFromLayerCache(cached, 1000, view.viewport()));
+    QVERIFY(!Scene::isDrawnFromLayerCache(cached, 1000, preview.viewport()));
+    QVERIFY(!Scene::isDrawnFromLayerCache(cached, 1000, 0));
+    QVERIFY(!Scene::isDrawnFromLayerCache(live, current, view.viewport()));
+
+    //indicators stay on top of the cache, items below the cells are drawn underneath it.
+    QVERIFY(!Scene::isDrawnFromLayerCache(indicator, 1000, view.viewport()));
+    QVERIFY(Scene::isDrawnFromLayerCache(below, current, view.viewport()));
+    QVERIFY(!Scene::isDrawnFromLayerCache(below, current, preview.viewport()));
+
+    //bringing it up to the cells takes it back out of the background.
+    below->setZValue(10);
+    mScene->spatialIndex();
+    QVERIFY(!Scene::isDrawnFromLayerCache(below, current, view.viewport()));
+}
+
 void TestCell::setBgColor()
 {
 
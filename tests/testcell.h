@@ -30,11 +30,19 @@
 
 #include "../src/cell.h"
 
+class Scene;
+
+//the changes sent with Scene::stitchesChanged() and colorsChanged().
+typedef QMap<QString, int> CellCounts;
+Q_DECLARE_METATYPE(CellCounts)
+
 class TestCell : public QObject
 {
     Q_OBJECT
 private slots:
      void initTestCase();
+     void init();
+     void cleanup();
 
      void setCellValues();
      void setCellValues_data();
@@ -45,9 +53,29 @@ private slots:
      void setScale();
      void setScale_data();
 
+     void chartTransform();
+     void chartTransform_data();
+
      void setBgColor();
      void setBgColor_data();
 
+     void cellColorIndex();
+     void cellColorIndex_data();
+     void cellStitchIndex();
+     void alternateColor();
+     void bulkProperties();
+     void bulkProperties_data();
+     void bulkStitch();
+     void bulkDelete();
+     void mergeEdits();
+     void removeRows();
+     void paste();
+     void pasteCounts();
+     void replicateLine();
+     void replicateTurn();
+     void replicateLayer();
+     void layerCacheBands();
+
      void setAllProperties();
      void setAllProperties_data();
 
@@ -55,6 +83,8 @@ private slots:
 
 private:
      int i;
+     //a new scene for each test function, see init().
+     Scene* mScene;
      //Cell* mCell;
 
      //QGraphicsScene* scene;
@@ -62,6 +92,8 @@ private:
      void saveScene(QGraphicsScene *scene, QSizeF size, QString fileName);
      void saveSceneSvg(QGraphicsScene *scene, QSizeF size, QString fileName);
      QString hashFile(QString fileName);
+
+     Cell* addCell(const QString& stitch = "ch", const QPointF& pos = QPointF());
 };
 
 #endif // TESTCELL_H
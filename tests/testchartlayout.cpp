@@ -0,0 +1,54 @@
+/****************************************************************************\
+ Copyright (c) 2010-2014 Stitch Works Software
+ Brian C. Milco <bcmilco@gmail.com>
+
+ This file is part of Crochet Charts.
+
+ Crochet Charts is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ Crochet Charts is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with Crochet Charts. If not, see <http://www.gnu.org/licenses/>.
+
+ \****************************************************************************/
+#include "testchartlayout.h"
+#include "../src/scene.h"
+#include "../src/cell.h"
+
+void TestChartLayout::rounds()
+{
+    ChartLayout rounds = ChartLayout::rounds(3, 8, 4, 32, QSizeF(32, 64));
+    QCOMPARE(rounds.rowCount(), 3);
+    QCOMPARE(rounds.count(), 8 + 12 + 16);
+    QCOMPARE(rounds.rowStart(2), 20);
+    QCOMPARE(rounds.rowLength(2), 16);
+    //the first stitch of a round is right of the center standing on its circle.
+    QCOMPARE(rounds.pos(0), QPointF(48, -32));
+    QCOMPARE(rounds.angle(0), 90.0);
+    QCOMPARE(rounds.angle(2), 180.0);
+}
+
+void TestChartLayout::rows()
+{
+    ChartLayout rows = ChartLayout::rows(2, 3, QSizeF(32, 64), QSizeF(32, 32));
+    QCOMPARE(rows.count(), 6);
+    QCOMPARE(rows.pos(0), QPointF(192, 64));
+    QCOMPARE(rows.pos(5), QPointF(64, 128));
+}
+
+void TestChartLayout::roundsChart()
+{
+    Scene scene;
+    scene.createRoundsChart(3, 8, "ch", QSizeF(32, 64), 4);
+    QCOMPARE(scene.rowCount(), 3);
+    QCOMPARE(scene.columnCount(0), 8);
+    QCOMPARE(scene.columnCount(2), 16);
+    QCOMPARE(scene.cell(2, 4)->rotation(), 180.0);
+}
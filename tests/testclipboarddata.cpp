@@ -0,0 +1,96 @@
+/****************************************************************************\
+ Copyright (c) 2010-2014 Stitch Works Software
+ Brian C. Milco <bcmilco@gmail.com>
+
+ This file is part of Crochet Charts.
+
+ Crochet Charts is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ Crochet Charts is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with Crochet Charts. If not, see <http://www.gnu.org/licenses/>.
+
+ \****************************************************************************/
+#include "testclipboarddata.h"
+#include "../src/cell.h"
+#include "../src/itemgroup.h"
+
+void TestClipboardData::initTestCase()
+{
+    ClipboardItem cell;
+    cell.type = Cell::Type;
+    cell.name = "dc";
+    cell.color = QColor(Qt::red).rgba();
+    cell.bgColor = QColor(Qt::white).rgba();
+    cell.pos = QPointF(10, 20);
+    cell.rotation = 45;
+
+    ClipboardItem group;
+    group.type = ItemGroup::Type;
+    group.children.append(cell);
+
+    mItems << cell << group;
+}
+
+void TestClipboardData::decode()
+{
+    ClipboardData data(mItems);
+    QVERIFY(data.hasFormat(ClipboardData::mimeType()));
+
+    //other programs get the items from the stream.
+    QList<ClipboardItem> items = ClipboardData::decode(data.data(ClipboardData::mimeType()));
+    QCOMPARE(items.count(), 2);
+    QCOMPARE(items[0].name, QString("dc"));
+    QCOMPARE(items[0].color, QColor(Qt::red).rgba());
+    QCOMPARE(items[0].pos, QPointF(10, 20));
+    QCOMPARE(items[0].rotation, 45.0);
+    QCOMPARE(items[1].children.count(), 1);
+    QCOMPARE(items[1].children[0].name, QString("dc"));
+}
+
+void TestClipboardData::ownData()
+{
+    //data put on the clipboard by this process is used as it is.
+    ClipboardData data(mItems);
+    QList<ClipboardItem> items = ClipboardData::items(&data);
+    QCOMPARE(items.count(), 2);
+    QCOMPARE(items[0].name, QString("dc"));
+    QCOMPARE(items[1].children.count(), 1);
+}
+
+void TestClipboardData::foreignData()
+{
+    QMimeData data;
+    QVERIFY(ClipboardData::items(&data).isEmpty());
+
+    //data from another process is read from the stream.
+    data.setData(ClipboardData::mimeType(), ClipboardData::encode(mItems));
+    QList<ClipboardItem> items = ClipboardData::items(&data);
+    QCOMPARE(items.count(), 2);
+    QCOMPARE(items[0].name, QString("dc"));
+    QCOMPARE(items[0].pos, QPointF(10, 20));
+}
+
+void TestClipboardData::layer()
+{
+    QList<ClipboardItem> items = mItems;
+    items[0].layer = 5;
+
+    ClipboardData data(items);
+    QCOMPARE(ClipboardData::items(&data).first().layer, 5u);
+
+    //the layer only means something in the chart the items were copied from.
+    QCOMPARE(ClipboardData::decode(ClipboardData::encode(items)).first().layer, 0u);
+}
+
+void TestClipboardData::cleanupTestCase()
+{
+    mItems.clear();
+}
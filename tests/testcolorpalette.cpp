@@ -0,0 +1,265 @@
+/****************************************************************************\
+ Copyright (c) 2010-2014 Stitch Works Software
+ Brian C. Milco <bcmilco@gmail.com>
+
+ This file is part of Crochet Charts.
+
+ Crochet Charts is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ Crochet Charts is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with Crochet Charts. If not, see <http://www.gnu.org/licenses/>.
+
+ \****************************************************************************/
+#include "testcolorpalette.h"
+#include "../src/scene.h"
+#include "../src/cell.h"
+#include "../src/crochetchartcommands.h"
+
+void TestColorPalette::init()
+{
+    mScene = new Scene();
+}
+
+void TestColorPalette::cleanup()
+{
+    delete mScene;
+    mScene = 0;
+}
+
+Cell* TestColorPalette::addCell(const QString& stitch)
+{
+    Cell* c = new Cell();
+    c->setStitch(stitch);
+    mScene->addItem(c);
+    return c;
+}
+
+void TestColorPalette::entries()
+{
+    ColorPalette palette;
+    int red = palette.add(QColor(Qt::red).rgba());
+    QCOMPARE(palette.add(QColor(Qt::red).rgba()), red);
+    int blue = palette.add(QColor(Qt::blue).rgba());
+    QCOMPARE(palette.count(), 2);
+
+    //an entry changed to the color of another one doesn't take over its lookup.
+    palette.setColor(blue, QColor(Qt::red).rgba());
+    QCOMPARE(palette.indexOf(QColor(Qt::red).rgba()), red);
+    QCOMPARE(palette.indexesOf(QColor(Qt::red).rgba()).count(), 2);
+
+    palette.setColor(red, QColor(Qt::green).rgba());
+    QCOMPARE(palette.indexOf(QColor(Qt::red).rgba()), blue);
+    QCOMPARE(palette.indexOf(QColor(Qt::green).rgba()), red);
+}
+
+void TestColorPalette::paletteColor()
+{
+    Cell* c = new Cell();
+    c->setStitch("dc");
+    c->setColor(QColor(Qt::red));
+    c->setBgColor(QColor(Qt::green));
+
+    //the colors move into the scene's palette with the cell.
+    mScene->addItem(c);
+    QCOMPARE(c->color(), QColor(Qt::red));
+    QCOMPARE(c->bgColor(), QColor(Qt::green));
+    QCOMPARE(mScene->cellPalette()->indexOf(QColor(Qt::red).rgba()), c->colorIndex());
+
+    Cell* other = addCell();
+    other->setColor(QColor(Qt::red));
+    QCOMPARE(other->colorIndex(), c->colorIndex());
+
+    mScene->setPaletteColor(c->colorIndex(), QColor(Qt::blue));
+    QCOMPARE(c->color(), QColor(Qt::blue));
+    QCOMPARE(other->color(), QColor(Qt::blue));
+    QCOMPARE(c->bgColor(), QColor(Qt::green));
+
+    mScene->removeItem(c);
+    QCOMPARE(c->color(), QColor(Qt::blue));
+    delete c;
+}
+
+void TestColorPalette::colorUndo()
+{
+    QFETCH(bool, bulk);
+    QFETCH(bool, background);
+
+    Cell* c = addCell();
+    Cell* red = addCell();
+    if(background) {
+        c->setBgColor(QColor(Qt::blue));
+        red->setBgColor(QColor(Qt::red));
+    } else {
+        c->setColor(QColor(Qt::blue));
+        red->setColor(QColor(Qt::red));
+    }
+    int entry = background ? c->bgColorIndex() : c->colorIndex();
+    mScene->undoStack()->push(new SetPaletteColor(mScene, entry, QColor(Qt::red)));
+
+    QUndoCommand* edit = 0;
+    QList<Cell*> cells;
+    cells << c;
+    if(bulk)
+        edit = background ? new SetCellsColor(QList<Cell*>(), cells, QColor(Qt::yellow))
+                          : new SetCellsColor(cells, QList<Cell*>(), QColor(Qt::yellow));
+    else if(background)
+        edit = new SetCellBgColor(c, QColor(Qt::yellow));
+    else
+        edit = new SetCellColor(c, QColor(Qt::yellow));
+
+    //undo puts the cell back on its entry even when another entry has its color.
+    mScene->undoStack()->push(edit);
+    mScene->undoStack()->undo();
+    QCOMPARE(background ? c->bgColorIndex() : c->colorIndex(), entry);
+
+    mScene->undoStack()->undo();
+    QCOMPARE(background ? c->bgColor() : c->color(), QColor(Qt::blue));
+    QCOMPARE(background ? red->bgColor() : red->color(), QColor(Qt::red));
+}
+
+void TestColorPalette::colorUndo_data()
+{
+    QTest::addColumn<bool>("bulk");
+    QTest::addColumn<bool>("background");
+
+    QTest::newRow("color")           << false << false;
+    QTest::newRow("bgColor")         << false << true;
+    QTest::newRow("cells color")     << true << false;
+    QTest::newRow("cells bgColor")   << true << true;
+}
+
+void TestColorPalette::colorways()
+{
+    Cell* c = addCell("dc");
+    c->setColor(QColor(Qt::red));
+
+    ColorPalette* palette = mScene->cellPalette();
+    int colorway = mScene->addColorway("Blue");
+    QCOMPARE(palette->colorwayCount(), 2);
+
+    //a new colorway starts with the current colors.
+    mScene->setCurrentColorway(colorway);
+    QCOMPARE(c->color(), QColor(Qt::red));
+
+    mScene->setPaletteColor(c->colorIndex(), QColor(Qt::blue));
+    QCOMPARE(c->color(), QColor(Qt::blue));
+
+    mScene->setCurrentColorway(0);
+    QCOMPARE(c->color(), QColor(Qt::red));
+    QCOMPARE(palette->colorwayColor(colorway, c->colorIndex()), QColor(Qt::blue).rgba());
+
+    //removing the current colorway goes back to the first one.
+    mScene->setCurrentColorway(colorway);
+    mScene->removeColorway(colorway);
+    QCOMPARE(palette->colorwayCount(), 1);
+    QCOMPARE(palette->currentColorway(), 0);
+    QCOMPARE(c->color(), QColor(Qt::red));
+}
+
+void TestColorPalette::colorwayReadd()
+{
+    Cell* c = addCell("dc");
+    c->setColor(QColor(Qt::red));
+    int colorway = mScene->addColorway("Blue");
+    mScene->setCurrentColorway(colorway);
+    mScene->setPaletteColor(c->colorIndex(), QColor(Qt::blue));
+
+    //a cell taken out and put back keeps its colors in every colorway.
+    mScene->removeItem(c);
+    QCOMPARE(c->color(), QColor(Qt::blue));
+    mScene->setCurrentColorway(0);
+    mScene->addItem(c);
+    QCOMPARE(c->color(), QColor(Qt::red));
+
+    mScene->setCurrentColorway(colorway);
+    QCOMPARE(c->color(), QColor(Qt::blue));
+}
+
+void TestColorPalette::colorwayUndo()
+{
+    Cell* c = addCell("dc");
+    c->setColor(QColor(Qt::red));
+    ColorPalette* palette = mScene->cellPalette();
+    int colorway = mScene->addColorway("Blue");
+    mScene->setCurrentColorway(colorway);
+    mScene->setPaletteColor(c->colorIndex(), QColor(Qt::blue));
+
+    //undo goes back to the colorway that was edited.
+    mScene->undoStack()->push(new SetPaletteColor(mScene, c->colorIndex(), QColor(Qt::green)));
+    mScene->setCurrentColorway(0);
+    mScene->undoStack()->undo();
+    QCOMPARE(c->color(), QColor(Qt::red));
+    QCOMPARE(palette->colorwayColor(colorway, c->colorIndex()), QColor(Qt::blue).rgba());
+}
+
+void TestColorPalette::colorwayIds()
+{
+    Cell* c = addCell("dc");
+    c->setColor(QColor(Qt::red));
+    ColorPalette* palette = mScene->cellPalette();
+    mScene->addColorway("First");
+    int second = palette->colorwayId(mScene->addColorway("Second"));
+    mScene->setCurrentColorway(2);
+    mScene->undoStack()->push(new SetPaletteColor(mScene, c->colorIndex(), QColor(Qt::blue)));
+
+    //the edit is undone in its own colorway after the one before it is gone.
+    mScene->removeColorway(1);
+    QCOMPARE(palette->findColorway(second), 1);
+    mScene->undoStack()->undo();
+    QCOMPARE(palette->colorwayColor(1, c->colorIndex()), QColor(Qt::red).rgba());
+    QCOMPARE(palette->colorwayColor(0, c->colorIndex()), QColor(Qt::red).rgba());
+    QCOMPARE(c->color(), QColor(Qt::red));
+}
+
+void TestColorPalette::colorwayCommands()
+{
+    Cell* c = addCell("dc");
+    c->setColor(QColor(Qt::red));
+    ColorPalette* palette = mScene->cellPalette();
+    QUndoStack* stack = mScene->undoStack();
+
+    mScene->addColorwayUndoable("First");
+    mScene->addColorwayUndoable("Second");
+    QCOMPARE(palette->colorwayCount(), 3);
+    QCOMPARE(palette->currentColorway(), 2);
+    int second = palette->colorwayId(2);
+
+    stack->push(new SetPaletteColor(mScene, c->colorIndex(), QColor(Qt::blue)));
+    mScene->setColorwayNameUndoable(2, "Blue");
+    mScene->removeColorwayUndoable(1);
+    QCOMPARE(stack->count(), 5);
+    QCOMPARE(palette->colorwayName(1), QString("Blue"));
+    QCOMPARE(c->color(), QColor(Qt::blue));
+
+    //the removed colorway is put back in its place before the edit is undone.
+    stack->undo();
+    QCOMPARE(palette->colorwayCount(), 3);
+    QCOMPARE(palette->colorwayName(1), QString("First"));
+    QCOMPARE(palette->currentColorway(), 2);
+    stack->undo();
+    QCOMPARE(palette->colorwayName(2), QString("Second"));
+    stack->undo();
+    QCOMPARE(c->color(), QColor(Qt::red));
+
+    stack->undo();
+    stack->undo();
+    QCOMPARE(palette->colorwayCount(), 1);
+    QCOMPARE(palette->currentColorway(), 0);
+
+    //redone colorways keep their ids so the later commands find them.
+    for(int i = 0; i < 5; ++i)
+        stack->redo();
+    QCOMPARE(palette->colorwayCount(), 2);
+    QCOMPARE(palette->findColorway(second), 1);
+    QCOMPARE(palette->colorwayName(1), QString("Blue"));
+    QCOMPARE(palette->currentColorway(), 1);
+    QCOMPARE(c->color(), QColor(Qt::blue));
+}
@@ -0,0 +1,58 @@
+/****************************************************************************\
+ Copyright (c) 2010-2014 Stitch Works Software
+ Brian C. Milco <bcmilco@gmail.com>
+
+ This file is part of Crochet Charts.
+
+ Crochet Charts is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ Crochet Charts is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with Crochet Charts. If not, see <http://www.gnu.org/licenses/>.
+
+ \****************************************************************************/
+#ifndef TESTCOLORPALETTE_H
+#define TESTCOLORPALETTE_H
+
+#include <QtTest/QTest>
+#include <QDebug>
+#include <QObject>
+
+#include "../src/colorpalette.h"
+
+class Scene;
+class Cell;
+
+class TestColorPalette : public QObject
+{
+    Q_OBJECT
+private slots:
+    void init();
+    void cleanup();
+
+    void entries();
+    void paletteColor();
+    void colorUndo();
+    void colorUndo_data();
+
+    void colorways();
+    void colorwayReadd();
+    void colorwayUndo();
+    void colorwayIds();
+    void colorwayCommands();
+
+private:
+    Cell* addCell(const QString& stitch = "ch");
+
+    //a new scene for each test function.
+    Scene* mScene;
+};
+
+#endif // TESTCOLORPALETTE_H
@@ -0,0 +1,101 @@
+/****************************************************************************\
+ Copyright (c) 2010-2014 Stitch Works Software
+ Brian C. Milco <bcmilco@gmail.com>
+
+ This file is part of Crochet Charts.
+
+ Crochet Charts is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ Crochet Charts is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with Crochet Charts. If not, see <http://www.gnu.org/licenses/>.
+
+ \****************************************************************************/
+#include "testsnapengine.h"
+#include "../src/scene.h"
+#include "../src/cell.h"
+
+void TestSnapEngine::init()
+{
+    mScene = new Scene();
+}
+
+void TestSnapEngine::cleanup()
+{
+    delete mScene;
+    mScene = 0;
+}
+
+void TestSnapEngine::setGuidelines(const QString& type, int cellSize)
+{
+    Guidelines g;
+    g.setType(type);
+    g.setRows(3);
+    g.setColumns(4);
+    g.setCellWidth(cellSize);
+    g.setCellHeight(cellSize);
+    mScene->propertiesUpdate("Guidelines", QVariant::fromValue(g));
+}
+
+void TestSnapEngine::snap()
+{
+    QFETCH(QString, type);
+    QFETCH(int, cellSize);
+    QFETCH(QPointF, pos);
+    QFETCH(QPointF, expected);
+
+    setGuidelines(type, cellSize);
+    QCOMPARE(mScene->snapPositionToGrid(pos).toPoint(), expected.toPoint());
+}
+
+void TestSnapEngine::snap_data()
+{
+    QTest::addColumn<QString>("type");
+    QTest::addColumn<int>("cellSize");
+    QTest::addColumn<QPointF>("pos");
+    QTest::addColumn<QPointF>("expected");
+
+    QTest::newRow("round")       << "Rounds" << 50 << QPointF(0, 52) << QPointF(0, 50);
+    QTest::newRow("round turn")  << "Rounds" << 50 << QPointF(-70, 3) << QPointF(-50, 0);
+    QTest::newRow("last round")  << "Rounds" << 50 << QPointF(0, 1000) << QPointF(0, 200);
+    QTest::newRow("row")         << "Rows" << 32 << QPointF(50, 17) << QPointF(64, 32);
+}
+
+void TestSnapEngine::batch()
+{
+    setGuidelines("Rows", 32);
+
+    //the batch gives the same positions as snapping one at a time.
+    QVector<QPointF> positions;
+    positions << QPointF(50, 17) << QPointF(-20, 500) << QPointF(100, 70);
+    QVector<QPointF> snapped = positions;
+    mScene->snapPositionsToGrid(snapped);
+    QCOMPARE(snapped[0], QPointF(64, 32));
+    for(int i = 0; i < positions.count(); ++i)
+        QCOMPARE(snapped[i], mScene->snapPositionToGrid(positions[i]));
+}
+
+void TestSnapEngine::stitches()
+{
+    setGuidelines("None", 32);
+
+    //without guidelines stitches line up with the stitches next to them.
+    Cell* a = new Cell();
+    Cell* b = new Cell();
+    a->setStitch("ch");
+    b->setStitch("ch");
+    mScene->addItem(a);
+    mScene->addItem(b);
+    a->setPos(0, 0);
+    b->setPos(a->sceneBoundingRect().width() + 10, 5);
+
+    mScene->snapItemsToGrid(QList<QGraphicsItem*>() << b);
+    QCOMPARE(b->pos(), QPointF(a->sceneBoundingRect().width() + 10, 0));
+}
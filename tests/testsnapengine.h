@@ -1,5 +1,5 @@
 /****************************************************************************\
- Copyright (c) 2011-2014 Stitch Works Software
+ Copyright (c) 2010-2014 Stitch Works Software
  Brian C. Milco <bcmilco@gmail.com>
 
  This file is part of Crochet Charts.
@@ -18,24 +18,34 @@
  along with Crochet Charts. If not, see <http://www.gnu.org/licenses/>.
 
  \****************************************************************************/
-#ifndef GUIDELINE_H
-#define GUIDELINE_H
+#ifndef TESTSNAPENGINE_H
+#define TESTSNAPENGINE_H
 
-#include <QGraphicsEllipseItem>
+#include <QtTest/QTest>
+#include <QDebug>
+#include <QObject>
 
-class Guideline : public QGraphicsEllipseItem
+#include "../src/snapengine.h"
+
+class Scene;
+
+class TestSnapEngine : public QObject
 {
-public:
-    explicit Guideline(const QRectF &rect, QGraphicsItem *parent = 0, QGraphicsScene *scene = 0);
+    Q_OBJECT
+private slots:
+    void init();
+    void cleanup();
 
-    enum { Type = UserType + 5 };
+    void snap();
+    void snap_data();
+    void batch();
+    void stitches();
 
-    int type () const { return Guideline::Type; }
+private:
+    //a new scene for each test function.
+    Scene* mScene;
 
-protected:
-    void mousePressEvent(QGraphicsSceneMouseEvent *event);
-    void mouseMoveEvent(QGraphicsSceneMouseEvent *event);
-    void mouseReleaseEvent(QGraphicsSceneMouseEvent *event);
+    void setGuidelines(const QString& type, int cellSize);
 };
 
-#endif // GUIDELINE_H
+#endif // TESTSNAPENGINE_H
@@ -0,0 +1,167 @@
+/****************************************************************************\
+ Copyright (c) 2010-2014 Stitch Works Software
+ Brian C. Milco <bcmilco@gmail.com>
+
+ This file is part of Crochet Charts.
+
+ Crochet Charts is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ Crochet Charts is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with Crochet Charts. If not, see <http://www.gnu.org/licenses/>.
+
+ \****************************************************************************/
+#include "testspatialindex.h"
+
+#include <QGraphicsRectItem>
+#include <QGraphicsEllipseItem>
+
+void TestSpatialIndex::initTestCase()
+{
+    //a row of 32x32 items 100 apart, the last one is on top of the first one.
+    for(int i = 0; i < 10; ++i)
+        mItems.append(new QGraphicsRectItem(i * 100, 0, 32, 32));
+    mItems.append(new QGraphicsRectItem(10, 10, 32, 32));
+    mItems.last()->setZValue(1);
+}
+
+void TestSpatialIndex::pointQuery()
+{
+    SpatialIndex index;
+    foreach(QGraphicsRectItem* item, mItems)
+        index.insert(item, item->sceneBoundingRect(), 0);
+
+    QCOMPARE(index.count(), mItems.count());
+    QCOMPARE(index.itemAt(QPointF(250, 10)), (QGraphicsItem*)0);
+    QCOMPARE(index.itemAt(QPointF(310, 10)), (QGraphicsItem*)mItems.at(3));
+
+    //the overlapping item has a higher z value and is returned first.
+    QList<QGraphicsItem*> found = index.items(QPointF(20, 20));
+    QCOMPARE(found.count(), 2);
+    QCOMPARE(found.first(), (QGraphicsItem*)mItems.last());
+    QCOMPARE(index.itemAt(QPointF(20, 20)), (QGraphicsItem*)mItems.last());
+
+    //unselectable items are skipped when asked to.
+    mItems.last()->setFlag(QGraphicsItem::ItemIsSelectable, false);
+    mItems.first()->setFlag(QGraphicsItem::ItemIsSelectable, true);
+    QCOMPARE(index.itemAt(QPointF(20, 20), SpatialIndex::AllLayers, true), (QGraphicsItem*)mItems.first());
+    mItems.first()->setFlag(QGraphicsItem::ItemIsSelectable, false);
+}
+
+void TestSpatialIndex::pointQueryShape()
+{
+    //two round glyphs whose rects overlap in the corners, the second one on top.
+    QGraphicsEllipseItem below(0, 0, 32, 32);
+    QGraphicsEllipseItem above(24, 24, 32, 32);
+    above.setZValue(1);
+
+    SpatialIndex index;
+    index.insert(&below, below.sceneBoundingRect(), 0);
+    index.insert(&above, above.sceneBoundingRect(), 0);
+
+    //the corner of the top rect is outside of its glyph, the glyph below is hit.
+    QCOMPARE(index.itemAt(QPointF(26, 26)), (QGraphicsItem*)&below);
+    QCOMPARE(index.itemAt(QPointF(40, 40)), (QGraphicsItem*)&above);
+    QCOMPARE(index.itemAt(QPointF(28, 28)), (QGraphicsItem*)0);
+}
+
+void TestSpatialIndex::rectQuery()
+{
+    SpatialIndex index;
+    foreach(QGraphicsRectItem* item, mItems)
+        index.insert(item, item->sceneBoundingRect(), 0);
+
+    QCOMPARE(index.items(QRectF(150, 0, 300, 10)).count(), 3);
+    QCOMPARE(index.items(QRectF(-1000, -1000, 5000, 5000)).count(), mItems.count());
+
+    QPainterPath path;
+    path.addRect(QRectF(590, 5, 20, 20));
+    QList<QGraphicsItem*> found = index.items(path, Qt::IntersectsItemShape);
+    QCOMPARE(found.count(), 1);
+    QCOMPARE(found.first(), (QGraphicsItem*)mItems.at(6));
+}
+
+void TestSpatialIndex::layers()
+{
+    SpatialIndex index;
+    for(int i = 0; i < 10; ++i)
+        index.insert(mItems.at(i), mItems.at(i)->sceneBoundingRect(), i % 2);
+    index.insert(mItems.last(), mItems.last()->sceneBoundingRect(), SpatialIndex::NoLayer);
+
+    QCOMPARE(index.items(QRectF(0, 0, 1000, 32), 0).count(), 6);
+    QCOMPARE(index.items(QRectF(0, 0, 1000, 32), 1).count(), 6);
+    QCOMPARE(index.items(QRectF(0, 0, 1000, 32)).count(), mItems.count());
+    QCOMPARE(index.itemAt(QPointF(110, 10), 0), (QGraphicsItem*)0);
+    QCOMPARE(index.itemAt(QPointF(110, 10), 1), (QGraphicsItem*)mItems.at(1));
+}
+
+void TestSpatialIndex::moveAndRemove()
+{
+    SpatialIndex index;
+    foreach(QGraphicsRectItem* item, mItems)
+        index.insert(item, item->sceneBoundingRect(), 0);
+
+    index.insert(mItems.at(5), QRectF(5000, 5000, 32, 32), 0);
+    QCOMPARE(index.itemAt(QPointF(510, 10)), (QGraphicsItem*)0);
+    QCOMPARE(index.itemAt(QPointF(5010, 5010)), (QGraphicsItem*)mItems.at(5));
+
+    index.remove(mItems.at(5));
+    QCOMPARE(index.itemAt(QPointF(5010, 5010)), (QGraphicsItem*)0);
+    QVERIFY(!index.contains(mItems.at(5)));
+
+    //large items are found without being in the grid.
+    index.insert(mItems.at(5), QRectF(-10000, -10000, 20000, 20000), 0);
+    QCOMPARE(index.items(QPointF(-9000, 9000)).count(), 1);
+}
+
+void TestSpatialIndex::nearest()
+{
+    SpatialIndex index;
+    for(int i = 0; i < 10; ++i)
+        index.insert(mItems.at(i), mItems.at(i)->sceneBoundingRect(), 0);
+
+    QList<QGraphicsItem*> found = index.nearest(QPointF(720, 16), 3);
+    QCOMPARE(found.count(), 3);
+    QCOMPARE(found.at(0), (QGraphicsItem*)mItems.at(7));
+    QCOMPARE(found.at(1), (QGraphicsItem*)mItems.at(8));
+    QCOMPARE(found.at(2), (QGraphicsItem*)mItems.at(6));
+
+    QCOMPARE(index.nearest(QPointF(-5000, 0), 20).count(), 10);
+}
+
+void TestSpatialIndex::bounds()
+{
+    SpatialIndex index;
+    QCOMPARE(index.bounds(), QRectF());
+
+    index.insert(mItems.at(0), QRectF(0, 0, 10, 10), 0);
+    index.insert(mItems.at(1), QRectF(100, 0, 10, 10), 0);
+    index.insert(mItems.at(2), QRectF(50, 50, 10, 10), 1);
+    QCOMPARE(index.bounds(), QRectF(0, 0, 110, 60));
+
+    //moving the item on the edge inwards shrinks the bounds.
+    index.insert(mItems.at(2), QRectF(50, 20, 10, 10), 1);
+    QCOMPARE(index.bounds(), QRectF(0, 0, 110, 30));
+
+    index.insert(mItems.at(0), QRectF(-50, 0, 10, 10), 0);
+    QCOMPARE(index.bounds(), QRectF(-50, 0, 160, 30));
+
+    index.remove(mItems.at(1));
+    QCOMPARE(index.bounds(), QRectF(-50, 0, 110, 30));
+
+    index.clear();
+    QCOMPARE(index.bounds(), QRectF());
+}
+
+void TestSpatialIndex::cleanupTestCase()
+{
+    qDeleteAll(mItems);
+    mItems.clear();
+}
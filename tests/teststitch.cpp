@@ -19,6 +19,8 @@
 
  \****************************************************************************/
 #include "teststitch.h"
+#include "../src/stitchglyph.h"
+#include "../src/builtinglyphs.h"
 
 #include <QPainter>
 #include <QPixmap>
@@ -164,6 +166,57 @@ void TestStitch::stitchRender_data()
 //TODO: render other stitches esp tall and wide stitches.
 }
 
+void TestStitch::stitchGlyph()
+{
+    QFETCH(QString, stitchFile);
+    QFETCH(qreal, width);
+    QFETCH(qreal, height);
+
+    mS->setFile(stitchFile);
+
+    StitchGlyph *glyph = mS->glyph();
+    QVERIFY(glyph != 0);
+
+    QCOMPARE(glyph->boundingRect(), QRectF(0, 0, width, height));
+    QVERIFY(!glyph->outline().isEmpty());
+
+    //the outline follows the drawn stitch, not the corners of the bounding rect.
+    QVERIFY(!glyph->outline().contains(QPointF(0.5, 0.5)));
+}
+
+void TestStitch::stitchGlyph_data()
+{
+    QTest::addColumn<QString>("stitchFile");
+    QTest::addColumn<qreal>("width");
+    QTest::addColumn<qreal>("height");
+
+    QTest::newRow("ch")     << "../stitches/ch.svg" << 32.0 << 16.0;
+    QTest::newRow("hdc")    << "../stitches/hdc.svg" << 32.0 << 64.0;
+}
+
+void TestStitch::builtInGlyph()
+{
+    const BuiltInGlyph *builtIn = findBuiltInGlyph(":/stitches/ch.svg");
+    QVERIFY(builtIn != 0);
+    QVERIFY(findBuiltInGlyph("../stitches/ch.svg") == 0);
+
+    Stitch s;
+    s.setFile(":/stitches/ch.svg");
+    QVERIFY(s.isSvg());
+    QVERIFY(s.mRenderers.isEmpty());
+    QVERIFY(s.width() == 32.0);
+    QVERIFY(s.height() == 16.0);
+
+    //the compiled glyph should match the one parsed from the svg.
+    StitchGlyph parsed;
+    QFile f("../stitches/ch.svg");
+    QVERIFY(f.open(QIODevice::ReadOnly));
+    QVERIFY(parsed.load(f.readAll()));
+
+    QCOMPARE(s.glyph()->elements().count(), parsed.elements().count());
+    QCOMPARE(s.glyph()->boundingRect(), parsed.boundingRect());
+}
+
 void TestStitch::cleanupTestCase()
 {
 }
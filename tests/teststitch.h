@@ -35,6 +35,11 @@ private slots:
     void stitchSetup();
     void stitchRender();
     void stitchRender_data();
+
+    void stitchGlyph();
+    void stitchGlyph_data();
+
+    void builtInGlyph();
     void cleanupTestCase();
 
 private:
@@ -0,0 +1,109 @@
+/****************************************************************************\
+ Copyright (c) 2010-2014 Stitch Works Software
+ Brian C. Milco <bcmilco@gmail.com>
+
+ This file is part of Crochet Charts.
+
+ Crochet Charts is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ Crochet Charts is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with Crochet Charts. If not, see <http://www.gnu.org/licenses/>.
+
+ \****************************************************************************/
+#include "testundomemory.h"
+#include "../src/scene.h"
+#include "../src/cell.h"
+#include "../src/crochetchartcommands.h"
+
+void TestUndoMemory::init()
+{
+    mScene = new Scene();
+    mFirst = new Cell();
+    mSecond = new Cell();
+    mScene->addItem(mFirst);
+    mScene->addItem(mSecond);
+}
+
+void TestUndoMemory::cleanup()
+{
+    delete mScene;
+    mScene = 0;
+}
+
+void TestUndoMemory::move(QGraphicsItem* item, const QPointF& pos)
+{
+    mScene->undoStack()->push(new SetItemsCoordinates(QList<QGraphicsItem*>() << item,
+                                                      QVector<QPointF>() << pos));
+}
+
+void TestUndoMemory::usage()
+{
+    UndoMemory *memory = UndoMemory::forStack(mScene->undoStack());
+    QVERIFY(memory);
+    memory->setBudget(1024 * 1024);
+
+    //the commands are measured as they're pushed and stay in memory within the budget.
+    move(mFirst, QPointF(10, 0));
+    move(mSecond, QPointF(20, 0));
+    QVERIFY(memory->memoryUsage() > 0);
+    QCOMPARE(memory->spilledSize(), qint64(0));
+}
+
+void TestUndoMemory::spill()
+{
+    QUndoStack *stack = mScene->undoStack();
+    UndoMemory *memory = UndoMemory::forStack(stack);
+    QVERIFY(memory);
+    //spill everything but the next undo and redo.
+    memory->setBudget(1);
+
+    //moves of other items aren't merged.
+    move(mFirst, QPointF(10, 0));
+    move(mSecond, QPointF(20, 0));
+    move(mFirst, QPointF(30, 0));
+    QVERIFY(memory->spilledSize() > 0);
+
+    //spilled commands are read back when they're needed.
+    for(int i = 0; i < 3; ++i)
+        stack->undo();
+    QCOMPARE(mFirst->pos(), QPointF(0, 0));
+    QCOMPARE(mSecond->pos(), QPointF(0, 0));
+
+    for(int i = 0; i < 3; ++i)
+        stack->redo();
+    QCOMPARE(mFirst->pos(), QPointF(30, 0));
+    QCOMPARE(mSecond->pos(), QPointF(20, 0));
+}
+
+void TestUndoMemory::mergeAfterSpill()
+{
+    QUndoStack *stack = mScene->undoStack();
+    UndoMemory *memory = UndoMemory::forStack(stack);
+    QVERIFY(memory);
+    memory->setBudget(1);
+
+    move(mFirst, QPointF(10, 0));
+    move(mSecond, QPointF(20, 0));
+    move(mFirst, QPointF(30, 0));
+
+    //a spilled command that takes in a merge is written out again.
+    stack->undo();
+    stack->undo();
+    move(mFirst, QPointF(40, 0));
+    QCOMPARE(stack->count(), 1);
+    move(mSecond, QPointF(50, 0));
+    move(mFirst, QPointF(60, 0));
+
+    for(int i = 0; i < 3; ++i)
+        stack->undo();
+    stack->redo();
+    QCOMPARE(mFirst->pos(), QPointF(40, 0));
+}